@@ -0,0 +1,41 @@
+/**
+ * @file bench_card.c
+ * @brief Abre/fecha o cartão dos benchmarks de host (ver bench_card.h).
+ */
+
+#include "bench_card.h"
+#include "ff.h"
+#include "diskio.h"
+#include "hw_config.h"
+#include "pico/time.h"
+#ifdef BENCH_EMU
+#include "sd_emu.h"
+#endif
+
+sd_card_t *bench_card_open(uint32_t size_mib, const sd_host_faults_t *faults) {
+    sd_card_t *pSD = sd_get_by_num(0);
+#ifdef BENCH_EMU
+    (void)faults;
+    sd_emu_config_t cfg;
+    sd_emu_default_config(&cfg);
+    cfg.sectors = size_mib * 2048;
+    if (!sd_emu_attach(&cfg, pSD->ss_gpio)) return NULL;
+    host_clock_set_virtual(true);
+    sd_init_driver();
+    pSD->m_Status = STA_NOINIT;
+#else
+    if (!sd_host_open(NULL, (uint64_t)size_mib * 1024 * 1024, false)) return NULL;
+    if (faults) sd_host_set_faults(faults);
+#endif
+    return pSD;
+}
+
+void bench_card_close(sd_card_t *pSD) {
+    f_unmount(pSD->pcName);
+    pSD->mounted = false;
+#ifdef BENCH_EMU
+    sd_emu_detach();
+#else
+    sd_host_close();
+#endif
+}
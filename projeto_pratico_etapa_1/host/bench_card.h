@@ -0,0 +1,21 @@
+/**
+ * @file bench_card.h
+ * @brief Cartão usado pelos benchmarks de host.
+ *
+ * Sem BENCH_EMU: imagem em RAM (sd_host_blockdev.c), tempo de relógio e a
+ * latência injetada em faults. Com BENCH_EMU: o driver SPI real sobre o
+ * emulador (sd_emu.c) com o relógio virtual ligado, ou seja, o tempo medido
+ * é o de barramento (bytes / baud) mais as esperas do driver.
+ */
+#ifndef BENCH_CARD_H
+#define BENCH_CARD_H
+
+#include <stdint.h>
+#include "sd_card.h"
+#include "sd_host_blockdev.h"
+
+// Cartão novo e vazio; faults só vale para a imagem em RAM
+sd_card_t *bench_card_open(uint32_t size_mib, const sd_host_faults_t *faults);
+void bench_card_close(sd_card_t *pSD);
+
+#endif // BENCH_CARD_H
@@ -0,0 +1,80 @@
+/**
+ * @file block_bench_host.c
+ * @brief Roda o block_bench (example/tests/block_bench.c) sobre o emulador
+ * de SD, com relógio virtual, varrendo tamanhos de transferência, misturas
+ * de leitura/escrita e clocks de SPI.
+ *
+ * Só existe a versão emulada: a imagem em RAM não tem tempo de ocupado nem de
+ * acesso, que é justamente o que este benchmark separa.
+ *
+ * Uso: block_bench_emu [-n ops] [-k blocos] [-x escrita%] [-b bauds] [-a] [-s MiB]
+ *   -k, -x e -b aceitam listas separadas por vírgula, ex.: -k 1,8,64
+ *   -a usa LBAs aleatórios (padrão: sequencial)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_card.h"
+#include "block_bench.h"
+#include "hardware/spi.h"
+
+#define MAX_LIST 8
+
+static size_t parse_list(const char *arg, uint32_t *out) {
+    size_t n = 0;
+    char *copy = strdup(arg);
+    for (char *tok = strtok(copy, ","); tok && n < MAX_LIST; tok = strtok(NULL, ","))
+        out[n++] = strtoul(tok, NULL, 0);
+    free(copy);
+    return n;
+}
+
+int main(int argc, char *argv[]) {
+    block_bench_params_t params;
+    block_bench_default_params(&params);
+    uint32_t size_mib = 64;
+    uint32_t sizes[MAX_LIST] = {1, 8, 64};
+    size_t n_sizes = 3;
+    uint32_t mixes[MAX_LIST] = {0, 100, 30};
+    size_t n_mixes = 3;
+    uint32_t bauds[MAX_LIST] = {12500000};
+    size_t n_bauds = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:k:x:b:as:")) != -1) {
+        switch (opt) {
+            case 'n': params.ops = strtoul(optarg, NULL, 0); break;
+            case 'k': n_sizes = parse_list(optarg, sizes); break;
+            case 'x': n_mixes = parse_list(optarg, mixes); break;
+            case 'b': n_bauds = parse_list(optarg, bauds); break;
+            case 'a': params.random = true; break;
+            case 's': size_mib = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr,
+                        "Uso: %s [-n ops] [-k blocos] [-x escrita%%] [-b bauds] [-a] [-s MiB]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    sd_card_t *pSD = bench_card_open(size_mib, NULL);
+    if (!pSD) return 1;
+    bool ok = pSD->init(pSD) == 0;
+    for (size_t b = 0; ok && b < n_bauds; b++) {
+        pSD->spi->baud_rate = bauds[b];
+        spi_set_baudrate(pSD->spi->hw_inst, bauds[b]);
+        for (size_t k = 0; ok && k < n_sizes; k++) {
+            for (size_t x = 0; ok && x < n_mixes; x++) {
+                params.blocks = sizes[k];
+                params.write_pct = mixes[x];
+                printf("\nSPI %lu Hz\n", (unsigned long)bauds[b]);
+                ok = block_bench_run(pSD, &params);
+            }
+        }
+    }
+    bench_card_close(pSD);
+    return ok ? 0 : 1;
+}
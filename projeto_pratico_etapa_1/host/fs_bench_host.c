@@ -0,0 +1,88 @@
+/**
+ * @file fs_bench_host.c
+ * @brief Roda o fs_bench (example/tests/fs_bench.c) no host, varrendo
+ * tamanhos de cluster e, no backend emulado, clocks de SPI.
+ *
+ * Dois executáveis saem deste arquivo:
+ *   fs_bench_host  cartão sobre imagem em RAM (sd_host_blockdev.c); tempo de
+ *                  relógio, com a latência por operação de -r/-R/-w/-W
+ *   fs_bench_emu   driver SPI real sobre o emulador (sd_emu.c), com relógio
+ *                  virtual: tempo de barramento e esperas, sem a CPU do host
+ *
+ * Uso: fs_bench_{host,emu} [-n ops] [-l bytes] [-u bytes] [-s MiB]
+ *                          [-c clusters] [-b bauds] [-r|-R|-w|-W us]
+ *   -c e -b aceitam listas separadas por vírgula, ex.: -c 4096,32768
+ *   -b só faz diferença no fs_bench_emu; -r/-R/-w/-W só no fs_bench_host
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_card.h"
+#include "fs_bench.h"
+
+#define MAX_LIST 8
+
+static size_t parse_list(const char *arg, uint32_t *out) {
+    size_t n = 0;
+    char *copy = strdup(arg);
+    for (char *tok = strtok(copy, ","); tok && n < MAX_LIST; tok = strtok(NULL, ","))
+        out[n++] = strtoul(tok, NULL, 0);
+    free(copy);
+    return n;
+}
+
+static sd_host_faults_t faults;
+
+int main(int argc, char *argv[]) {
+    fs_bench_params_t params;
+    fs_bench_default_params(&params);
+    uint32_t size_mib = 64;
+    uint32_t clusters[MAX_LIST] = {4096, 16384, 32768};
+    size_t n_clusters = 3;
+#ifdef BENCH_EMU
+    uint32_t bauds[MAX_LIST] = {6250000, 12500000, 25000000};
+    size_t n_bauds = 3;
+#else
+    uint32_t bauds[MAX_LIST] = {0};
+    size_t n_bauds = 1;
+#endif
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:l:u:s:c:b:r:R:w:W:")) != -1) {
+        switch (opt) {
+            case 'n': params.ops = strtoul(optarg, NULL, 0); break;
+            case 'l': params.record_size = strtoul(optarg, NULL, 0); break;
+            case 'u': params.unlink_size = strtoul(optarg, NULL, 0); break;
+            case 's': size_mib = strtoul(optarg, NULL, 0); break;
+            case 'c': n_clusters = parse_list(optarg, clusters); break;
+            case 'b': n_bauds = parse_list(optarg, bauds); break;
+            case 'r': faults.read_latency_us = strtoul(optarg, NULL, 0); break;
+            case 'R': faults.read_per_block_us = strtoul(optarg, NULL, 0); break;
+            case 'w': faults.write_latency_us = strtoul(optarg, NULL, 0); break;
+            case 'W': faults.write_per_block_us = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr,
+                        "Uso: %s [-n ops] [-l bytes] [-u bytes] [-s MiB] [-c clusters] [-b bauds]\n"
+                        "       [-r us] [-R us] [-w us] [-W us]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    bool ok = true;
+    for (size_t c = 0; ok && c < n_clusters; c++) {
+        for (size_t b = 0; ok && b < n_bauds; b++) {
+            sd_card_t *pSD = bench_card_open(size_mib, &faults);
+            if (!pSD) return 1;
+            params.au_size = clusters[c];
+            params.baud = bauds[b];
+            printf("\n");
+            ok = fs_bench_run(pSD, &params);
+            bench_card_close(pSD);
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+// Stub do hardware/dma.h para o build de host (Linux)
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include "pico/types.h"
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+#endif // HOST_HARDWARE_DMA_H
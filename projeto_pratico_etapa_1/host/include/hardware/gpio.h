@@ -0,0 +1,60 @@
+// Stub do hardware/gpio.h para o build de host (Linux).
+// Os níveis dos pinos ficam numa tabela em memória (ver pico_host.c).
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include "pico/types.h"
+#include "hardware/irq.h"
+
+#define NUM_BANK0_GPIOS 30
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+enum gpio_drive_strength {
+    GPIO_DRIVE_STRENGTH_2MA = 0,
+    GPIO_DRIVE_STRENGTH_4MA = 1,
+    GPIO_DRIVE_STRENGTH_8MA = 2,
+    GPIO_DRIVE_STRENGTH_12MA = 3
+};
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_pull_up(uint gpio);
+void gpio_pull_down(uint gpio);
+void gpio_disable_pulls(uint gpio);
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive);
+
+// Interrupções de GPIO: eventos por pino, como no SDK
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled);
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler);
+uint32_t gpio_get_irq_event_mask(uint gpio);
+void gpio_acknowledge_irq(uint gpio, uint32_t events);
+
+// Chamado a cada gpio_put(); permite que um periférico emulado observe o
+// chip select (ver sd_emu.c)
+extern void (*host_gpio_put_hook)(uint gpio, bool value);
+
+// Só no host: um periférico emulado põe o nível numa entrada (ex.: o pino IRQ
+// do MFRC522). As bordas viram eventos e chamam o handler do pino, se
+// habilitado, como a interrupção IO_IRQ_BANK0 faria.
+void host_gpio_drive(uint gpio, bool value);
+
+#endif // HOST_HARDWARE_GPIO_H
@@ -0,0 +1,16 @@
+// Stub do hardware/irq.h para o build de host (Linux)
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+typedef void (*irq_handler_t)(void);
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define IO_IRQ_BANK0 13
+
+#include <stdbool.h>
+
+// No host não há NVIC: só registra se a interrupção está habilitada
+void irq_set_enabled(unsigned num, bool enabled);
+
+#endif // HOST_HARDWARE_IRQ_H
@@ -0,0 +1,24 @@
+// Stub do hardware/spi.h para o build de host (Linux)
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+#include "pico/types.h"
+
+typedef struct spi_inst spi_inst_t;
+
+// Como no SDK, spi0/spi1 são endereços constantes (usáveis em inicializadores
+// estáticos, como em hw_config.c); no host eles nunca são desreferenciados.
+#define spi0 ((spi_inst_t *)(uintptr_t)0x4003c000u)
+#define spi1 ((spi_inst_t *)(uintptr_t)0x40040000u)
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+void spi_deinit(spi_inst_t *spi);
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate);
+uint spi_get_baudrate(const spi_inst_t *spi);
+
+// Implementadas pelo backend que emula o barramento (sd_emu.c ou
+// mfrc522_emu.c; um executável liga só um deles)
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len);
+
+#endif // HOST_HARDWARE_SPI_H
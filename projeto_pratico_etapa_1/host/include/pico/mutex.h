@@ -0,0 +1,22 @@
+// Stub do pico/mutex.h para o build de host (Linux): mutex sobre pthreads
+#ifndef HOST_PICO_MUTEX_H
+#define HOST_PICO_MUTEX_H
+
+#include <pthread.h>
+#include "pico/types.h"
+#include "pico/time.h"
+
+typedef struct {
+    pthread_mutex_t m;
+    bool initialized;
+} mutex_t;
+
+#define auto_init_mutex(name) static mutex_t name = {PTHREAD_MUTEX_INITIALIZER, true}
+
+void mutex_init(mutex_t *mtx);
+bool mutex_is_initialized(mutex_t *mtx);
+void mutex_enter_blocking(mutex_t *mtx);
+bool mutex_try_enter(mutex_t *mtx, uint32_t *owner_out);
+void mutex_exit(mutex_t *mtx);
+
+#endif // HOST_PICO_MUTEX_H
@@ -0,0 +1,12 @@
+// Stub do pico/sem.h para o build de host (Linux)
+#ifndef HOST_PICO_SEM_H
+#define HOST_PICO_SEM_H
+
+#include "pico/types.h"
+
+typedef struct {
+    int16_t permits;
+    int16_t max_permits;
+} semaphore_t;
+
+#endif // HOST_PICO_SEM_H
@@ -0,0 +1,10 @@
+// Stub do pico/stdlib.h para o build de host (Linux)
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdio.h>
+#include "pico/types.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+#endif // HOST_PICO_STDLIB_H
@@ -0,0 +1,35 @@
+// Stub do pico/time.h para o build de host (Linux)
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include "pico/types.h"
+
+absolute_time_t get_absolute_time(void);
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+uint32_t to_ms_since_boot(absolute_time_t t);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+absolute_time_t make_timeout_time_us(uint64_t us);
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms);
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us(uint64_t us);
+void busy_wait_us_32(uint32_t us);
+bool time_reached(absolute_time_t t);
+void sleep_until(absolute_time_t t);
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp);
+
+// Só no host: relógio virtual, avançado pelos emuladores (ver pico_host.c)
+void host_clock_set_virtual(bool on);
+void host_clock_advance_ns(uint64_t ns);
+
+// Só no host: chamado no lugar do WFE. O emulador do periférico espera até
+// o próximo evento dele (ou o prazo) e gera a interrupção (ver mfrc522_emu.c)
+extern void (*host_wfe_hook)(absolute_time_t deadline);
+
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline void tight_loop_contents(void) {}
+
+#endif // HOST_PICO_TIME_H
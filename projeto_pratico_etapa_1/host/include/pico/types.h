@@ -0,0 +1,21 @@
+// Stub do pico/types.h para o build de host (Linux)
+#ifndef HOST_PICO_TYPES_H
+#define HOST_PICO_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+// No host o tempo absoluto é simplesmente microssegundos de CLOCK_MONOTONIC
+typedef uint64_t absolute_time_t;
+
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+
+#ifndef count_of
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+#endif // HOST_PICO_TYPES_H
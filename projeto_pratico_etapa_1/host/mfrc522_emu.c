@@ -0,0 +1,1165 @@
+/**
+ * @file mfrc522_emu.c
+ * @brief Emulador do MFRC522 e de cartões ISO/IEC 14443 A (build de host).
+ *
+ * Cada byte trocado no SPI passa por emu_clock(): o primeiro byte de uma
+ * transação traz o endereço, os seguintes são escritos no mesmo registrador
+ * ou, na leitura, trazem o próximo endereço enquanto o valor do anterior sai
+ * no MISO (datasheet, seção 8.1.2).
+ *
+ * O lado RF é avaliado no StartSend: o quadro sai da FIFO, os cartões no
+ * campo o processam e a resposta (ou o estouro do timer) vira um evento com
+ * hora marcada: fim da transmissão, FDT, gravação da EEPROM e a resposta no
+ * ar, a 106 kbit/s. Os eventos são aplicados quando o software lê um
+ * registrador ou espera no WFE, então com o relógio virtual as esperas do
+ * driver custam só o tempo simulado.
+ *
+ * CollPos: o driver (PICC_Select) interpreta a posição da colisão como o bit
+ * do UID no nível de cascata atual, contando os bits já conhecidos. O
+ * emulador segue essa convenção na anticolisão; nos demais quadros conta a
+ * partir do primeiro bit recebido.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mfrc522_emu.h"
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+#include "pico/time.h"
+
+// Registradores (endereço de 6 bits, sem o deslocamento do enum do driver)
+enum {
+    R_COMMAND = 0x01,
+    R_COMIEN = 0x02,
+    R_DIVIEN = 0x03,
+    R_COMIRQ = 0x04,
+    R_DIVIRQ = 0x05,
+    R_ERROR = 0x06,
+    R_STATUS1 = 0x07,
+    R_STATUS2 = 0x08,
+    R_FIFODATA = 0x09,
+    R_FIFOLEVEL = 0x0A,
+    R_WATERLEVEL = 0x0B,
+    R_CONTROL = 0x0C,
+    R_BITFRAMING = 0x0D,
+    R_COLL = 0x0E,
+    R_MODE = 0x11,
+    R_TXCONTROL = 0x14,
+    R_TXSEL = 0x16,
+    R_RXSEL = 0x17,
+    R_RXTHRESHOLD = 0x18,
+    R_DEMOD = 0x19,
+    R_MFTX = 0x1C,
+    R_SERIALSPEED = 0x1F,
+    R_CRCRESULT_H = 0x21,
+    R_CRCRESULT_L = 0x22,
+    R_MODWIDTH = 0x24,
+    R_RFCFG = 0x26,
+    R_GSN = 0x27,
+    R_CWGSP = 0x28,
+    R_MODGSP = 0x29,
+    R_TMODE = 0x2A,
+    R_TPRESCALER = 0x2B,
+    R_TRELOAD_H = 0x2C,
+    R_TRELOAD_L = 0x2D,
+    R_VERSION = 0x37,
+};
+
+// CommandReg
+#define CMD_IDLE        0x0
+#define CMD_MEM         0x1
+#define CMD_CALCCRC     0x3
+#define CMD_NOCMDCHANGE 0x7
+#define CMD_TRANSCEIVE  0xC
+#define CMD_MFAUTHENT   0xE
+#define CMD_SOFTRESET   0xF
+#define CMD_POWERDOWN   0x10
+
+// ComIrqReg / DivIrqReg
+#define IRQ_TX     0x40
+#define IRQ_RX     0x20
+#define IRQ_IDLE   0x10
+#define IRQ_ERR    0x02
+#define IRQ_TIMER  0x01
+#define DIVIRQ_CRC 0x04
+
+// ErrorReg, Status1Reg, Status2Reg
+#define ERR_BUFFER_OVFL 0x10
+#define ERR_COLL        0x08
+#define ST1_CRCOK       0x40
+#define ST1_CRCREADY    0x20
+#define ST1_IRQ         0x10
+#define ST2_CRYPTO1ON   0x08
+
+#define EMU_FIFO_SIZE 64
+#define EMU_FC_HZ 13560000u
+#define EMU_BIT_NS 9440u   // 128/fc: um bit a 106 kbit/s
+
+// Valores de reset (datasheet, seção 9.3); o resto é 0x00
+static const uint8_t reg_reset[64] = {
+    [R_COMMAND] = 0x20, [R_COMIEN] = 0x80, [R_COMIRQ] = 0x14, [R_STATUS1] = 0x21,
+    [R_WATERLEVEL] = 0x08, [R_CONTROL] = 0x10, [R_COLL] = 0x80, [R_MODE] = 0x3F,
+    [R_TXCONTROL] = 0x80, [R_TXSEL] = 0x10, [R_RXSEL] = 0x84, [R_RXTHRESHOLD] = 0x84,
+    [R_DEMOD] = 0x4D, [R_MFTX] = 0x62, [R_SERIALSPEED] = 0xEB, [R_MODWIDTH] = 0x26,
+    [R_RFCFG] = 0x48, [R_GSN] = 0x88, [R_CWGSP] = 0x20, [R_MODGSP] = 0x20,
+};
+
+// Comandos dos cartões
+#define PICC_REQA      0x26
+#define PICC_WUPA      0x52
+#define PICC_CT        0x88
+#define PICC_SEL_CL1   0x93
+#define PICC_SEL_CL2   0x95
+#define PICC_HLTA      0x50
+#define PICC_READ      0x30
+#define PICC_WRITE     0xA0
+#define PICC_DECREMENT 0xC0
+#define PICC_INCREMENT 0xC1
+#define PICC_RESTORE   0xC2
+#define PICC_TRANSFER  0xB0
+#define PICC_UL_WRITE  0xA2
+#define PICC_FAST_READ 0x3A
+#define PICC_PWD_AUTH  0x1B
+#define PICC_AUTH_A    0x60
+#define PICC_AUTH_B    0x61
+#define PICC_ACK       0x0A
+
+#define NTAG213_PAGES  45
+#define NTAG_CFG0_PAGE 0x29   // AUTH0 no byte 3
+#define NTAG_CFG1_PAGE 0x2A   // ACCESS no byte 0 (bit 7 = PROT)
+#define NTAG_PWD_PAGE  0x2B
+#define NTAG_PACK_PAGE 0x2C
+
+typedef enum { PICC_IDLE, PICC_READY, PICC_ACTIVE, PICC_HALT } picc_state_t;
+
+typedef struct {
+    mfrc522_emu_card_t cfg;
+    uint8_t mem[1024];
+    unsigned pages;          // Ultralight/NTAG: páginas de 4 bytes
+    bool in_field;           // Presença manual (mfrc522_emu_set_present)
+    bool removed;            // Saiu por remove_after_frames
+    uint32_t frames_heard;
+    bool tearing;            // Último quadro com tear_writes: gravação pela metade
+
+    picc_state_t state;
+    bool was_halted;         // READY*/ACTIVE*: veio de HALT pelo WUPA
+    uint8_t level;           // Nível de cascata em andamento
+    int auth_sector;         // Classic: setor autenticado, -1 = nenhum
+    bool pwd_ok;             // NTAG: PWD_AUTH aceito
+    uint8_t pending;         // Segundo passo esperado (WRITE, INC, ...)
+    uint8_t pending_block;
+    int32_t transfer_value;  // Registrador interno do Classic
+    bool transfer_valid;
+} picc_t;
+
+// Resposta de um cartão, bits LSB primeiro
+typedef struct {
+    uint8_t data[EMU_FIFO_SIZE + 2];
+    int nbits;
+    uint32_t busy_us;        // Gravação da EEPROM antes de responder
+} picc_reply_t;
+
+typedef enum { EV_NONE, EV_RX, EV_TIMEOUT, EV_AUTH_DONE } emu_event_t;
+
+static struct {
+    bool attached;
+    mfrc522_emu_config_t cfg;
+    unsigned cs_gpio;
+    int irq_gpio;
+    uint8_t reg[64];
+    uint8_t fifo[EMU_FIFO_SIZE];
+    int fifo_len;
+
+    // SPI
+    bool selected;
+    bool have_addr;
+    bool reading;
+    uint8_t addr;
+
+    // Comando e RF
+    uint8_t command;
+    bool powerdown;
+    uint64_t osc_ready_us;
+    bool field_on;
+    uint64_t field_on_since_us;
+    bool tx_pending;
+    uint64_t tx_end_us;
+    emu_event_t event;
+    uint64_t event_us;
+    picc_reply_t rx;         // Resposta combinada de todos os cartões
+    int rx_coll;             // Primeiro bit em colisão, -1 = nenhum
+    int rx_coll_base;        // Bits do UID já conhecidos (anticolisão)
+    uint8_t rx_align;
+
+    picc_t cards[MFRC522_EMU_MAX_CARDS];
+    int card_count;
+    mfrc522_emu_stats_t stats;
+} emu;
+
+/* ********************************************************************** */
+// CRC_A implementado aqui, e não com o do driver, para que o emulador também
+// o verifique.
+
+static uint16_t emu_crc_a(const uint8_t *data, int len, uint16_t preset) {
+    uint16_t crc = preset;
+    for (int i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+static bool crc_ok(const uint8_t *frame, int len) {
+    if (len < 3) return false;
+    uint16_t crc = emu_crc_a(frame, len - 2, 0x6363);
+    return frame[len - 2] == (crc & 0xFF) && frame[len - 1] == (crc >> 8);
+}
+
+static int get_bit(const uint8_t *data, int i) {
+    return (data[i / 8] >> (i % 8)) & 1;
+}
+
+static void put_bit(uint8_t *data, int i, int value) {
+    if (value) {
+        data[i / 8] |= (uint8_t)(1u << (i % 8));
+    } else {
+        data[i / 8] &= (uint8_t)~(1u << (i % 8));
+    }
+}
+
+/* ********************************************************************** */
+// Interrupções e eventos
+
+static bool irq_active(void) {
+    return (emu.reg[R_COMIRQ] & emu.reg[R_COMIEN] & 0x7F) ||
+           (emu.reg[R_DIVIRQ] & emu.reg[R_DIVIEN] & 0x14);
+}
+
+// IRqInv (ComIEnReg bit 7) = 1: o pino fica baixo com interrupção pendente
+static void update_irq_line(void) {
+    if (emu.irq_gpio < 0) return;
+    bool inverted = emu.reg[R_COMIEN] & 0x80;
+    host_gpio_drive((uint)emu.irq_gpio, irq_active() != inverted);
+}
+
+static void set_irq(uint8_t reg, uint8_t bits) {
+    emu.reg[reg] |= bits;
+    update_irq_line();
+}
+
+static uint64_t ns_to_us(uint64_t ns) {
+    return (ns + 999) / 1000;
+}
+
+// Período do timer: TPrescaler de 12 bits e TReload, TPrescalEven = 0
+static uint64_t timer_period_us(void) {
+    uint32_t prescaler = ((uint32_t)(emu.reg[R_TMODE] & 0x0F) << 8) | emu.reg[R_TPRESCALER];
+    uint32_t reload = ((uint32_t)emu.reg[R_TRELOAD_H] << 8) | emu.reg[R_TRELOAD_L];
+    return ns_to_us((uint64_t)(2 * prescaler + 1) * (reload + 1) * 1000000000ull / EMU_FC_HZ);
+}
+
+static bool timer_auto(void) {
+    return emu.reg[R_TMODE] & 0x80;
+}
+
+static void schedule(emu_event_t event, uint64_t at_us) {
+    emu.event = event;
+    emu.event_us = at_us;
+}
+
+static void fifo_push(uint8_t value) {
+    if (emu.fifo_len >= EMU_FIFO_SIZE) {
+        emu.reg[R_ERROR] |= ERR_BUFFER_OVFL;
+        return;
+    }
+    emu.fifo[emu.fifo_len++] = value;
+}
+
+static uint8_t fifo_pop(void) {
+    if (!emu.fifo_len) return 0;
+    uint8_t value = emu.fifo[0];
+    memmove(emu.fifo, emu.fifo + 1, (size_t)--emu.fifo_len);
+    return value;
+}
+
+// Resposta recebida: bits na FIFO a partir de RxAlign, RxLastBits, colisão
+static void deliver_rx(void) {
+    picc_reply_t *rx = &emu.rx;
+    int total = emu.rx_align + rx->nbits;
+    uint8_t bytes[EMU_FIFO_SIZE + 3];
+    memset(bytes, 0, sizeof bytes);
+
+    int keep = rx->nbits;
+    if (emu.rx_coll >= 0) {
+        emu.stats.collisions++;
+        emu.reg[R_ERROR] |= ERR_COLL;
+        int pos = emu.rx_coll_base + emu.rx_coll + 1;
+        emu.reg[R_COLL] = (emu.reg[R_COLL] & 0x80) | (pos > 32 ? 0x20 : (pos & 0x1F));
+        // ValuesAfterColl = 0: bits a partir da colisão chegam zerados
+        if (!(emu.reg[R_COLL] & 0x80)) keep = emu.rx_coll;
+    }
+    for (int i = 0; i < keep; i++) {
+        put_bit(bytes, emu.rx_align + i, get_bit(rx->data, i));
+    }
+    for (int i = 0; i < (total + 7) / 8; i++) fifo_push(bytes[i]);
+    emu.reg[R_CONTROL] = (emu.reg[R_CONTROL] & ~0x07) | (total % 8);
+
+    uint8_t irq = IRQ_RX;
+    if (emu.reg[R_ERROR]) irq |= IRQ_ERR;
+    set_irq(R_COMIRQ, irq);
+}
+
+// Aplica o que já venceu. Chamado a cada byte SPI e no WFE.
+static void emu_tick(void) {
+    uint64_t now = time_us_64();
+    if (emu.tx_pending && now >= emu.tx_end_us) {
+        emu.tx_pending = false;
+        set_irq(R_COMIRQ, IRQ_TX);
+    }
+    if (emu.event == EV_NONE || now < emu.event_us) return;
+
+    emu_event_t event = emu.event;
+    emu.event = EV_NONE;
+    switch (event) {
+        case EV_RX:
+            deliver_rx();
+            break;
+        case EV_TIMEOUT:
+            emu.stats.timeouts++;
+            set_irq(R_COMIRQ, IRQ_TIMER);
+            break;
+        case EV_AUTH_DONE:
+            emu.stats.auths++;
+            emu.reg[R_STATUS2] |= ST2_CRYPTO1ON;
+            emu.command = CMD_IDLE;
+            set_irq(R_COMIRQ, IRQ_IDLE);
+            break;
+        default:
+            break;
+    }
+}
+
+// WFE do driver: dorme até o próximo evento do leitor (ou o prazo)
+static void emu_wfe(absolute_time_t deadline) {
+    emu_tick();
+    uint64_t now = time_us_64();
+    uint64_t next = deadline;
+    if (emu.tx_pending && emu.tx_end_us < next) next = emu.tx_end_us;
+    if (emu.event != EV_NONE && emu.event_us < next) next = emu.event_us;
+    if (next > now) sleep_us(next - now);
+    emu_tick();
+}
+
+/* ********************************************************************** */
+// Cartões
+
+static bool is_classic(const picc_t *c) {
+    return c->cfg.type == MFRC522_EMU_CLASSIC_1K;
+}
+
+static bool is_ntag(const picc_t *c) {
+    return c->cfg.type == MFRC522_EMU_NTAG213;
+}
+
+// Estado volátil: perdido quando o cartão sai do campo ou o campo desliga
+static void picc_reset(picc_t *c) {
+    c->state = PICC_IDLE;
+    c->was_halted = false;
+    c->level = 1;
+    c->auth_sector = -1;
+    c->pwd_ok = false;
+    c->pending = 0;
+    c->transfer_valid = false;
+}
+
+// Erro ou comando inesperado: volta para IDLE, ou HALT se veio de lá
+static void picc_fallback(picc_t *c) {
+    bool halted = c->was_halted;
+    picc_reset(c);
+    if (halted) c->state = PICC_HALT;
+}
+
+static bool picc_powered(picc_t *c) {
+    uint64_t now = time_us_64();
+    bool present = c->in_field && !c->removed && now >= c->cfg.present_from_us &&
+                   (!c->cfg.present_until_us || now < c->cfg.present_until_us);
+    bool powered = present && emu.field_on &&
+                   now - emu.field_on_since_us >= emu.cfg.card_power_up_us;
+    if (!powered) picc_reset(c);
+    return powered;
+}
+
+static void field_update(void) {
+    bool on = (emu.reg[R_TXCONTROL] & 0x03) && !emu.powerdown;
+    if (on == emu.field_on) return;
+    emu.field_on = on;
+    if (on) {
+        emu.field_on_since_us = time_us_64();
+    } else {
+        for (int i = 0; i < emu.card_count; i++) picc_reset(&emu.cards[i]);
+    }
+}
+
+static uint8_t picc_levels(const picc_t *c) {
+    return c->cfg.uid_size == 4 ? 1 : 2;
+}
+
+// UID do nível de cascata: 4 bytes (com CT se não couber) + BCC
+static void picc_cl_data(const picc_t *c, uint8_t level, uint8_t out[5]) {
+    if (c->cfg.uid_size == 4) {
+        memcpy(out, c->cfg.uid, 4);
+    } else if (level == 1) {
+        out[0] = PICC_CT;
+        memcpy(out + 1, c->cfg.uid, 3);
+    } else {
+        memcpy(out, c->cfg.uid + 3, 4);
+    }
+    out[4] = out[0] ^ out[1] ^ out[2] ^ out[3];
+}
+
+static void reply_bytes(picc_reply_t *r, const uint8_t *data, int len, bool crc) {
+    memcpy(r->data, data, (size_t)len);
+    if (crc) {
+        uint16_t value = emu_crc_a(data, len, 0x6363);
+        r->data[len++] = value & 0xFF;
+        r->data[len++] = value >> 8;
+    }
+    r->nbits = 8 * len;
+}
+
+static void reply_ack(picc_reply_t *r, uint32_t busy_us) {
+    r->data[0] = PICC_ACK;
+    r->nbits = 4;
+    r->busy_us = busy_us;
+}
+
+// NAK de 4 bits; o cartão volta para IDLE/HALT
+static void reply_nak(picc_t *c, picc_reply_t *r, bool crc_error) {
+    if (is_classic(c)) {
+        r->data[0] = crc_error ? 0x5 : 0x4;
+    } else {
+        r->data[0] = crc_error ? 0x1 : 0x0;
+    }
+    r->nbits = 4;
+    picc_fallback(c);
+}
+
+static void picc_short_frame(picc_t *c, uint8_t cmd, picc_reply_t *r) {
+    bool wake = cmd == PICC_WUPA;
+    if (cmd != PICC_REQA && !wake) return;
+    if (c->state == PICC_IDLE || (wake && c->state == PICC_HALT)) {
+        c->was_halted = c->state == PICC_HALT;
+        c->state = PICC_READY;
+        c->level = 1;
+        // ATQA: bits 7..6 = tamanho do UID, bit 2 = anticolisão por bits
+        uint8_t atqa[2] = {(uint8_t)(c->cfg.uid_size == 4 ? 0x04 : 0x44), 0x00};
+        reply_bytes(r, atqa, 2, false);
+    } else if (c->state != PICC_HALT) {
+        picc_fallback(c);
+    }
+}
+
+// SELECT/ANTICOLLISION. *known recebe os bits do UID já conhecidos.
+static void picc_select(picc_t *c, const uint8_t *f, int len, picc_reply_t *r, int *known) {
+    if (c->state != PICC_READY) {
+        if (c->state == PICC_ACTIVE) picc_fallback(c);
+        return;
+    }
+    uint8_t level = (uint8_t)((f[0] - PICC_SEL_CL1) / 2 + 1);
+    if (level != c->level) {
+        picc_fallback(c);
+        return;
+    }
+    uint8_t cl[5];
+    picc_cl_data(c, level, cl);
+
+    if (f[1] == 0x70 && len == 9) {
+        if (!crc_ok(f, len)) return;
+        if (memcmp(f + 2, cl, 5) != 0) {
+            picc_fallback(c);  // Outro cartão foi selecionado
+            return;
+        }
+        uint8_t sak;
+        if (level < picc_levels(c)) {
+            sak = 0x04;  // Cascade bit: o UID continua no próximo nível
+            c->level++;
+        } else {
+            sak = is_classic(c) ? 0x08 : 0x00;
+            c->state = PICC_ACTIVE;
+        }
+        reply_bytes(r, &sak, 1, true);
+        return;
+    }
+
+    // Anticolisão: NVB = bytes (com SEL e NVB) e bits do UID já conhecidos
+    int nvb_bits = (f[1] >> 4) * 8 + (f[1] & 0x0F) - 16;
+    if (nvb_bits < 0 || nvb_bits > 40) return;
+    for (int i = 0; i < nvb_bits; i++) {
+        if (get_bit(f + 2, i) != get_bit(cl, i)) return;  // Não é comigo
+    }
+    memset(r->data, 0, sizeof r->data);
+    for (int i = nvb_bits; i < 40; i++) put_bit(r->data, i - nvb_bits, get_bit(cl, i));
+    r->nbits = 40 - nvb_bits;
+    *known = nvb_bits;
+}
+
+/* ---- MIFARE Classic ---- */
+
+static int classic_sector(uint8_t block) {
+    return block / 4;
+}
+
+static bool classic_value_ok(const uint8_t *b) {
+    for (int i = 0; i < 4; i++) {
+        if (b[i] != b[i + 8] || (b[i] ^ b[i + 4]) != 0xFF) return false;
+    }
+    return b[12] == b[14] && b[13] == b[15] && (b[12] ^ b[13]) == 0xFF;
+}
+
+static int32_t classic_value(const uint8_t *b) {
+    return (int32_t)((uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 |
+                     (uint32_t)b[3] << 24);
+}
+
+static void classic_set_value(uint8_t *b, int32_t value, uint8_t addr) {
+    for (int i = 0; i < 4; i++) {
+        b[i] = b[i + 8] = (uint8_t)((uint32_t)value >> (8 * i));
+        b[i + 4] = (uint8_t)~b[i];
+    }
+    b[12] = b[14] = addr;
+    b[13] = b[15] = (uint8_t)~addr;
+}
+
+static void classic_frame(picc_t *c, const uint8_t *f, int len, picc_reply_t *r) {
+    uint8_t *blk;
+
+    // Segundo passo de WRITE / INC / DEC / RESTORE
+    if (c->pending) {
+        uint8_t cmd = c->pending;
+        c->pending = 0;
+        blk = &c->mem[16 * c->pending_block];
+        if (cmd == PICC_WRITE) {
+            if (len != 18) {
+                reply_nak(c, r, false);
+                return;
+            }
+            memcpy(blk, f, c->tearing ? 8 : 16);
+            reply_ack(r, c->cfg.write_us);
+            return;
+        }
+        if (len != 6) {
+            reply_nak(c, r, false);
+            return;
+        }
+        int32_t delta = classic_value(f);
+        int32_t value = classic_value(blk);
+        c->transfer_value = cmd == PICC_INCREMENT ? value + delta
+                          : cmd == PICC_DECREMENT ? value - delta : value;
+        c->transfer_valid = true;
+        return;  // Sem resposta: o driver aceita o timeout
+    }
+
+    uint8_t cmd = f[0];
+    if (cmd == PICC_HLTA && len == 4 && f[1] == 0x00) {
+        picc_reset(c);
+        c->state = PICC_HALT;
+        return;
+    }
+    if (len != 4 || f[1] >= 64) {
+        reply_nak(c, r, false);
+        return;
+    }
+    uint8_t block = f[1];
+    if (c->auth_sector != classic_sector(block)) {
+        reply_nak(c, r, false);
+        return;
+    }
+    blk = &c->mem[16 * block];
+
+    switch (cmd) {
+        case PICC_READ: {
+            uint8_t data[16];
+            memcpy(data, blk, 16);
+            if (block % 4 == 3) memset(data, 0, 6);  // Chave A nunca é lida
+            reply_bytes(r, data, 16, true);
+            return;
+        }
+        case PICC_WRITE:
+            if (block == 0) break;  // Bloco do fabricante
+            c->pending = cmd;
+            c->pending_block = block;
+            reply_ack(r, 0);
+            return;
+        case PICC_INCREMENT:
+        case PICC_DECREMENT:
+        case PICC_RESTORE:
+            if (block % 4 == 3 || !classic_value_ok(blk)) break;
+            c->pending = cmd;
+            c->pending_block = block;
+            reply_ack(r, 0);
+            return;
+        case PICC_TRANSFER:
+            if (!c->transfer_valid || block == 0 || block % 4 == 3) break;
+            classic_set_value(blk, c->transfer_value, classic_value_ok(blk) ? blk[12] : block);
+            reply_ack(r, c->cfg.write_us);
+            return;
+        default:
+            break;
+    }
+    reply_nak(c, r, false);
+}
+
+/* ---- Ultralight / NTAG213 ---- */
+
+static uint8_t *page_ptr(picc_t *c, unsigned page) {
+    return &c->mem[4 * page];
+}
+
+static bool ul_protected(picc_t *c, unsigned page, bool write) {
+    if (!is_ntag(c) || c->pwd_ok) return false;
+    if (page < page_ptr(c, NTAG_CFG0_PAGE)[3]) return false;
+    return write || (page_ptr(c, NTAG_CFG1_PAGE)[0] & 0x80);
+}
+
+static bool ul_write_page(picc_t *c, uint8_t page, const uint8_t *data, picc_reply_t *r) {
+    if (page < 2 || page >= c->pages || ul_protected(c, page, true)) return false;
+    uint8_t *p = page_ptr(c, page);
+    if (page == 2) {
+        p[2] |= data[2];  // Bits de trava: só vão de 0 para 1
+        p[3] |= data[3];
+    } else if (page == 3 && !is_ntag(c)) {
+        for (int i = 0; i < 4; i++) p[i] |= data[i];  // OTP
+    } else {
+        memcpy(p, data, c->tearing ? 2 : 4);
+    }
+    reply_ack(r, c->cfg.write_us);
+    return true;
+}
+
+static void ul_read_pages(picc_t *c, unsigned first, unsigned count, picc_reply_t *r) {
+    uint8_t data[EMU_FIFO_SIZE];
+    for (unsigned i = 0; i < count; i++) {
+        unsigned page = (first + i) % c->pages;  // READ volta ao início
+        if (is_ntag(c) && (page == NTAG_PWD_PAGE || page == NTAG_PACK_PAGE)) {
+            memset(&data[4 * i], 0, 4);
+        } else {
+            memcpy(&data[4 * i], page_ptr(c, page), 4);
+        }
+    }
+    reply_bytes(r, data, (int)(4 * count), true);
+}
+
+static void ul_frame(picc_t *c, const uint8_t *f, int len, picc_reply_t *r) {
+    if (c->pending) {  // COMPATIBILITY WRITE: 16 bytes, grava os 4 primeiros
+        c->pending = 0;
+        if (len != 18 || !ul_write_page(c, c->pending_block, f, r)) reply_nak(c, r, false);
+        return;
+    }
+
+    switch (f[0]) {
+        case PICC_HLTA:
+            if (len != 4 || f[1] != 0x00) break;
+            picc_reset(c);
+            c->state = PICC_HALT;
+            return;
+        case PICC_READ:
+            if (len != 4 || f[1] >= c->pages) break;
+            for (unsigned i = 0; i < 4; i++) {
+                if (ul_protected(c, (f[1] + i) % c->pages, false)) {
+                    reply_nak(c, r, false);
+                    return;
+                }
+            }
+            ul_read_pages(c, f[1], 4, r);
+            return;
+        case PICC_UL_WRITE:
+            if (len != 8 || !ul_write_page(c, f[1], f + 2, r)) break;
+            return;
+        case PICC_WRITE:
+            if (len != 4 || f[1] < 2 || f[1] >= c->pages) break;
+            c->pending = PICC_WRITE;
+            c->pending_block = f[1];
+            reply_ack(r, 0);
+            return;
+        case PICC_FAST_READ:
+            if (!is_ntag(c) || len != 5 || f[1] > f[2] || f[2] >= c->pages) break;
+            for (unsigned p = f[1]; p <= f[2]; p++) {
+                if (ul_protected(c, p, false)) {
+                    reply_nak(c, r, false);
+                    return;
+                }
+            }
+            ul_read_pages(c, f[1], (unsigned)(f[2] - f[1] + 1), r);
+            return;
+        case PICC_PWD_AUTH:
+            if (!is_ntag(c) || len != 7) break;
+            if (memcmp(f + 1, page_ptr(c, NTAG_PWD_PAGE), 4) != 0) break;
+            c->pwd_ok = true;
+            reply_bytes(r, page_ptr(c, NTAG_PACK_PAGE), 2, true);
+            return;
+        default:
+            break;
+    }
+    reply_nak(c, r, false);
+}
+
+// Um quadro padrão (com CRC) para o cartão ACTIVE
+static void picc_std_frame(picc_t *c, const uint8_t *f, int len, picc_reply_t *r) {
+    if (c->state == PICC_READY) {
+        picc_fallback(c);
+        return;
+    }
+    if (c->state != PICC_ACTIVE) return;
+
+    // Classic autenticado espera quadros cifrados, e vice-versa: o quadro
+    // vira lixo para o cartão, que volta para IDLE/HALT sem responder
+    bool crypto = emu.reg[R_STATUS2] & ST2_CRYPTO1ON;
+    if (is_classic(c) && (c->auth_sector >= 0) != crypto) {
+        picc_fallback(c);
+        return;
+    }
+    if (!crc_ok(f, len)) {
+        reply_nak(c, r, true);
+        return;
+    }
+    if (is_classic(c)) {
+        classic_frame(c, f, len, r);
+    } else {
+        ul_frame(c, f, len, r);
+    }
+}
+
+/* ********************************************************************** */
+// Comandos do MFRC522
+
+static void rx_merge(const picc_reply_t *r, bool first) {
+    if (first) {
+        emu.rx = *r;
+        return;
+    }
+    int n = r->nbits > emu.rx.nbits ? r->nbits : emu.rx.nbits;
+    for (int i = 0; i < n; i++) {
+        bool mine = i < emu.rx.nbits, theirs = i < r->nbits;
+        int a = mine ? get_bit(emu.rx.data, i) : 0;
+        int b = theirs ? get_bit(r->data, i) : 0;
+        if (mine && theirs && a != b && (emu.rx_coll < 0 || i < emu.rx_coll)) emu.rx_coll = i;
+        put_bit(emu.rx.data, i, a | b);
+    }
+    emu.rx.nbits = n;
+    if (r->busy_us > emu.rx.busy_us) emu.rx.busy_us = r->busy_us;
+}
+
+// Conta o quadro para remove_after_frames; true se o cartão saiu agora
+static bool picc_heard(picc_t *c) {
+    c->frames_heard++;
+    if (!c->cfg.remove_after_frames || c->frames_heard < c->cfg.remove_after_frames) return false;
+    c->removed = true;
+    picc_reset(c);
+    return true;
+}
+
+static void start_transceive(void) {
+    uint8_t frame[EMU_FIFO_SIZE];
+    int len = emu.fifo_len;
+    memcpy(frame, emu.fifo, (size_t)len);
+    emu.fifo_len = 0;
+
+    uint8_t last_bits = emu.reg[R_BITFRAMING] & 0x07;
+    int tx_bits = len ? (len - 1) * 8 + (last_bits ? last_bits : 8) : 0;
+    uint8_t gain = (emu.reg[R_RFCFG] >> 4) & 0x07;
+    emu.rx_align = (emu.reg[R_BITFRAMING] >> 4) & 0x07;
+    emu.rx_coll = -1;
+    emu.rx_coll_base = 0;
+    emu.reg[R_ERROR] = 0;
+    emu.reg[R_COLL] = (emu.reg[R_COLL] & 0x80) | 0x20;
+    emu.stats.frames++;
+
+    // SOF, 8 bits + paridade por byte, EOF
+    uint64_t now = time_us_64();
+    uint64_t tx_us = ns_to_us((uint64_t)(tx_bits + tx_bits / 8 + 2) * EMU_BIT_NS);
+    emu.tx_pending = true;
+    emu.tx_end_us = now + tx_us;
+    emu.stats.air_us += tx_us;
+
+    bool replied = false;
+    for (int i = 0; len && emu.field_on && i < emu.card_count; i++) {
+        picc_t *c = &emu.cards[i];
+        if (!picc_powered(c)) continue;
+        picc_reply_t r = {.nbits = 0};
+        int known = 0;
+        c->tearing = c->cfg.tear_writes && c->cfg.remove_after_frames &&
+                     c->frames_heard + 1 >= c->cfg.remove_after_frames;
+        if (tx_bits == 7 && len == 1) {
+            picc_short_frame(c, frame[0], &r);
+        } else if ((frame[0] == PICC_SEL_CL1 || frame[0] == PICC_SEL_CL2) && len >= 2) {
+            picc_select(c, frame, len, &r, &known);
+        } else if (tx_bits % 8 == 0) {
+            picc_std_frame(c, frame, len, &r);
+        }
+        if (picc_heard(c) || !r.nbits || gain < c->cfg.min_rx_gain) continue;
+        rx_merge(&r, !replied);
+        emu.rx_coll_base = known;
+        replied = true;
+    }
+
+    if (replied) {
+        uint64_t rx_us = ns_to_us((uint64_t)(emu.rx.nbits + emu.rx.nbits / 8 + 2) * EMU_BIT_NS);
+        uint64_t wait_us = emu.cfg.fdt_us + emu.rx.busy_us + rx_us;
+        emu.stats.responses++;
+        emu.stats.air_us += wait_us;
+        schedule(EV_RX, emu.tx_end_us + wait_us);
+    } else if (timer_auto()) {
+        schedule(EV_TIMEOUT, emu.tx_end_us + timer_period_us());
+    }
+}
+
+// MFAuthent: FIFO = comando, bloco, chave (6 bytes), UID (4 primeiros bytes)
+static void start_auth(void) {
+    uint8_t in[12];
+    int len = emu.fifo_len;
+    memcpy(in, emu.fifo, (size_t)(len < 12 ? len : 12));
+    emu.fifo_len = 0;
+    emu.reg[R_ERROR] = 0;
+
+    picc_t *card = NULL;
+    for (int i = 0; emu.field_on && i < emu.card_count; i++) {
+        picc_t *c = &emu.cards[i];
+        if (picc_powered(c) && c->state == PICC_ACTIVE && is_classic(c)) {
+            card = c;
+            break;
+        }
+    }
+
+    bool ok = false;
+    if (card && len >= 12 && (in[0] == PICC_AUTH_A || in[0] == PICC_AUTH_B) && in[1] < 64 &&
+        memcmp(in + 8, card->cfg.uid, 4) == 0) {
+        const uint8_t *trailer = &card->mem[16 * (in[1] | 3)];
+        ok = memcmp(in + 2, in[0] == PICC_AUTH_A ? trailer : trailer + 10, 6) == 0;
+    }
+    if (card && picc_heard(card)) ok = false;
+
+    uint64_t now = time_us_64();
+    if (ok) {
+        card->auth_sector = classic_sector(in[1]);
+        emu.stats.air_us += emu.cfg.auth_us;
+        schedule(EV_AUTH_DONE, now + emu.cfg.auth_us);
+        return;
+    }
+    // Chave errada: o cartão para de responder no meio das passadas e o
+    // comando só termina pelo timer
+    emu.stats.auth_failures++;
+    if (card) picc_fallback(card);
+    if (timer_auto()) schedule(EV_TIMEOUT, now + timer_period_us());
+}
+
+static void calc_crc(void) {
+    static const uint16_t presets[4] = {0x0000, 0x6363, 0xA671, 0xFFFF};
+    uint16_t crc = emu_crc_a(emu.fifo, emu.fifo_len, presets[emu.reg[R_MODE] & 0x03]);
+    emu.fifo_len = 0;
+    emu.reg[R_CRCRESULT_H] = crc >> 8;
+    emu.reg[R_CRCRESULT_L] = crc & 0xFF;
+    emu.reg[R_STATUS1] |= ST1_CRCREADY | ST1_CRCOK;
+    set_irq(R_DIVIRQ, DIVIRQ_CRC);
+}
+
+static void soft_reset(void) {
+    memcpy(emu.reg, reg_reset, sizeof emu.reg);
+    emu.reg[R_VERSION] = emu.cfg.version;
+    emu.fifo_len = 0;
+    emu.command = CMD_IDLE;
+    emu.event = EV_NONE;
+    emu.tx_pending = false;
+    emu.powerdown = false;
+    emu.osc_ready_us = time_us_64() + emu.cfg.osc_start_us;
+    field_update();
+    update_irq_line();
+}
+
+static void command_write(uint8_t value) {
+    uint8_t cmd = value & 0x0F;
+    emu.stats.commands[cmd]++;
+    emu.reg[R_COMMAND] = value & 0x20;  // RcvOff
+
+    if (value & CMD_POWERDOWN) {
+        emu.powerdown = true;
+        field_update();
+        return;
+    }
+    if (emu.powerdown) {
+        // Sai do soft power-down: o oscilador precisa partir de novo
+        emu.powerdown = false;
+        emu.osc_ready_us = time_us_64() + emu.cfg.osc_start_us;
+        field_update();
+    }
+    if (cmd == CMD_NOCMDCHANGE) return;
+
+    // Um novo comando (inclusive Idle) interrompe o que estiver em andamento
+    emu.event = EV_NONE;
+    emu.tx_pending = false;
+    emu.command = cmd;
+    switch (cmd) {
+        case CMD_CALCCRC:
+            calc_crc();
+            break;
+        case CMD_MFAUTHENT:
+            start_auth();
+            break;
+        case CMD_SOFTRESET:
+            soft_reset();
+            break;
+        case CMD_IDLE:
+        case CMD_TRANSCEIVE:  // Espera o StartSend
+            break;
+        default:
+            // Mem, Generate RandomID, Transmit, Receive: terminam na hora
+            emu.command = CMD_IDLE;
+            set_irq(R_COMIRQ, IRQ_IDLE);
+            break;
+    }
+}
+
+static uint8_t reg_read(uint8_t addr) {
+    emu.stats.reg_reads++;
+    switch (addr) {
+        case R_FIFODATA:
+            return fifo_pop();
+        case R_FIFOLEVEL:
+            return (uint8_t)emu.fifo_len;
+        case R_COMMAND: {
+            bool pd = emu.powerdown || time_us_64() < emu.osc_ready_us;
+            return emu.reg[R_COMMAND] | (pd ? CMD_POWERDOWN : 0) | emu.command;
+        }
+        case R_STATUS1:
+            return (emu.reg[R_STATUS1] & ~ST1_IRQ) | (irq_active() ? ST1_IRQ : 0);
+        default:
+            return emu.reg[addr];
+    }
+}
+
+static void reg_write(uint8_t addr, uint8_t value) {
+    emu.stats.reg_writes++;
+    switch (addr) {
+        case R_COMMAND:
+            command_write(value);
+            break;
+        case R_COMIRQ:
+        case R_DIVIRQ:
+            // Bit 7 (Set1/Set2): 1 liga, 0 desliga os bits marcados
+            if (value & 0x80) {
+                emu.reg[addr] |= value & 0x7F;
+            } else {
+                emu.reg[addr] &= ~value;
+            }
+            update_irq_line();
+            break;
+        case R_COMIEN:
+        case R_DIVIEN:
+            emu.reg[addr] = value;
+            update_irq_line();
+            break;
+        case R_FIFODATA:
+            fifo_push(value);
+            break;
+        case R_FIFOLEVEL:
+            if (value & 0x80) {  // FlushBuffer
+                emu.fifo_len = 0;
+                emu.reg[R_ERROR] &= ~ERR_BUFFER_OVFL;
+            }
+            break;
+        case R_BITFRAMING:
+            emu.reg[addr] = value & 0x7F;
+            if ((value & 0x80) && emu.command == CMD_TRANSCEIVE) start_transceive();
+            break;
+        case R_STATUS2:
+            emu.reg[addr] = (emu.reg[addr] & ~0xC8) | (value & 0xC8);
+            break;
+        case R_COLL:
+            emu.reg[addr] = (emu.reg[addr] & 0x7F) | (value & 0x80);
+            break;
+        case R_CONTROL:
+            emu.reg[addr] = (emu.reg[addr] & 0x07) | (value & 0x38);
+            break;
+        case R_TXCONTROL:
+            emu.reg[addr] = value;
+            field_update();
+            break;
+        case R_ERROR:
+        case R_STATUS1:
+        case R_CRCRESULT_H:
+        case R_CRCRESULT_L:
+        case R_VERSION:
+            break;  // Somente leitura
+        default:
+            emu.reg[addr] = value;
+            break;
+    }
+}
+
+/* ********************************************************************** */
+// Barramento
+
+static uint8_t emu_clock(spi_inst_t *spi, uint8_t mosi) {
+    emu_tick();
+    uint baud = spi_get_baudrate(spi);
+    uint64_t ns = baud ? 8000000000ull / baud : 0;
+    emu.stats.spi_bytes++;
+    emu.stats.bus_ns += ns;
+    host_clock_advance_ns(ns);
+
+    if (!emu.selected) return 0x00;
+    if (!emu.have_addr) {
+        emu.have_addr = true;
+        emu.reading = mosi & 0x80;
+        emu.addr = (mosi >> 1) & 0x3F;
+        return 0x00;
+    }
+    if (emu.reading) {
+        // O valor do endereço anterior sai enquanto o próximo entra
+        uint8_t value = reg_read(emu.addr);
+        emu.addr = (mosi >> 1) & 0x3F;
+        return value;
+    }
+    reg_write(emu.addr, mosi);
+    return 0x00;
+}
+
+static void emu_cs_hook(uint gpio, bool value) {
+    if (!emu.attached || gpio != emu.cs_gpio) return;
+    if (!value && !emu.selected) {
+        emu.stats.cs_selects++;
+        emu.have_addr = false;
+    }
+    emu.selected = !value;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++) emu_clock(spi, src[i]);
+    return (int)len;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len) {
+    for (size_t i = 0; i < len; i++) dst[i] = emu_clock(spi, src[i]);
+    return (int)len;
+}
+
+/* ********************************************************************** */
+// API
+
+void mfrc522_emu_default_config(mfrc522_emu_config_t *cfg) {
+    memset(cfg, 0, sizeof *cfg);
+    cfg->version = 0x92;
+    cfg->osc_start_us = 500;
+    cfg->fdt_us = 90;
+    cfg->auth_us = 1000;
+    cfg->card_power_up_us = 1000;
+}
+
+bool mfrc522_emu_attach(const mfrc522_emu_config_t *cfg, unsigned cs_gpio, int irq_gpio) {
+    memset(&emu, 0, sizeof emu);
+    emu.cfg = *cfg;
+    emu.cs_gpio = cs_gpio;
+    emu.irq_gpio = irq_gpio;
+    emu.attached = true;
+    soft_reset();
+    emu.osc_ready_us = 0;  // Ligado há tempo suficiente
+    host_gpio_put_hook = emu_cs_hook;
+    host_wfe_hook = emu_wfe;
+    return true;
+}
+
+void mfrc522_emu_detach(void) {
+    if (host_gpio_put_hook == emu_cs_hook) host_gpio_put_hook = NULL;
+    if (host_wfe_hook == emu_wfe) host_wfe_hook = NULL;
+    emu.attached = false;
+}
+
+void mfrc522_emu_card_default(mfrc522_emu_card_t *card, mfrc522_emu_card_type_t type,
+                              const uint8_t *uid, uint8_t uid_size) {
+    memset(card, 0, sizeof *card);
+    card->type = type;
+    card->uid_size = uid_size == 4 ? 4 : 7;
+    memcpy(card->uid, uid, card->uid_size);
+    // Tempos de gravação típicos: MF1S50 e MF0ICU1/NTAG21x
+    card->write_us = type == MFRC522_EMU_CLASSIC_1K ? 2500 : 4100;
+    memset(card->pwd, 0xFF, sizeof card->pwd);
+    card->auth0 = 0xFF;
+}
+
+// Memória de fábrica
+static void picc_format(picc_t *c) {
+    const mfrc522_emu_card_t *cfg = &c->cfg;
+    memset(c->mem, 0, sizeof c->mem);
+
+    if (is_classic(c)) {
+        memcpy(c->mem, cfg->uid, cfg->uid_size);
+        uint8_t *m = c->mem + cfg->uid_size;
+        if (cfg->uid_size == 4) *m++ = cfg->uid[0] ^ cfg->uid[1] ^ cfg->uid[2] ^ cfg->uid[3];
+        *m++ = 0x08;  // SAK
+        *m++ = cfg->uid_size == 4 ? 0x04 : 0x44;  // ATQA
+        *m = 0x00;
+        static const uint8_t trailer[16] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07,
+                                            0x80, 0x69, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        for (int s = 0; s < 16; s++) memcpy(&c->mem[16 * (4 * s + 3)], trailer, 16);
+        return;
+    }
+
+    c->pages = is_ntag(c) ? NTAG213_PAGES : 16;
+    const uint8_t *u = cfg->uid;
+    uint8_t *p = c->mem;
+    p[0] = u[0]; p[1] = u[1]; p[2] = u[2]; p[3] = PICC_CT ^ u[0] ^ u[1] ^ u[2];
+    memcpy(p + 4, u + 3, 4);
+    p[8] = u[3] ^ u[4] ^ u[5] ^ u[6];
+    p[9] = 0x48;
+    if (is_ntag(c)) {
+        static const uint8_t cc[4] = {0xE1, 0x10, 0x12, 0x00};
+        memcpy(page_ptr(c, 3), cc, 4);
+        page_ptr(c, NTAG_CFG0_PAGE)[0] = 0x04;
+        page_ptr(c, NTAG_CFG0_PAGE)[3] = cfg->auth0;
+        page_ptr(c, NTAG_CFG1_PAGE)[0] = cfg->read_protect ? 0x80 : 0x00;
+        memcpy(page_ptr(c, NTAG_PWD_PAGE), cfg->pwd, 4);
+        memcpy(page_ptr(c, NTAG_PACK_PAGE), cfg->pack, 2);
+    }
+}
+
+int mfrc522_emu_add_card(const mfrc522_emu_card_t *card) {
+    if (emu.card_count >= MFRC522_EMU_MAX_CARDS) return -1;
+    picc_t *c = &emu.cards[emu.card_count];
+    memset(c, 0, sizeof *c);
+    c->cfg = *card;
+    c->in_field = true;
+    picc_format(c);
+    picc_reset(c);
+    return emu.card_count++;
+}
+
+void mfrc522_emu_remove_cards(void) {
+    emu.card_count = 0;
+}
+
+void mfrc522_emu_set_present(int index, bool present) {
+    if (index < 0 || index >= emu.card_count) return;
+    picc_t *c = &emu.cards[index];
+    c->in_field = present;
+    c->removed = false;
+    c->frames_heard = 0;
+    c->cfg.present_from_us = 0;
+    c->cfg.present_until_us = 0;
+    c->cfg.remove_after_frames = 0;
+    picc_reset(c);
+}
+
+uint8_t *mfrc522_emu_memory(int index) {
+    if (index < 0 || index >= emu.card_count) return NULL;
+    return emu.cards[index].mem;
+}
+
+void mfrc522_emu_get_stats(mfrc522_emu_stats_t *stats) {
+    *stats = emu.stats;
+}
+
+void mfrc522_emu_reset_stats(void) {
+    memset(&emu.stats, 0, sizeof emu.stats);
+}
@@ -0,0 +1,127 @@
+/**
+ * @file mfrc522_emu.h
+ * @brief Emulador do MFRC522 no nível de registradores, com cartões virtuais
+ * no campo, para o build de host. Implementa spi_write_blocking() e
+ * spi_write_read_blocking() e observa o chip select via gpio_put(), de modo
+ * que inc/rfid/mfrc522.c e tag_data_handler.c rodem sem alterações contra ele.
+ *
+ * Do lado do MFRC522 modela: protocolo SPI (leitura em rajada, escrita com
+ * vários bytes), FIFO de 64 bytes, CommandReg (Idle, CalcCRC, Transceive,
+ * MFAuthent, SoftReset, soft power-down), ComIrq/DivIrq e o pino IRQ, timer
+ * com TAuto, coprocessador de CRC, TxLastBits/RxAlign, colisões (ErrorReg,
+ * CollReg) e o ganho do receptor (RFCfgReg).
+ *
+ * Do lado dos cartões (ISO/IEC 14443-3 A): estados IDLE/READY/ACTIVE/HALT,
+ * REQA/WUPA, anticolisão e SELECT em até dois níveis (UID de 4 ou 7 bytes),
+ * HLTA; MIFARE Classic 1K (autenticação por chave A/B, READ, WRITE, INC, DEC,
+ * RESTORE, TRANSFER); Ultralight e NTAG213 (READ, WRITE, COMPATIBILITY WRITE,
+ * FAST_READ, PWD_AUTH).
+ *
+ * Não modela: a criptografia Crypto1 em si (só o estado autenticado e o bit
+ * MFCrypto1On), os bits de acesso do Classic, CRC por hardware na transmissão
+ * (TxModeReg/RxModeReg), autoteste, comandos Mem/Generate RandomID/Receive e
+ * os alertas de nível da FIFO.
+ */
+#ifndef MFRC522_EMU_H
+#define MFRC522_EMU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MFRC522_EMU_MAX_CARDS 4
+#define MFRC522_EMU_NO_IRQ (-1)
+
+typedef enum {
+    MFRC522_EMU_CLASSIC_1K,   // SAK 0x08, 64 blocos de 16 bytes
+    MFRC522_EMU_ULTRALIGHT,   // SAK 0x00, 16 páginas, sem FAST_READ/PWD_AUTH
+    MFRC522_EMU_NTAG213       // SAK 0x00, 45 páginas, senha a partir de AUTH0
+} mfrc522_emu_card_type_t;
+
+typedef struct {
+    mfrc522_emu_card_type_t type;
+    uint8_t uid[7];
+    uint8_t uid_size;            // 4 ou 7
+    uint32_t write_us;           // Programação da EEPROM antes do ACK
+    uint8_t min_rx_gain;         // RxGain (0..7) abaixo do qual a resposta se perde
+
+    // NTAG213: páginas a partir de auth0 exigem PWD_AUTH (0xFF = nenhuma);
+    // com read_protect, também para leitura
+    uint8_t pwd[4];
+    uint8_t pack[2];
+    uint8_t auth0;
+    bool read_protect;
+
+    // Presença: no campo entre present_from_us e present_until_us (tempo de
+    // time_us_64(); 0 = sempre). Depois de remove_after_frames quadros o
+    // cartão sai do campo e a resposta ao último se perde: ele executa o
+    // comando (ex.: grava o bloco), mas o leitor não vê o ACK. 0 = nunca.
+    // Com tear_writes, uma gravação (WRITE do Classic, página do
+    // Ultralight/NTAG) no último quadro fica pela metade, como uma EEPROM que
+    // perdeu a alimentação. INCREMENT/TRANSFER continuam atômicos.
+    uint64_t present_from_us;
+    uint64_t present_until_us;
+    uint32_t remove_after_frames;
+    bool tear_writes;
+} mfrc522_emu_card_t;
+
+typedef struct {
+    uint8_t version;             // VersionReg (0x92 = MFRC522 v2.0)
+    uint32_t osc_start_us;       // PowerDown em CommandReg após reset/power-down
+    uint32_t fdt_us;             // Tempo de resposta do cartão (FDT)
+    uint32_t auth_us;            // MFAuthent: as três passadas da autenticação
+    uint32_t card_power_up_us;   // Campo ligado antes de o cartão responder
+} mfrc522_emu_config_t;
+
+typedef struct {
+    uint32_t cs_selects;         // Transações SPI (bordas de descida do CS)
+    uint64_t spi_bytes;
+    uint64_t bus_ns;             // Tempo de barramento estimado pelo baud rate
+    uint32_t reg_reads;
+    uint32_t reg_writes;
+    uint32_t commands[16];       // Por código escrito em CommandReg
+    uint32_t frames;             // Quadros enviados ao cartão (Transceive)
+    uint32_t responses;          // Quadros com resposta do cartão
+    uint32_t timeouts;           // TimerIRq sem resposta
+    uint32_t collisions;
+    uint32_t auths;              // MFAuthent aceitos
+    uint32_t auth_failures;
+    uint64_t air_us;             // Quadros no ar, FDT e programação da EEPROM
+} mfrc522_emu_stats_t;
+
+// Valores padrão: versão 0x92, FDT de 90 us, MFAuthent de 1 ms
+void mfrc522_emu_default_config(mfrc522_emu_config_t *cfg);
+
+/**
+ * @brief Cria (ou recria) o leitor emulado, sem cartões, ligado ao chip select
+ * cs_gpio e ao pino IRQ irq_gpio (MFRC522_EMU_NO_IRQ se não ligado). O leitor
+ * começa como depois de ligar a alimentação. Chame antes de PCD_Init().
+ */
+bool mfrc522_emu_attach(const mfrc522_emu_config_t *cfg, unsigned cs_gpio, int irq_gpio);
+void mfrc522_emu_detach(void);
+
+/**
+ * @brief Preenche um cartão de fábrica: chaves FF..FF e bits de acesso de
+ * transporte (Classic), CC e AUTH0 = 0xFF (NTAG), tempos de gravação típicos.
+ */
+void mfrc522_emu_card_default(mfrc522_emu_card_t *card, mfrc522_emu_card_type_t type,
+                              const uint8_t *uid, uint8_t uid_size);
+
+/**
+ * @brief Põe um cartão no campo. A memória começa como a de fábrica (bloco 0
+ * ou páginas 0..2 com o UID, trailers, configuração do NTAG).
+ * @return Índice do cartão, -1 se já houver MFRC522_EMU_MAX_CARDS.
+ */
+int mfrc522_emu_add_card(const mfrc522_emu_card_t *card);
+void mfrc522_emu_remove_cards(void);
+
+// Tira ou recoloca um cartão no campo agora (volta ao estado IDLE). Desfaz
+// present_*_us e remove_after_frames.
+void mfrc522_emu_set_present(int index, bool present);
+
+// Memória do cartão (blocos do Classic ou páginas do Ultralight/NTAG)
+uint8_t *mfrc522_emu_memory(int index);
+
+void mfrc522_emu_get_stats(mfrc522_emu_stats_t *stats);
+void mfrc522_emu_reset_stats(void);
+
+#endif // MFRC522_EMU_H
@@ -0,0 +1,956 @@
+/**
+ * @file mfrc522_emu_bench.c
+ * @brief Exercita o driver do MFRC522 (inc/rfid/mfrc522.c), o
+ * tag_data_handler e o card_detect contra o emulador (mfrc522_emu.c), com
+ * relógio virtual: os tempos impressos são os do alvo a MFRC522_BIT_RATE,
+ * com os quadros no ar a 106 kbit/s.
+ *
+ * Sequência:
+ *   1. PCD_Init, VersionReg, PCD_WarmInit quente e com o chip recém-ligado
+ *   2. CRC_A no coprocessador do MFRC522 contra o cálculo em software
+ *   3. MIFARE Classic: gravação do registro e três embarques
+ *   4. Chave errada (timeout) e nova seleção com a chave certa
+ *   5. NTAG213 com senha (FAST_READ), registro e cópia corrompidos, e
+ *      Ultralight (READ comum)
+ *   6. Inventário de vários cartões, com UIDs que colidem nos bits 8 e 9
+ *   7. Cartão retirado no meio do embarque, em cada quadro possível, com a
+ *      gravação desse quadro pela metade: o registro v3 e o contador v4
+ *      continuam legíveis, com a contagem antiga ou a nova
+ *   8. Latência do toque com o agendador do card_detect
+ *   9. Toque repetido dentro da janela do recent_taps e cartão parado no
+ *      leitor depois que o campo volta ao modo ocioso
+ *  10. Provisionamento em lote: lista na RAM, gravação conferida por cartão
+ *  11. Registro v4 (CRC_A): embarques, rota negada, contador corrompido,
+ *      leitura de tags v3 e corrupções aceitas por v3 e v4
+ *  12. Contador em bloco de valor: migração do v3 no embarque (bit 0x80 em
+ *      data_version), INCREMENT + TRANSFER, saturação e bloco corrompido
+ *
+ * Três executáveis saem deste arquivo:
+ *   mfrc522_emu_bench          pino IRQ + WFE, CRC em software (padrão)
+ *   mfrc522_emu_bench_poll     MFRC522_USE_IRQ=0: polling de ComIrqReg
+ *   mfrc522_emu_bench_chipcrc  MFRC522_SOFT_CRC=0: CRC no coprocessador
+ *
+ * Uso: mfrc522_emu_bench [-v]   (-v imprime as estatísticas do emulador)
+ * Retorna 0 se todas as verificações passaram.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mfrc522_emu.h"
+#include "mfrc522.h"
+#include "tag_data_handler.h"
+#include "card_detect.h"
+#include "recent_taps.h"
+#include "provisioning.h"
+#include "hardware/spi.h"
+#include "pico/time.h"
+
+static int failures = 0;
+static bool verbose = false;
+
+#define CHECK(cond, ...)                       \
+    do {                                       \
+        if (!(cond)) {                         \
+            printf("  FALHA: " __VA_ARGS__);   \
+            printf("  (%s:%d)\n", __FILE__, __LINE__); \
+            failures++;                        \
+        }                                      \
+    } while (0)
+
+#define RECORD_BLOCK 4
+
+static mfrc522_emu_config_t emu_cfg;
+static const uint8_t ntag_pwd[4] = {0x12, 0x34, 0x56, 0x78};
+
+/* ---- Medição ---- */
+
+static mfrc522_emu_stats_t m_stats;
+static uint64_t m_t0;
+
+static void measure_begin(void) {
+    mfrc522_emu_get_stats(&m_stats);
+    m_t0 = time_us_64();
+}
+
+static uint64_t measure_end(const char *label) {
+    mfrc522_emu_stats_t s;
+    mfrc522_emu_get_stats(&s);
+    uint64_t us = time_us_64() - m_t0;
+    printf("[HOST] %-34s %7.2f ms  %4lu transacoes SPI  %5llu bytes  %3lu quadros\n", label,
+           us / 1E3, (unsigned long)(s.cs_selects - m_stats.cs_selects),
+           (unsigned long long)(s.spi_bytes - m_stats.spi_bytes),
+           (unsigned long)(s.frames - m_stats.frames));
+    return us;
+}
+
+static void print_stats(void) {
+    if (!verbose) return;
+    mfrc522_emu_stats_t s;
+    mfrc522_emu_get_stats(&s);
+    printf("       emulador: %lu leituras, %lu escritas de registrador, barramento %.2f ms, "
+           "ar %.2f ms\n",
+           (unsigned long)s.reg_reads, (unsigned long)s.reg_writes, s.bus_ns / 1E6, s.air_us / 1E3);
+    printf("       %lu quadros, %lu respostas, %lu timeouts, %lu colisoes, %lu/%lu autenticacoes\n",
+           (unsigned long)s.frames, (unsigned long)s.responses, (unsigned long)s.timeouts,
+           (unsigned long)s.collisions, (unsigned long)s.auths,
+           (unsigned long)(s.auths + s.auth_failures));
+}
+
+/* ---- Cartões ---- */
+
+static int add_card(mfrc522_emu_card_type_t type, const uint8_t *uid, uint8_t uid_size,
+                    bool with_pwd, uint32_t remove_after) {
+    mfrc522_emu_card_t card;
+    mfrc522_emu_card_default(&card, type, uid, uid_size);
+    if (with_pwd) {
+        memcpy(card.pwd, ntag_pwd, sizeof card.pwd);
+        card.pack[0] = 0xAB;
+        card.pack[1] = 0xCD;
+        card.auth0 = 4;  // Registro e cópia protegidos
+        card.read_protect = true;
+    }
+    card.remove_after_frames = remove_after;
+    return mfrc522_emu_add_card(&card);
+}
+
+// Registro novo (contador em 0) e cópia, direto na memória do cartão
+static void put_record(int idx, mfrc522_emu_card_type_t type, uint32_t id, const char *name) {
+    StudentDataBlock data;
+    Tdh_PrepareNewStudentTag(&data, id, name);
+    uint8_t *mem = mfrc522_emu_memory(idx);
+    if (type == MFRC522_EMU_CLASSIC_1K) {
+        memcpy(mem + 16 * RECORD_BLOCK, data.buffer, 16);
+        memcpy(mem + 16 * (RECORD_BLOCK + 1), data.buffer, 16);
+    } else {
+        memcpy(mem + 4 * TDH_UL_RECORD_PAGE, data.buffer, 16);
+        memcpy(mem + 4 * TDH_UL_BACKUP_PAGE, data.buffer, 16);
+    }
+}
+
+// Bloco de valor MIFARE: valor, ~valor, valor e o endereço quatro vezes
+static void put_value(uint8_t *block, int32_t value, uint8_t addr) {
+    for (int i = 0; i < 4; i++) {
+        uint8_t b = (uint8_t)((uint32_t)value >> (8 * i));
+        block[i] = block[i + 8] = b;
+        block[i + 4] = (uint8_t)~b;
+    }
+    block[12] = block[14] = addr;
+    block[13] = block[15] = (uint8_t)~addr;
+}
+
+// Classic v4 recém-provisionado: identidade e contador em 0
+static void put_v4(int idx, const TdhV4Identity *ident) {
+    uint8_t *mem = mfrc522_emu_memory(idx);
+    memcpy(mem + 16 * RECORD_BLOCK, ident->buffer, sizeof ident->buffer);
+    put_value(mem + 16 * (RECORD_BLOCK + TDH_V4_COUNTER_OFFSET), 0, RECORD_BLOCK + TDH_V4_COUNTER_OFFSET);
+}
+
+// Contagem gravada num Classic v3: no registro ou, com
+// TDH_VALUE_COUNTER_FLAG, no bloco de valor
+static int32_t stored_trips(int idx) {
+    const uint8_t *mem = mfrc522_emu_memory(idx);
+    const StudentDataBlock *rec = (const StudentDataBlock *)(mem + 16 * RECORD_BLOCK);
+    if (!(rec->fields.data_version & TDH_VALUE_COUNTER_FLAG)) return rec->fields.trip_count;
+    uint32_t v;
+    memcpy(&v, mem + 16 * (RECORD_BLOCK + TDH_VALUE_BLOCK_OFFSET), sizeof v);
+    return (int32_t)v;
+}
+
+static bool select_any(MFRC522Ptr_t mfrc) {
+    return PICC_IsNewCardPresent(mfrc) && PICC_ReadCardSerial(mfrc);
+}
+
+// Um toque como no laço da aplicação: inventário, um embarque por cartão
+static unsigned tap(MFRC522Ptr_t mfrc, const uint8_t *pwd, TdhStudentRecord *last) {
+    Uid uids[MFRC522_EMU_MAX_CARDS];
+    uint8_t n = PICC_Inventory(mfrc, uids, MFRC522_EMU_MAX_CARDS);
+    unsigned ok = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        if (PICC_WakeupAndSelect(mfrc, &uids[i]) == STATUS_OK &&
+            Tdh_BoardAnyCard(mfrc, RECORD_BLOCK, NULL, pwd, 1, last) == STATUS_OK) {
+            ok++;
+        }
+        PICC_HaltA(mfrc);
+    }
+    return ok;
+}
+
+/* ---- Etapas ---- */
+
+static MFRC522Ptr_t step_init(void) {
+    printf("[HOST] 1. Inicializacao\n");
+    mfrc522_emu_default_config(&emu_cfg);
+    mfrc522_emu_attach(&emu_cfg, cs_pin, IRQ_PIN);
+    MFRC522Ptr_t mfrc = MFRC522_Init();
+
+    measure_begin();
+    PCD_Init(mfrc, spi0);
+    measure_end("PCD_Init");
+    CHECK(PCD_ReadRegister(mfrc, VersionReg) == 0x92, "VersionReg\n");
+    CHECK(PCD_GetAntennaGain(mfrc) == RxGain_33dB, "ganho apos o reset\n");
+
+    // Reinício do RP2040 com o leitor alimentado: registros preservados
+    measure_begin();
+    bool warm = PCD_WarmInit(mfrc, spi0);
+    measure_end("PCD_WarmInit (leitor configurado)");
+    CHECK(warm, "partida quente nao reconheceu o leitor\n");
+
+    // Leitor recém-ligado: cai no PCD_Init completo
+    mfrc522_emu_attach(&emu_cfg, cs_pin, IRQ_PIN);
+    measure_begin();
+    warm = PCD_WarmInit(mfrc, spi0);
+    measure_end("PCD_WarmInit (leitor recem-ligado)");
+    CHECK(!warm, "partida quente com o leitor sem configuracao\n");
+    CHECK(PCD_ReadRegister(mfrc, TModeReg) == 0x80, "TModeReg apos o PCD_Init\n");
+    sleep_ms(CD_FIELD_SETTLE_MS);  // Cartões energizam com o campo recém-ligado
+    return mfrc;
+}
+
+static void step_crc(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 2. CRC_A\n");
+    uint8_t data[18] = {PICC_CMD_MF_READ, RECORD_BLOCK};
+    for (uint8_t len = 1; len <= sizeof data; len += 3) {
+        for (uint8_t i = 2; i < len; i++) data[i] = (uint8_t)(i * 37 + len);
+        uint8_t chip[2] = {0}, soft[2] = {0};
+        CHECK(PCD_CalculateCRCOnChip(mfrc, data, len, chip) == STATUS_OK, "CalcCRC (%u)\n", len);
+        PCD_CalculateCRCSoft(data, len, soft);
+        CHECK(chip[0] == soft[0] && chip[1] == soft[1], "CRC de %u bytes: %02X%02X x %02X%02X\n",
+              len, chip[0], chip[1], soft[0], soft[1]);
+    }
+    // Exemplo do ISO/IEC 14443-3, anexo B: 12 34 -> CRC_A 0xCF26
+    uint8_t sample[2] = {0x12, 0x34}, crc[2] = {0};
+    measure_begin();
+    PCD_CalculateCRCOnChip(mfrc, sample, 2, crc);
+    measure_end("CalcCRC no coprocessador (2 bytes)");
+    CHECK(crc[0] == 0x26 && crc[1] == 0xCF, "CRC_A do exemplo: %02X%02X\n", crc[0], crc[1]);
+}
+
+static void step_classic(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 3. MIFARE Classic 1K\n");
+    static const uint8_t uid[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+    mfrc522_emu_remove_cards();
+    int idx = add_card(MFRC522_EMU_CLASSIC_1K, uid, 4, false, 0);
+
+    measure_begin();
+    bool found = select_any(mfrc);
+    measure_end("REQA + anticolisao + SELECT");
+    CHECK(found && mfrc->uid.size == 4 && !memcmp(mfrc->uid.uidByte, uid, 4), "selecao\n");
+    CHECK(mfrc->uid.sak == 0x08, "SAK %02X\n", mfrc->uid.sak);
+
+    StudentDataBlock data;
+    Tdh_PrepareNewStudentTag(&data, 4242, "MARIA");
+    measure_begin();
+    StatusCode st = Tdh_WriteStudentData(mfrc, &data, RECORD_BLOCK, NULL);
+    measure_end("Tdh_WriteStudentData");
+    CHECK(st == STATUS_OK, "gravacao: %s\n", GetStatusCodeName(st));
+    PICC_HaltA(mfrc);
+
+    uint8_t *mem = mfrc522_emu_memory(idx);
+    CHECK(!memcmp(mem + 16 * RECORD_BLOCK, data.buffer, 16), "bloco %d\n", RECORD_BLOCK);
+    CHECK(!memcmp(mem + 16 * (RECORD_BLOCK + 1), data.buffer, 16), "copia\n");
+
+    // Em HALT o cartão ignora o REQA: cada toque o afasta e aproxima de novo
+    TdhStudentRecord read;
+    for (int i = 1; i <= 3; i++) {
+        mfrc522_emu_set_present(idx, true);
+        memset(&read, 0, sizeof read);
+        measure_begin();
+        unsigned ok = tap(mfrc, NULL, &read);
+        measure_end(i == 1 ? "Embarque (toque completo)" : "Embarque");
+        CHECK(ok == 1 && read.trip_count == (uint32_t)i, "embarque %d: %u ok, contagem %lu\n", i, ok,
+              (unsigned long)read.trip_count);
+    }
+    CHECK(read.student_id == 4242 && !strcmp(read.student_name, "MARIA"),
+          "registro lido\n");
+    CHECK(stored_trips(idx) == 3, "contagem gravada %ld\n", (long)stored_trips(idx));
+    // Só o bloco 0 e os trailers além do registro
+    CHECK(mem[16 * 7 + 6] == 0xFF && mem[16 * 7 + 9] == 0x69, "trailer do setor 1 alterado\n");
+    print_stats();
+}
+
+static void step_wrong_key(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 4. Chave errada\n");
+    MIFARE_Key wrong = {{0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5}};
+    StudentDataBlock read;
+
+    mfrc522_emu_set_present(0, true);
+    CHECK(select_any(mfrc), "selecao\n");
+    measure_begin();
+    StatusCode st = Tdh_ReadStudentData(mfrc, &read, RECORD_BLOCK, &wrong);
+    measure_end("Autenticacao recusada");
+    CHECK(st == STATUS_TIMEOUT, "chave errada: %s\n", GetStatusCodeName(st));
+
+    // O cartão voltou para IDLE: nova seleção antes de tentar de novo
+    CHECK(select_any(mfrc), "nova selecao\n");
+    st = Tdh_ReadStudentData(mfrc, &read, RECORD_BLOCK, NULL);
+    CHECK(st == STATUS_OK && read.fields.trip_count == 3, "chave certa: %s\n",
+          GetStatusCodeName(st));
+    PICC_HaltA(mfrc);
+}
+
+static void step_ultralight(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 5. NTAG213 e Ultralight\n");
+    static const uint8_t ntag_uid[7] = {0x04, 0x51, 0x72, 0x9A, 0x3C, 0x5D, 0x80};
+    static const uint8_t ul_uid[7] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    static const uint8_t bad_pwd[4] = {0, 0, 0, 0};
+    StudentDataBlock data, read;
+    TdhStudentRecord rec;
+
+    mfrc522_emu_remove_cards();
+    int idx = add_card(MFRC522_EMU_NTAG213, ntag_uid, 7, true, 0);
+    CHECK(select_any(mfrc) && mfrc->uid.size == 7 && !memcmp(mfrc->uid.uidByte, ntag_uid, 7),
+          "selecao do NTAG213\n");
+    Tdh_PrepareNewStudentTag(&data, 77, "JOAO");
+    StatusCode st = Tdh_UlWriteStudentData(mfrc, &data, ntag_pwd);
+    CHECK(st == STATUS_OK, "gravacao no NTAG213: %s\n", GetStatusCodeName(st));
+    CHECK(!memcmp(mfrc522_emu_memory(idx) + 4 * TDH_UL_RECORD_PAGE, data.buffer, 16),
+          "paginas do registro\n");
+    PICC_HaltA(mfrc);
+
+    mfrc522_emu_set_present(idx, true);
+    measure_begin();
+    unsigned ok = tap(mfrc, ntag_pwd, &rec);
+    measure_end("Embarque NTAG213 (PWD + FAST_READ)");
+    CHECK(ok == 1 && rec.trip_count == 1, "embarque no NTAG213\n");
+
+    // Registro corrompido: o embarque conta a partir da cópia e regrava as
+    // 4 páginas do registro; cópia corrompida é refeita do registro
+    uint8_t *mem = mfrc522_emu_memory(idx);
+    uint8_t *record = mem + 4 * TDH_UL_RECORD_PAGE, *backup = mem + 4 * TDH_UL_BACKUP_PAGE;
+    for (uint32_t copy = 0; copy < 2; copy++) {
+        (copy ? backup : record)[5] ^= 0x20;
+        for (uint32_t n = 2 + 2 * copy; n <= 3 + 2 * copy; n++) {
+            mfrc522_emu_set_present(idx, true);
+            ok = tap(mfrc, ntag_pwd, &rec);
+            CHECK(ok == 1 && rec.trip_count == n && !memcmp(record, backup, 16),
+                  "%s, embarque %lu: contagem %lu\n", copy ? "copia corrompida" : "registro corrompido",
+                  (unsigned long)n, (unsigned long)rec.trip_count);
+        }
+    }
+
+    mfrc522_emu_set_present(idx, true);
+    CHECK(select_any(mfrc), "nova selecao do NTAG213\n");
+    st = Tdh_BoardAnyCard(mfrc, RECORD_BLOCK, NULL, bad_pwd, 1, &rec);
+    CHECK(st != STATUS_OK, "senha errada aceita\n");
+    CHECK(select_any(mfrc), "selecao apos a senha errada\n");
+    st = Tdh_UlReadStudentData(mfrc, &read, NULL);
+    CHECK(st != STATUS_OK, "leitura protegida sem senha\n");
+    PICC_HaltA(mfrc);
+
+    mfrc522_emu_remove_cards();
+    idx = add_card(MFRC522_EMU_ULTRALIGHT, ul_uid, 7, false, 0);
+    CHECK(select_any(mfrc), "selecao do Ultralight\n");
+    Tdh_PrepareNewStudentTag(&data, 78, "ANA");
+    CHECK(Tdh_UlWriteStudentData(mfrc, &data, NULL) == STATUS_OK, "gravacao no Ultralight\n");
+    PICC_HaltA(mfrc);
+
+    // Sem FAST_READ: NAK, nova seleção e READ comum
+    mfrc522_emu_set_present(idx, true);
+    measure_begin();
+    ok = tap(mfrc, NULL, &rec);
+    measure_end("Embarque Ultralight (READ)");
+    CHECK(ok == 1 && rec.trip_count == 1, "embarque no Ultralight\n");
+}
+
+static void step_inventory(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 6. Varios cartoes no campo\n");
+    // A e B diferem no bit 8 do UID, A e C no bit 9
+    static const uint8_t uids[3][4] = {
+        {0x10, 0x22, 0x33, 0x44}, {0x10, 0x23, 0x33, 0x44}, {0x10, 0x20, 0x35, 0x46}};
+    static const uint8_t ntag_uid[7] = {0x04, 0x9C, 0x01, 0x02, 0x03, 0x04, 0x05};
+
+    mfrc522_emu_remove_cards();
+    for (int i = 0; i < 3; i++) {
+        int idx = add_card(MFRC522_EMU_CLASSIC_1K, uids[i], 4, false, 0);
+        put_record(idx, MFRC522_EMU_CLASSIC_1K, 100 + i, "ALUNO");
+    }
+    int idx = add_card(MFRC522_EMU_NTAG213, ntag_uid, 7, false, 0);
+    put_record(idx, MFRC522_EMU_NTAG213, 200, "ALUNO");
+
+    Uid found[MFRC522_EMU_MAX_CARDS];
+    measure_begin();
+    uint8_t n = PICC_Inventory(mfrc, found, MFRC522_EMU_MAX_CARDS);
+    measure_end("PICC_Inventory (4 cartoes)");
+    CHECK(n == 4, "inventario achou %u cartoes\n", n);
+    for (int i = 0; i < 3; i++) {
+        bool seen = false;
+        for (uint8_t j = 0; j < n; j++) {
+            seen |= found[j].size == 4 && !memcmp(found[j].uidByte, uids[i], 4);
+        }
+        CHECK(seen, "cartao %d fora do inventario\n", i);
+    }
+
+    TdhStudentRecord read;
+    unsigned ok = 0;
+    measure_begin();
+    for (uint8_t i = 0; i < n; i++) {
+        if (PICC_WakeupAndSelect(mfrc, &found[i]) == STATUS_OK &&
+            Tdh_BoardAnyCard(mfrc, RECORD_BLOCK, NULL, NULL, 1, &read) == STATUS_OK) {
+            ok++;
+        }
+        PICC_HaltA(mfrc);
+    }
+    measure_end("Embarque dos 4 cartoes");
+    CHECK(ok == 4, "%u de 4 embarques\n", ok);
+
+    // Todos em HALT: o toque seguinte (REQA) não vê ninguém
+    CHECK(PICC_Inventory(mfrc, found, MFRC522_EMU_MAX_CARDS) == 0, "cartoes fora de HALT\n");
+    print_stats();
+}
+
+// Cartão do teste de retirada: v3 ou, no Classic, v4 (só a rota 1). A
+// gravação do quadro em que ele sai fica pela metade.
+static int torn_card(mfrc522_emu_card_type_t type, bool v4, const uint8_t *uid, uint8_t uid_size,
+                     uint32_t remove_after) {
+    mfrc522_emu_card_t card;
+    mfrc522_emu_card_default(&card, type, uid, uid_size);
+    card.remove_after_frames = remove_after;
+    card.tear_writes = true;
+    int idx = mfrc522_emu_add_card(&card);
+    if (v4) {
+        TdhV4Identity ident;
+        Tdh_PrepareV4Identity(&ident, 300, "TORN", 1u << 0);
+        put_v4(idx, &ident);
+    } else {
+        put_record(idx, type, 300, "TORN");
+    }
+    return idx;
+}
+
+// Frames de um toque completo (inventário + embarque + HLTA) num cartão
+static uint32_t tap_frames(MFRC522Ptr_t mfrc, mfrc522_emu_card_type_t type, bool v4, const uint8_t *uid,
+                           uint8_t uid_size) {
+    mfrc522_emu_remove_cards();
+    torn_card(type, v4, uid, uid_size, 0);
+    mfrc522_emu_stats_t before, after;
+    mfrc522_emu_get_stats(&before);
+    TdhStudentRecord read;
+    CHECK(tap(mfrc, NULL, &read) == 1, "toque de referencia\n");
+    mfrc522_emu_get_stats(&after);
+    return (after.frames - before.frames) + (after.commands[PCD_MFAuthent] -
+                                             before.commands[PCD_MFAuthent]);
+}
+
+static void step_torn(MFRC522Ptr_t mfrc, mfrc522_emu_card_type_t type, bool v4, const char *label) {
+    static const uint8_t uid4[4] = {0x5A, 0x17, 0xC0, 0x3E};
+    static const uint8_t uid7[7] = {0x04, 0x7E, 0x22, 0x31, 0x40, 0x5F, 0x60};
+    const uint8_t *uid = type == MFRC522_EMU_CLASSIC_1K ? uid4 : uid7;
+    uint8_t uid_size = type == MFRC522_EMU_CLASSIC_1K ? 4 : 7;
+
+    uint32_t total = tap_frames(mfrc, type, v4, uid, uid_size);
+    unsigned counted = 0;
+    for (uint32_t n = 1; n <= total; n++) {
+        mfrc522_emu_remove_cards();
+        int idx = torn_card(type, v4, uid, uid_size, n);
+        TdhStudentRecord rec;
+        tap(mfrc, NULL, &rec);
+
+        // Cartão de volta ao campo: o registro precisa continuar legível.
+        // O v4 é conferido com a rota 2, negada: lê a contagem sem gravar
+        mfrc522_emu_set_present(idx, true);
+        StatusCode st = STATUS_ERROR;
+        uint32_t id = 0, count = 0;
+        if (select_any(mfrc)) {
+            if (v4) {
+                memset(&rec, 0, sizeof rec);
+                st = Tdh_BoardAnyCard(mfrc, RECORD_BLOCK, NULL, NULL, 2, &rec);
+                if (st == STATUS_OK && (rec.version != 4 || !rec.route_denied)) st = STATUS_ERROR;
+                id = rec.student_id;
+                count = rec.trip_count;
+            } else {
+                StudentDataBlock read;
+                memset(&read, 0, sizeof read);
+                st = type == MFRC522_EMU_CLASSIC_1K
+                         ? Tdh_ReadStudentData(mfrc, &read, RECORD_BLOCK, NULL)
+                         : Tdh_UlReadStudentData(mfrc, &read, NULL);
+                id = read.fields.student_id;
+                count = read.fields.trip_count;
+            }
+        }
+        PICC_HaltA(mfrc);
+        CHECK(st == STATUS_OK && id == 300 && count <= 1, "%s retirado no quadro %lu: %s, contagem %lu\n",
+              label, (unsigned long)n, GetStatusCodeName(st), (unsigned long)count);
+        counted += count == 1;
+    }
+    printf("[HOST] %s retirado em cada um dos %lu quadros: %u com o embarque gravado\n", label,
+           (unsigned long)total, counted);
+}
+
+static void step_latency(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 8. Latencia do toque (card_detect)\n");
+    static const uint8_t uid[4] = {0x42, 0x42, 0x42, 0x42};
+    const unsigned samples = 20;
+    uint64_t min = UINT64_MAX, max = 0, sum = 0;
+
+    cd_config_t cd;
+    for (unsigned i = 0; i < samples; i++) {
+        mfrc522_emu_remove_cards();
+        Cd_Init(mfrc, NULL);
+        Cd_GetConfig(&cd);
+        mfrc522_emu_card_t card;
+        mfrc522_emu_card_default(&card, MFRC522_EMU_CLASSIC_1K, uid, 4);
+        // Chegadas espalhadas pelo intervalo ocioso
+        card.present_from_us = time_us_64() + 1000 + (uint64_t)i * cd.idle_interval_ms * 1000 / samples;
+        int idx = mfrc522_emu_add_card(&card);
+        put_record(idx, MFRC522_EMU_CLASSIC_1K, 400, "TAP");
+
+        TdhStudentRecord read;
+        unsigned ok = 0;
+        while (!ok && time_us_64() < card.present_from_us + 2000000) {
+            MFRC522Ptr_t reader = Cd_WaitForSlot();
+            ok = tap(reader, NULL, &read);
+            Cd_EndSlot(ok > 0);
+        }
+        CHECK(ok == 1, "toque %u nao registrado\n", i);
+        uint64_t us = time_us_64() - card.present_from_us;
+        if (us < min) min = us;
+        if (us > max) max = us;
+        sum += us;
+    }
+    printf("[HOST] Toque -> embarque gravado (intervalo ocioso %lu ms): min %.1f ms, media %.1f ms, "
+           "max %.1f ms\n",
+           (unsigned long)cd.idle_interval_ms, min / 1E3, sum / 1E3 / samples, max / 1E3);
+    // Pior caso: chega logo depois do REQA de uma janela e espera a próxima
+    CHECK(max <= (cd.idle_interval_ms + 200) * 1000ull, "latencia maxima %.1f ms\n", max / 1E3);
+}
+
+// Uma janela do laço da aplicação: inventário no leitor da janela, e quem
+// continua no leitor desde o último ciclo do campo não é lido de novo
+static unsigned app_slot(void) {
+    MFRC522Ptr_t reader = Cd_WaitForSlot();
+    Uid uids[MFRC522_EMU_MAX_CARDS];
+    uint8_t n = PICC_Inventory(reader, uids, MFRC522_EMU_MAX_CARDS);
+    unsigned novos = 0, ok = 0;
+    TdhStudentRecord read;
+    for (uint8_t c = 0; c < n; c++) {
+        if (Cd_IsPresent(&uids[c])) continue;
+        novos++;
+        if (Rtp_IsRecent(&uids[c])) {
+            Cd_MarkPresent(&uids[c]);
+            continue;
+        }
+        if (PICC_WakeupAndSelect(reader, &uids[c]) == STATUS_OK &&
+            Tdh_BoardAnyCard(reader, RECORD_BLOCK, NULL, NULL, 1, &read) == STATUS_OK) {
+            Rtp_Remember(&uids[c]);
+            Cd_MarkPresent(&uids[c]);
+            ok++;
+        }
+        PICC_HaltA(reader);
+    }
+    Cd_EndSlot(novos > 0);
+    return ok;
+}
+
+static void step_repeat(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 9. Toque repetido\n");
+    static const uint8_t uid[4] = {0x0D, 0x0E, 0x0A, 0x0D};
+    static rtp_table_t table;
+    Rtp_Init(&table, RTP_WINDOW_MS);
+
+    mfrc522_emu_remove_cards();
+    int idx = add_card(MFRC522_EMU_CLASSIC_1K, uid, 4, false, 0);
+    put_record(idx, MFRC522_EMU_CLASSIC_1K, 500, "REPETE");
+
+    // Como no laço da aplicação: a tabela é consultada logo após o inventário
+    for (int i = 0; i < 3; i++) {
+        mfrc522_emu_set_present(idx, true);
+        measure_begin();
+        Uid uids[MFRC522_EMU_MAX_CARDS];
+        uint8_t n = PICC_Inventory(mfrc, uids, MFRC522_EMU_MAX_CARDS);
+        TdhStudentRecord read;
+        for (uint8_t c = 0; c < n; c++) {
+            if (Rtp_IsRecent(&uids[c])) continue;
+            if (PICC_WakeupAndSelect(mfrc, &uids[c]) == STATUS_OK &&
+                Tdh_BoardAnyCard(mfrc, RECORD_BLOCK, NULL, NULL, 1, &read) == STATUS_OK) {
+                Rtp_Remember(&uids[c]);
+            }
+            PICC_HaltA(mfrc);
+        }
+        measure_end(i ? "Toque repetido (so o UID)" : "Primeiro toque");
+        CHECK(n == 1, "toque %d: inventario com %u cartoes\n", i, n);
+    }
+    CHECK(stored_trips(idx) == 1 && table.suppressed == 2,
+          "repeticoes: contagem %ld, %lu suprimidos\n", (long)stored_trips(idx),
+          (unsigned long)table.suppressed);
+
+    // Depois da janela o cartão volta a embarcar
+    sleep_ms(RTP_WINDOW_MS);
+    mfrc522_emu_set_present(idx, true);
+    TdhStudentRecord read;
+    CHECK(!Rtp_IsRecent(&mfrc->uid), "UID ainda na janela\n");
+    CHECK(tap(mfrc, NULL, &read) == 1 && stored_trips(idx) == 2,
+          "embarque apos a janela: contagem %ld\n", (long)stored_trips(idx));
+
+    // Tabela cheia: sai o embarque mais antigo
+    Rtp_Clear();
+    Uid u = {.size = 4};
+    for (uint32_t i = 0; i <= RTP_TABLE_SIZE; i++) {
+        memcpy(u.uidByte, &i, 4);
+        Rtp_Remember(&u);
+        sleep_ms(1);
+    }
+    uint32_t first = 0, last = RTP_TABLE_SIZE;
+    memcpy(u.uidByte, &first, 4);
+    CHECK(!Rtp_IsRecent(&u) && table.evicted == 1, "LRU: o mais antigo continua na tabela\n");
+    memcpy(u.uidByte, &last, 4);
+    CHECK(Rtp_IsRecent(&u), "LRU: o mais recente nao entrou\n");
+
+    // Cartão apoiado no leitor, com a janela do recent_taps desligada: o
+    // campo volta ao modo ocioso e religa a cada janela, mas o cartão só
+    // embarca de novo depois de sair do leitor
+    Rtp_Init(&table, 0);
+    Cd_Init(mfrc, NULL);
+    cd_config_t cd;
+    Cd_GetConfig(&cd);
+    mfrc522_emu_set_present(idx, true);
+    int32_t before = stored_trips(idx);
+    uint64_t until = time_us_64() + (cd.active_hold_ms + 5 * cd.idle_interval_ms) * 1000ull;
+    unsigned boarded = 0;
+    while (time_us_64() < until) boarded += app_slot();
+    cd_stats_t stats;
+    Cd_GetStats(&stats);
+    CHECK(boarded == 1 && stored_trips(idx) == before + 1 && !stats.active,
+          "cartao parado no leitor: %u embarques, modo %s\n", boarded, stats.active ? "ativo" : "ocioso");
+
+    mfrc522_emu_set_present(idx, false);
+    for (int i = 0; i < 2; i++) app_slot();
+    mfrc522_emu_set_present(idx, true);
+    boarded = 0;
+    for (int i = 0; i < 2; i++) boarded += app_slot();
+    CHECK(boarded == 1 && stored_trips(idx) == before + 2, "cartao de volta ao leitor: %u embarques\n",
+          boarded);
+}
+
+// Um cartão no campo, como no modo de provisionamento da aplicação
+static StatusCode provision_one(MFRC522Ptr_t mfrc, prv_entry_t **assigned) {
+    Uid uids[MFRC522_EMU_MAX_CARDS];
+    *assigned = NULL;
+    if (PICC_Inventory(mfrc, uids, MFRC522_EMU_MAX_CARDS) != 1) return STATUS_ERROR;
+    prv_entry_t *e = Prv_Assign(&uids[0]);
+    if (!e || e->state == PRV_DONE) {
+        *assigned = e;
+        return STATUS_ERROR;
+    }
+    StatusCode st = PICC_WakeupAndSelect(mfrc, &uids[0]);
+    if (st == STATUS_OK) st = Tdh_ProvisionAnyCard(mfrc, RECORD_BLOCK, NULL, NULL, &e->ident);
+    PICC_HaltA(mfrc);
+    Prv_Complete(e, &uids[0], st == STATUS_OK);
+    *assigned = e;
+    return st;
+}
+
+static void step_provision(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 10. Provisionamento em lote\n");
+    static const uint8_t bound_uid[4] = {0xB0, 0x0B, 0x1E, 0x55};
+    enum { STUDENTS = 12 };
+    char line[64];
+
+    CHECK(Prv_Reset(STUDENTS), "lista de %d alunos nao alocada\n", STUDENTS);
+    CHECK(Prv_AddLine("# uid,id,nome\n") && Prv_Count() == 0, "comentario virou aluno\n");
+    CHECK(Prv_AddLine("B00B1E55, 100, ANA BEATRIZ SOUZA, 1/3\r\n"), "linha com UID recusada\n");
+    CHECK(!Prv_AddLine("B00B1E55,200,OUTRO"), "UID repetido aceito\n");
+    CHECK(!Prv_AddLine("B00B1E,201,CURTO"), "UID de 3 bytes aceito\n");
+    CHECK(!Prv_AddLine(",abc,SEMID"), "ID invalido aceito\n");
+    CHECK(!Prv_AddLine(",202,ROTA,33"), "rota 33 aceita\n");
+    for (int i = 1; i < STUDENTS; i++) {
+        snprintf(line, sizeof line, ",%d,ALUNO%02d\n", 100 + i, i);
+        CHECK(Prv_AddLine(line), "linha sem UID recusada: %s", line);
+    }
+    CHECK(Prv_Count() == STUDENTS, "%lu alunos na lista\n", (unsigned long)Prv_Count());
+    CHECK(!Prv_AddLine(",299,SOBRA"), "lista cheia aceitou aluno\n");
+
+    // Um cartão por vez, Classic e NTAG alternados; o cartão da linha com
+    // UID chega no meio do lote e recebe o seu aluno
+    uint64_t total_us = 0;
+    int idx = -1;
+    prv_entry_t *e;
+    for (int i = 0; i < STUDENTS; i++) {
+        mfrc522_emu_card_type_t type = (i & 1) ? MFRC522_EMU_NTAG213 : MFRC522_EMU_CLASSIC_1K;
+        uint8_t uid[7] = {0x04, 0xC0, (uint8_t)i, 0x11, 0x22, 0x33, 0x44};
+        mfrc522_emu_remove_cards();
+        idx = i == STUDENTS / 2 ? add_card(MFRC522_EMU_CLASSIC_1K, bound_uid, 4, false, 0)
+                                : add_card(type, uid, 7, false, 0);
+        measure_begin();
+        StatusCode st = provision_one(mfrc, &e);
+        if (i < 2) {
+            total_us += measure_end(i ? "Cartao provisionado (NTAG213)" : "Cartao provisionado (Classic)");
+        } else {
+            total_us += time_us_64() - m_t0;
+        }
+        CHECK(st == STATUS_OK && e, "cartao %d: %s\n", i, GetStatusCodeName(st));
+        if (st != STATUS_OK || !e) continue;
+        // Classic recebe o v4; NTAG, o v3 com o nome truncado
+        const uint8_t *mem = mfrc522_emu_memory(idx);
+        if (i != STUDENTS / 2 && type == MFRC522_EMU_NTAG213) {
+            StudentDataBlock v3;
+            Tdh_PrepareNewStudentTag(&v3, e->ident.fields.student_id, e->ident.fields.student_name);
+            CHECK(!memcmp(mem + 4 * TDH_UL_RECORD_PAGE, v3.buffer, 16), "cartao %d: registro v3\n", i);
+        } else {
+            uint8_t zero[16];
+            put_value(zero, 0, RECORD_BLOCK + TDH_V4_COUNTER_OFFSET);
+            CHECK(!memcmp(mem + 16 * RECORD_BLOCK, e->ident.buffer, 32) &&
+                      !memcmp(mem + 16 * (RECORD_BLOCK + TDH_V4_COUNTER_OFFSET), zero, 16),
+                  "cartao %d: registro v4\n", i);
+        }
+        if (i == STUDENTS / 2) {
+            CHECK(e->ident.fields.student_id == 100 && e->ident.fields.route_bitmap == 0x5 &&
+                      !strcmp(e->ident.fields.student_name, "ANA BEATRIZ SOUZA"),
+                  "UID da lista ficou com o ID %lu\n", (unsigned long)e->ident.fields.student_id);
+        }
+    }
+    printf("[HOST] Media por cartao %.1f ms: 1000 cartoes em %.0f s de RF, fora a troca de cartao\n",
+           total_us / 1E3 / STUDENTS, total_us / 1E3 / STUDENTS);
+    CHECK(Prv_Done() == STUDENTS, "%lu de %d gravados\n", (unsigned long)Prv_Done(), STUDENTS);
+
+    // O mesmo cartão de novo: reconhecido pelo UID, não é regravado
+    mfrc522_emu_set_present(idx, true);
+    StatusCode st = provision_one(mfrc, &e);
+    CHECK(st != STATUS_OK && e && e->state == PRV_DONE, "cartao repetido regravado\n");
+    // Cartão a mais: não sobrou aluno
+    static const uint8_t extra[4] = {0xEE, 0xEE, 0xEE, 0x01};
+    mfrc522_emu_remove_cards();
+    add_card(MFRC522_EMU_CLASSIC_1K, extra, 4, false, 0);
+    CHECK(provision_one(mfrc, &e) != STATUS_OK && !e, "cartao fora da lista gravado\n");
+
+    // Retirado no meio: a falha aparece na conferência e o aluno continua
+    // reservado para o próximo cartão (ou o mesmo, de novo)
+    Prv_Reset(1);
+    Prv_AddLine(",300,RETIRA");
+    // UID de 10 bytes não cabe no aluno: recusado, não fica com o livre
+    Uid longo = {.size = 10, .uidByte = {0x88, 1, 2, 3, 4, 5, 6, 7, 8, 9}};
+    CHECK(!Prv_Assign(&longo), "UID de 10 bytes recebeu aluno\n");
+    static const uint8_t torn[4] = {0x70, 0x12, 0x34, 0x56};
+    mfrc522_emu_remove_cards();
+    idx = add_card(MFRC522_EMU_CLASSIC_1K, torn, 4, false, 12);
+    st = provision_one(mfrc, &e);
+    CHECK(st != STATUS_OK && e && e->state == PRV_FAILED, "retirada nao detectada: %s\n",
+          GetStatusCodeName(st));
+    mfrc522_emu_remove_cards();
+    idx = add_card(MFRC522_EMU_CLASSIC_1K, torn, 4, false, 0);
+    st = provision_one(mfrc, &e);
+    CHECK(st == STATUS_OK && e && e->ident.fields.student_id == 300 && Prv_Done() == 1,
+          "nova tentativa: %s\n", GetStatusCodeName(st));
+    print_stats();
+}
+
+// Um embarque com Tdh_BoardAnyCard(), como no laço da aplicação
+static StatusCode board(MFRC522Ptr_t mfrc, int idx, uint8_t route, TdhStudentRecord *rec) {
+    mfrc522_emu_set_present(idx, true);
+    memset(rec, 0, sizeof *rec);
+    if (!select_any(mfrc)) return STATUS_TIMEOUT;
+    StatusCode st = Tdh_BoardAnyCard(mfrc, RECORD_BLOCK, NULL, NULL, route, rec);
+    PICC_HaltA(mfrc);
+    return st;
+}
+
+// xorshift32: corrupções reproduzíveis
+static uint32_t rng_state = 2463534242u;
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void step_v4(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 11. Registro v4\n");
+    static const uint8_t uid[4] = {0x4C, 0x52, 0x43, 0x16};
+    TdhV4Identity ident;
+    TdhStudentRecord rec;
+    Tdh_PrepareV4Identity(&ident, 90210, "JOAO PEDRO DA SILVA", 1u << 1);  // Só a rota 2
+    CHECK(!strcmp(ident.fields.student_name, "JOAO PEDRO DA SIL"), "nome truncado: %s\n",
+          ident.fields.student_name);
+
+    mfrc522_emu_remove_cards();
+    int idx = add_card(MFRC522_EMU_CLASSIC_1K, uid, 4, false, 0);
+    CHECK(select_any(mfrc) && Tdh_ProvisionAnyCard(mfrc, RECORD_BLOCK, NULL, NULL, &ident) == STATUS_OK,
+          "provisionamento v4\n");
+    PICC_HaltA(mfrc);
+    uint8_t *mem = mfrc522_emu_memory(idx);
+    const uint8_t counter_block = RECORD_BLOCK + TDH_V4_COUNTER_OFFSET;
+    uint8_t *counter = mem + 16 * counter_block;
+    uint8_t expect[16];
+
+    for (uint32_t i = 1; i <= 3; i++) {
+        measure_begin();
+        StatusCode st = board(mfrc, idx, 2, &rec);
+        if (i == 1) measure_end("Embarque v4 (toque completo)");
+        CHECK(st == STATUS_OK && rec.version == 4 && rec.trip_count == i && !rec.route_denied,
+              "embarque v4 %lu: %s, contagem %lu\n", (unsigned long)i, GetStatusCodeName(st),
+              (unsigned long)rec.trip_count);
+    }
+    CHECK(rec.student_id == 90210 && !strcmp(rec.student_name, "JOAO PEDRO DA SIL"), "identidade lida\n");
+    put_value(expect, 3, counter_block);
+    CHECK(!memcmp(counter, expect, 16), "contador gravado\n");
+    CHECK(!memcmp(mem + 16 * RECORD_BLOCK, ident.buffer, sizeof ident.buffer), "identidade regravada\n");
+
+    // Rota fora do mapa: nada é gravado
+    StatusCode st = board(mfrc, idx, 5, &rec);
+    CHECK(st == STATUS_OK && rec.route_denied && rec.trip_count == 3 && !memcmp(counter, expect, 16),
+          "rota 5 aceita\n");
+
+    // Contador ilegível: recusado, sem INCREMENT e sem voltar a zero
+    counter[5] ^= 0x01;
+    memcpy(expect, counter, 16);
+    st = board(mfrc, idx, 2, &rec);
+    CHECK(st == STATUS_CRC_WRONG && !memcmp(counter, expect, 16), "contador corrompido: %s\n",
+          GetStatusCodeName(st));
+    counter[5] ^= 0x01;
+
+    // Identidade ilegível: recusada, e o contador não é tocado
+    mem[16 * RECORD_BLOCK + 9] ^= 0x40;
+    st = board(mfrc, idx, 2, &rec);
+    put_value(expect, 3, counter_block);
+    CHECK(st == STATUS_CRC_WRONG && !memcmp(counter, expect, 16), "identidade corrompida: %s\n",
+          GetStatusCodeName(st));
+
+    // Tag v3 lida pelo mesmo caminho; ID com o byte do formato do v4
+    mfrc522_emu_remove_cards();
+    idx = add_card(MFRC522_EMU_CLASSIC_1K, uid, 4, false, 0);
+    put_record(idx, MFRC522_EMU_CLASSIC_1K, 0x000100C4, "ANTIGO");
+    measure_begin();
+    st = board(mfrc, idx, 2, &rec);
+    measure_end("Embarque v3 por Tdh_BoardAnyCard");
+    CHECK(st == STATUS_OK && rec.version == 3 && rec.trip_count == 1 && rec.student_id == 0x000100C4 &&
+              !strcmp(rec.student_name, "ANTIGO"), "v3: %s, versao %u\n", GetStatusCodeName(st), rec.version);
+
+    // Corrupções aleatórias de 1 a 4 bits, lidas por Tdh_BoardAnyCard():
+    // quantas passam como registro válido em cada formato
+    enum { TRIALS = 2000 };
+    StudentDataBlock v3_ok;
+    Tdh_PrepareNewStudentTag(&v3_ok, 4242, "MARIA");
+    unsigned accepted[2] = {0, 0};
+    // As recusas do tag_data_handler vão para /dev/null durante o laço
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    for (int v4 = 0; v4 < 2; v4++) {
+        const uint8_t *good = v4 ? ident.buffer : v3_ok.buffer;
+        size_t len = v4 ? sizeof ident.buffer : sizeof v3_ok.buffer;
+        for (int t = 0; t < TRIALS; t++) {
+            uint8_t bad[32];
+            memcpy(bad, good, len);
+            for (int f = 1 + (int)(rng() % 4); f > 0; f--) {
+                uint32_t r = rng();
+                bad[r % len] ^= (uint8_t)(1u << ((r >> 8) % 8));
+            }
+            if (!memcmp(bad, good, len)) continue;  // Bits desfeitos: não é corrupção
+            memcpy(mem + 16 * RECORD_BLOCK, bad, len);
+            if (!v4) memset(mem + 16 * (RECORD_BLOCK + 1), 0, 16);  // Sem a cópia, só o checksum decide
+            if (board(mfrc, idx, 2, &rec) == STATUS_OK && !rec.route_denied) accepted[v4]++;
+        }
+    }
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    close(null_fd);
+    printf("[HOST] Corrupcoes aceitas como validas: v3 (XOR) %u de %d, v4 (CRC_A) %u de %d\n",
+           accepted[0], TRIALS, accepted[1], TRIALS);
+    CHECK(accepted[1] == 0, "v4 aceitou %u corrupcoes\n", accepted[1]);
+    print_stats();
+}
+
+static void step_value_counter(MFRC522Ptr_t mfrc) {
+    printf("[HOST] 12. Contador em bloco de valor\n");
+    static const uint8_t uid[4] = {0x7A, 0x1C, 0x0C, 0x38};
+    const uint8_t value_block = RECORD_BLOCK + TDH_VALUE_BLOCK_OFFSET;
+    TdhStudentRecord rec;
+    StudentDataBlock read;
+
+    mfrc522_emu_remove_cards();
+    int idx = add_card(MFRC522_EMU_CLASSIC_1K, uid, 4, false, 0);
+    put_record(idx, MFRC522_EMU_CLASSIC_1K, 600, "VALOR");
+    uint8_t *mem = mfrc522_emu_memory(idx);
+    uint8_t *value = mem + 16 * value_block;
+    StudentDataBlock *stored = (StudentDataBlock *)(mem + 16 * RECORD_BLOCK);
+
+    // Primeiro embarque: migra, com a viagem já no bloco de valor
+    measure_begin();
+    StatusCode st = board(mfrc, idx, 1, &rec);
+    measure_end("Embarque v3 com migracao");
+    uint8_t expect[16];
+    put_value(expect, 1, value_block);
+    CHECK(st == STATUS_OK && rec.version == 3 && rec.trip_count == 1, "migracao: %s, contagem %lu\n",
+          GetStatusCodeName(st), (unsigned long)rec.trip_count);
+    CHECK(stored->fields.data_version == (3 | TDH_VALUE_COUNTER_FLAG) && stored->fields.trip_count == 0,
+          "registro migrado: versao %02X\n", stored->fields.data_version);
+    CHECK(!memcmp(value, expect, 16), "bloco de valor apos a migracao\n");
+    CHECK(!memcmp(mem + 16 * (RECORD_BLOCK + 1), stored->buffer, 16), "copia diferente do registro migrado\n");
+
+    // O bit volta na leitura e o contador sai do bloco de valor
+    mfrc522_emu_set_present(idx, true);
+    CHECK(select_any(mfrc), "selecao\n");
+    st = Tdh_ReadStudentData(mfrc, &read, RECORD_BLOCK, NULL);
+    PICC_HaltA(mfrc);
+    CHECK(st == STATUS_OK && read.fields.data_version == (3 | TDH_VALUE_COUNTER_FLAG) &&
+              read.fields.trip_count == 1 && read.fields.student_id == 600,
+          "leitura do registro migrado: %s\n", GetStatusCodeName(st));
+
+    // Embarques seguintes: INCREMENT + TRANSFER, o registro não é regravado
+    uint8_t record[32];
+    memcpy(record, stored->buffer, sizeof record);
+    for (uint32_t i = 2; i <= 3; i++) {
+        measure_begin();
+        st = board(mfrc, idx, 1, &rec);
+        if (i == 2) measure_end("Embarque (INCREMENT + TRANSFER)");
+        put_value(expect, (int32_t)i, value_block);
+        CHECK(st == STATUS_OK && rec.trip_count == i && !memcmp(value, expect, 16),
+              "incremento %lu: %s, contagem %lu\n", (unsigned long)i, GetStatusCodeName(st),
+              (unsigned long)rec.trip_count);
+    }
+    CHECK(!memcmp(record, stored->buffer, sizeof record), "registro regravado no incremento\n");
+
+    // trip_count tem 8 bits: satura em 255, o bloco de valor continua contando
+    put_value(value, 300, value_block);
+    st = board(mfrc, idx, 1, &rec);
+    CHECK(st == STATUS_OK && rec.trip_count == 255 && stored_trips(idx) == 301,
+          "saturacao: %lu, gravado %ld\n", (unsigned long)rec.trip_count, (long)stored_trips(idx));
+
+    // Bloco de valor corrompido: recusado, sem INCREMENT
+    value[4] ^= 0x01;
+    memcpy(expect, value, 16);
+    st = board(mfrc, idx, 1, &rec);
+    CHECK(st == STATUS_CRC_WRONG && !memcmp(value, expect, 16), "bloco de valor corrompido: %s\n",
+          GetStatusCodeName(st));
+    print_stats();
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "v")) != -1) {
+        switch (opt) {
+            case 'v': verbose = true; break;
+            default:
+                fprintf(stderr, "Uso: %s [-v]\n", argv[0]);
+                return 2;
+        }
+    }
+    host_clock_set_virtual(true);
+    printf("[HOST] MFRC522 emulado: IRQ %s, CRC %s, SPI a %u Hz\n",
+           MFRC522_USE_IRQ ? "por pino" : "por polling",
+           MFRC522_SOFT_CRC ? "em software" : "no MFRC522", (unsigned)MFRC522_BIT_RATE);
+
+    MFRC522Ptr_t mfrc = step_init();
+    step_crc(mfrc);
+    step_classic(mfrc);
+    step_wrong_key(mfrc);
+    step_ultralight(mfrc);
+    step_inventory(mfrc);
+    printf("[HOST] 7. Cartao retirado no meio do embarque\n");
+    step_torn(mfrc, MFRC522_EMU_CLASSIC_1K, false, "Classic v3");
+    step_torn(mfrc, MFRC522_EMU_CLASSIC_1K, true, "Classic v4");
+    step_torn(mfrc, MFRC522_EMU_NTAG213, false, "NTAG213");
+    step_latency(mfrc);
+    step_repeat(mfrc);
+    step_provision(mfrc);
+    step_v4(mfrc);
+    step_value_counter(mfrc);
+
+    mfrc522_emu_detach();
+    printf("%s (%d falhas)\n", failures ? "FALHOU" : "OK", failures);
+    return failures ? 1 : 0;
+}
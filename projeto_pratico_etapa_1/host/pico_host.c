@@ -0,0 +1,227 @@
+/**
+ * @file pico_host.c
+ * @brief Implementação mínima, para Linux, das funções do Pico SDK usadas
+ * pelo FatFs_SPI, pelo sd_card_handler e pela biblioteca do MFRC522 (tempo,
+ * GPIO e interrupções de GPIO, SPI, mutex, debug).
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pico/stdlib.h"
+#include "pico/mutex.h"
+#include "hardware/spi.h"
+#include "my_debug.h"
+#include "ff.h"
+
+// --- Tempo ---
+
+static uint64_t host_boot_us = 0;
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+// Relógio virtual (benchmarks sobre o emulador): o tempo só anda com os bytes
+// do barramento e com sleep/busy_wait, então os números não dependem da CPU
+// do host e as esperas não custam tempo real.
+static bool virtual_clock = false;
+static uint64_t virtual_ns = 0;
+
+void host_clock_set_virtual(bool on) { virtual_clock = on; }
+void host_clock_advance_ns(uint64_t ns) { virtual_ns += ns; }
+
+uint64_t time_us_64(void) {
+    if (virtual_clock) return virtual_ns / 1000;
+    if (!host_boot_us) host_boot_us = monotonic_us();
+    return monotonic_us() - host_boot_us;
+}
+uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+absolute_time_t get_absolute_time(void) { return time_us_64(); }
+uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) { return t + (uint64_t)ms * 1000; }
+absolute_time_t make_timeout_time_us(uint64_t us) { return delayed_by_us(get_absolute_time(), us); }
+absolute_time_t make_timeout_time_ms(uint32_t ms) { return delayed_by_ms(get_absolute_time(), ms); }
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+void sleep_us(uint64_t us) {
+    if (virtual_clock) {
+        host_clock_advance_ns(us * 1000);
+        return;
+    }
+    struct timespec ts = {.tv_sec = us / 1000000u, .tv_nsec = (us % 1000000u) * 1000u};
+    while (nanosleep(&ts, &ts)) {
+    }
+}
+void sleep_ms(uint32_t ms) { sleep_us((uint64_t)ms * 1000); }
+
+// Espera ativa: mais precisa que nanosleep para latências curtas injetadas
+void busy_wait_us(uint64_t us) {
+    if (virtual_clock) {
+        host_clock_advance_ns(us * 1000);
+        return;
+    }
+    uint64_t end = time_us_64() + us;
+    while (time_us_64() < end) {
+    }
+}
+void busy_wait_us_32(uint32_t us) { busy_wait_us(us); }
+
+bool time_reached(absolute_time_t t) { return time_us_64() >= t; }
+
+void sleep_until(absolute_time_t t) {
+    uint64_t now = time_us_64();
+    if (t > now) sleep_us(t - now);
+}
+
+// Sem emulador ligado, o "evento" é só a passagem do tempo
+void (*host_wfe_hook)(absolute_time_t deadline) = NULL;
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp) {
+    if (host_wfe_hook) {
+        host_wfe_hook(timeout_timestamp);
+    } else if (!time_reached(timeout_timestamp)) {
+        sleep_us(1);
+    }
+    return time_reached(timeout_timestamp);
+}
+
+// --- GPIO: tabela de níveis em memória ---
+
+static bool gpio_level[NUM_BANK0_GPIOS];
+void (*host_gpio_put_hook)(uint gpio, bool value) = NULL;
+
+void gpio_init(uint gpio) {
+    if (gpio < NUM_BANK0_GPIOS) gpio_level[gpio] = false;
+}
+void gpio_set_dir(uint gpio, bool out) { (void)gpio; (void)out; }
+void gpio_put(uint gpio, bool value) {
+    if (gpio < NUM_BANK0_GPIOS) gpio_level[gpio] = value;
+    if (host_gpio_put_hook) host_gpio_put_hook(gpio, value);
+}
+bool gpio_get(uint gpio) { return gpio < NUM_BANK0_GPIOS ? gpio_level[gpio] : false; }
+void gpio_set_function(uint gpio, enum gpio_function fn) { (void)gpio; (void)fn; }
+// Entrada sem ninguém dirigindo fica no nível do pull
+void gpio_pull_up(uint gpio) {
+    if (gpio < NUM_BANK0_GPIOS) gpio_level[gpio] = true;
+}
+void gpio_pull_down(uint gpio) {
+    if (gpio < NUM_BANK0_GPIOS) gpio_level[gpio] = false;
+}
+void gpio_disable_pulls(uint gpio) { (void)gpio; }
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive) {
+    (void)gpio;
+    (void)drive;
+}
+
+// --- Interrupções de GPIO ---
+
+static uint32_t gpio_irq_enabled[NUM_BANK0_GPIOS];
+static uint32_t gpio_irq_events[NUM_BANK0_GPIOS];
+static irq_handler_t gpio_irq_handler[NUM_BANK0_GPIOS];
+static bool bank0_irq_enabled = false;
+
+void irq_set_enabled(unsigned num, bool enabled) {
+    if (num == IO_IRQ_BANK0) bank0_irq_enabled = enabled;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+    if (gpio >= NUM_BANK0_GPIOS) return;
+    gpio_irq_events[gpio] &= ~events;  // O SDK limpa as bordas pendentes
+    if (enabled) {
+        gpio_irq_enabled[gpio] |= events;
+    } else {
+        gpio_irq_enabled[gpio] &= ~events;
+    }
+}
+
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler) {
+    if (gpio < NUM_BANK0_GPIOS) gpio_irq_handler[gpio] = handler;
+}
+
+uint32_t gpio_get_irq_event_mask(uint gpio) {
+    return gpio < NUM_BANK0_GPIOS ? gpio_irq_events[gpio] & gpio_irq_enabled[gpio] : 0;
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t events) {
+    if (gpio < NUM_BANK0_GPIOS) gpio_irq_events[gpio] &= ~events;
+}
+
+void host_gpio_drive(uint gpio, bool value) {
+    if (gpio >= NUM_BANK0_GPIOS || gpio_level[gpio] == value) return;
+    gpio_level[gpio] = value;
+    uint32_t event = value ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (!(gpio_irq_enabled[gpio] & event)) return;
+    gpio_irq_events[gpio] |= event;
+    // Roda "na interrupção": dentro do gpio_put/SPI de quem estiver no laço
+    if (bank0_irq_enabled && gpio_irq_handler[gpio]) gpio_irq_handler[gpio]();
+}
+
+// --- SPI: apenas guarda o baud rate de cada instância ---
+
+static uint spi_baudrate[2];
+
+static uint *spi_baud_slot(const spi_inst_t *spi) {
+    return &spi_baudrate[spi == spi1 ? 1 : 0];
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate) { return spi_set_baudrate(spi, baudrate); }
+void spi_deinit(spi_inst_t *spi) { *spi_baud_slot(spi) = 0; }
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate) {
+    *spi_baud_slot(spi) = baudrate;
+    return baudrate;
+}
+uint spi_get_baudrate(const spi_inst_t *spi) { return *spi_baud_slot(spi); }
+
+// --- Mutex ---
+
+void mutex_init(mutex_t *mtx) {
+    pthread_mutex_init(&mtx->m, NULL);
+    mtx->initialized = true;
+}
+bool mutex_is_initialized(mutex_t *mtx) { return mtx->initialized; }
+void mutex_enter_blocking(mutex_t *mtx) { pthread_mutex_lock(&mtx->m); }
+bool mutex_try_enter(mutex_t *mtx, uint32_t *owner_out) {
+    (void)owner_out;
+    return pthread_mutex_trylock(&mtx->m) == 0;
+}
+void mutex_exit(mutex_t *mtx) { pthread_mutex_unlock(&mtx->m); }
+
+// --- my_debug.c (a versão do alvo usa instruções ARM) ---
+
+void my_printf(const char *pcFormat, ...) {
+    va_list xArgs;
+    va_start(xArgs, pcFormat);
+    vprintf(pcFormat, xArgs);
+    va_end(xArgs);
+    fflush(stdout);
+}
+
+void my_assert_func(const char *file, int line, const char *func,
+                    const char *pred) {
+    printf("assertion \"%s\" failed: file \"%s\", line %d, function: %s\n",
+           pred, file, line, func);
+    fflush(stdout);
+    abort();
+}
+
+// --- rtc.c: o FatFs usa o relógio do host para as datas dos arquivos ---
+
+DWORD get_fattime(void) {
+    time_t now = time(NULL);
+    struct tm t;
+    localtime_r(&now, &t);
+    return ((DWORD)(t.tm_year + 1900 - 1980) << 25) |
+           ((DWORD)(t.tm_mon + 1) << 21) |
+           ((DWORD)t.tm_mday << 16) |
+           ((DWORD)t.tm_hour << 11) |
+           ((DWORD)t.tm_min << 5) |
+           ((DWORD)t.tm_sec / 2);
+}
@@ -0,0 +1,585 @@
+/**
+ * @file sd_emu.c
+ * @brief Emulador de cartão SD no nível do barramento SPI (build de host).
+ *
+ * Cada byte trocado em spi_transfer() passa por sd_emu_clock(): primeiro sai
+ * o próximo byte da fila de saída (MISO) e depois o byte recebido (MOSI)
+ * alimenta a máquina de estados de entrada. Assim o atraso NCR, os tokens de
+ * dados e o sinal de ocupado aparecem exatamente como num cartão real,
+ * inclusive quando o driver lê vários bytes de uma vez.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sd_emu.h"
+#include "spi.h"
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+#include "pico/time.h"
+
+#define EMU_BLOCK_SIZE 512
+#define EMU_OUT_SIZE 1024   // Maior resposta: Nac + token + 512 + CRC
+
+// Estado da entrada (MOSI)
+typedef enum {
+    RX_CMD,            // Esperando/recebendo um frame de comando
+    RX_WRITE_TOKEN,    // Após CMD24/25: esperando o token de início
+    RX_WRITE_DATA      // Recebendo bloco + CRC16
+} rx_state_t;
+
+static struct {
+    bool attached;
+    bool present;
+    sd_emu_config_t cfg;
+    unsigned cs_gpio;
+    uint8_t *mem;
+
+    // Estado do protocolo
+    bool selected;
+    bool spi_mode;       // false até o primeiro CMD0 com CS baixo
+    bool idle;           // Bit "in idle state" do R1
+    bool crc_on;
+    bool app_cmd;        // Último comando foi CMD55
+    uint32_t acmd41_polls;
+
+    // Entrada
+    rx_state_t rx;
+    uint8_t cmd[6];
+    int cmd_len;
+    bool multi_write;
+    uint32_t write_block;
+    uint8_t wbuf[EMU_BLOCK_SIZE + 2];
+    int wlen;
+
+    // Saída
+    uint8_t out[EMU_OUT_SIZE];
+    int out_len, out_pos;
+    bool streaming;      // CMD18 em andamento
+    uint32_t stream_block;
+
+    // Ocupado: termina quando o tempo de barramento OU o tempo real passar
+    bool busy;
+    uint32_t busy_us;
+    uint64_t busy_start_bus_ns;
+    uint64_t busy_start_wall_us;
+
+    // Contadores para a injeção de erros
+    uint32_t reads_seen, writes_seen, cmds_seen;
+
+    sd_emu_stats_t stats;
+} emu;
+
+/* ********************************************************************** */
+// CRCs implementados aqui, e não com crc.c, para que o emulador também
+// verifique o driver.
+
+static uint8_t emu_crc7(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc <<= 1;
+            if ((b ^ crc) & 0x80) crc ^= 0x09;
+            b <<= 1;
+        }
+    }
+    return crc & 0x7F;
+}
+
+static uint16_t emu_crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* ********************************************************************** */
+
+static void out_reset(void) {
+    emu.out_len = emu.out_pos = 0;
+}
+
+static void out_push(uint8_t b) {
+    if (emu.out_len < EMU_OUT_SIZE) emu.out[emu.out_len++] = b;
+}
+
+static void out_fill(uint8_t b, unsigned n) {
+    while (n--) out_push(b);
+}
+
+static void start_busy(uint32_t us) {
+    if (!us) return;
+    emu.busy = true;
+    emu.busy_us = us;
+    emu.busy_start_bus_ns = emu.stats.bus_ns;
+    emu.busy_start_wall_us = time_us_64();
+}
+
+static bool still_busy(void) {
+    if (!emu.busy) return false;
+    uint64_t limit_ns = (uint64_t)emu.busy_us * 1000;
+    if (emu.stats.bus_ns - emu.busy_start_bus_ns >= limit_ns ||
+        time_us_64() - emu.busy_start_wall_us >= emu.busy_us) {
+        emu.busy = false;
+    }
+    return emu.busy;
+}
+
+static uint8_t r1(void) {
+    return emu.idle ? 0x01 : 0x00;
+}
+
+static void push_response_start(void) {
+    uint8_t ncr = emu.cfg.ncr_bytes;
+    if (ncr < 1) ncr = 1;
+    if (ncr > 8) ncr = 8;
+    // O primeiro byte de NCR já é o próximo a sair
+    out_fill(0xFF, ncr - 1);
+}
+
+// Bloco de dados: Nac, token, dados e CRC16
+static void push_data_block(const uint8_t *data, size_t len) {
+    out_fill(0xFF, emu.cfg.nac_bytes);
+    out_push(0xFE);
+    for (size_t i = 0; i < len; i++) out_push(data[i]);
+    uint16_t crc = emu_crc16(data, len);
+    out_push(crc >> 8);
+    out_push(crc & 0xFF);
+}
+
+static void push_read_block(uint32_t block) {
+    emu.reads_seen++;
+    if (emu.cfg.error_token_at && emu.reads_seen == emu.cfg.error_token_at) {
+        out_fill(0xFF, emu.cfg.nac_bytes);
+        out_push(0x08);  // Data Error Token: out of range
+        emu.streaming = false;
+        return;
+    }
+    size_t start = (size_t)emu.out_len;
+    push_data_block(emu.mem + (size_t)block * EMU_BLOCK_SIZE, EMU_BLOCK_SIZE);
+    if (emu.cfg.corrupt_read_at && emu.reads_seen == emu.cfg.corrupt_read_at) {
+        emu.out[start + emu.cfg.nac_bytes + 1 + EMU_BLOCK_SIZE] ^= 0x5A;
+    }
+    emu.stats.blocks_read++;
+}
+
+// CSD com o mesmo layout de bits que ext_bits() em sd_card.c espera
+static void csd_set_bits(uint8_t *csd, int msb, int lsb, uint32_t value) {
+    for (int pos = lsb; pos <= msb; pos++, value >>= 1) {
+        int byte = 15 - (pos >> 3);
+        int bit = pos & 7;
+        if (value & 1)
+            csd[byte] |= (uint8_t)(1u << bit);
+        else
+            csd[byte] &= (uint8_t)~(1u << bit);
+    }
+}
+
+static void build_csd(uint8_t *csd) {
+    memset(csd, 0, 16);
+    if (emu.cfg.type == SD_EMU_SDHC) {
+        csd_set_bits(csd, 127, 126, 1);
+        csd_set_bits(csd, 83, 80, 9);                            // READ_BL_LEN
+        csd_set_bits(csd, 69, 48, emu.cfg.sectors / 1024 - 1);   // C_SIZE
+    } else {
+        csd_set_bits(csd, 127, 126, 0);
+        csd_set_bits(csd, 83, 80, 9);                            // 512 bytes
+        csd_set_bits(csd, 49, 47, 7);                            // MULT = 512
+        csd_set_bits(csd, 73, 62, emu.cfg.sectors / 512 - 1);    // C_SIZE
+    }
+    csd[15] = (uint8_t)(emu_crc7(csd, 15) << 1) | 1;
+}
+
+// Converte o argumento para número de bloco, conforme o tipo de cartão.
+// Retorna o R1 de erro, ou 0 se o endereço é válido.
+static uint8_t block_from_arg(uint32_t arg, uint32_t *block) {
+    if (emu.cfg.type == SD_EMU_SDHC) {
+        *block = arg;
+    } else {
+        if (arg % EMU_BLOCK_SIZE) return 0x20;  // Address error
+        *block = arg / EMU_BLOCK_SIZE;
+    }
+    if (*block >= emu.cfg.sectors) return 0x40;  // Parameter error
+    return 0;
+}
+
+static void handle_cmd(void) {
+    uint8_t idx = emu.cmd[0] & 0x3F;
+    uint32_t arg = ((uint32_t)emu.cmd[1] << 24) | ((uint32_t)emu.cmd[2] << 16) |
+                   ((uint32_t)emu.cmd[3] << 8) | emu.cmd[4];
+    bool acmd = emu.app_cmd;
+    emu.app_cmd = false;
+
+    // Fora do modo SPI o cartão só entende CMD0 (com CS baixo)
+    if (!emu.spi_mode && idx != 0) return;
+
+    emu.cmds_seen++;
+    if (emu.cfg.drop_cmd_at && emu.cmds_seen == emu.cfg.drop_cmd_at) return;
+
+    // CMD0 e CMD8 sempre têm CRC verificado; os demais só com CMD59 ligado
+    if ((emu.crc_on || idx == 0 || idx == 8) &&
+        (emu.cmd[5] >> 1) != emu_crc7(emu.cmd, 5)) {
+        emu.stats.crc_errors++;
+        if (emu.spi_mode) {
+            push_response_start();
+            out_push(r1() | 0x08);
+        }
+        return;
+    }
+
+    emu.stats.commands++;
+    if (acmd)
+        emu.stats.acmd_count[idx]++;
+    else
+        emu.stats.cmd_count[idx]++;
+
+    uint32_t block;
+    uint8_t err;
+
+    if (acmd) {
+        push_response_start();
+        switch (idx) {
+            case 41:  // SD_SEND_OP_COND
+                if (emu.acmd41_polls < emu.cfg.acmd41_busy_polls) {
+                    emu.acmd41_polls++;
+                } else {
+                    emu.idle = false;
+                }
+                out_push(r1());
+                break;
+            case 23:  // SET_WR_BLK_ERASE_COUNT
+                out_push(r1());
+                break;
+            default:
+                out_push(r1() | 0x04);
+                break;
+        }
+        return;
+    }
+
+    switch (idx) {
+        case 0:  // GO_IDLE_STATE
+            emu.spi_mode = true;
+            emu.idle = true;
+            emu.crc_on = false;
+            emu.acmd41_polls = 0;
+            emu.streaming = false;
+            out_reset();
+            push_response_start();
+            out_push(0x01);
+            break;
+        case 8:  // SEND_IF_COND
+            push_response_start();
+            if (emu.cfg.type == SD_EMU_SDSC_V1) {
+                out_push(r1() | 0x04);
+            } else {
+                out_push(r1());
+                out_push(0x00);
+                out_push(0x00);
+                out_push((arg >> 8) & 0x0F);
+                out_push(arg & 0xFF);
+            }
+            break;
+        case 9: {  // SEND_CSD
+            uint8_t csd[16];
+            build_csd(csd);
+            push_response_start();
+            out_push(r1());
+            push_data_block(csd, sizeof csd);
+            break;
+        }
+        case 12:  // STOP_TRANSMISSION
+            emu.streaming = false;
+            out_reset();
+            out_push(0xFF);  // Stuff byte
+            push_response_start();
+            out_push(r1());
+            start_busy(emu.cfg.stop_busy_us);
+            break;
+        case 13:  // SEND_STATUS (R2)
+            push_response_start();
+            out_push(r1());
+            out_push(0x00);
+            break;
+        case 16:  // SET_BLOCKLEN
+            push_response_start();
+            out_push(r1() | (arg == EMU_BLOCK_SIZE ? 0 : 0x40));
+            break;
+        case 17:  // READ_SINGLE_BLOCK
+        case 18:  // READ_MULTIPLE_BLOCK
+            push_response_start();
+            if (emu.idle) {
+                out_push(r1() | 0x04);
+                break;
+            }
+            if ((err = block_from_arg(arg, &block))) {
+                out_push(r1() | err);
+                break;
+            }
+            out_push(r1());
+            push_read_block(block);
+            if (idx == 18) {
+                emu.streaming = true;
+                emu.stream_block = block + 1;
+            }
+            break;
+        case 24:  // WRITE_BLOCK
+        case 25:  // WRITE_MULTIPLE_BLOCK
+            push_response_start();
+            if (emu.idle) {
+                out_push(r1() | 0x04);
+                break;
+            }
+            if ((err = block_from_arg(arg, &block))) {
+                out_push(r1() | err);
+                break;
+            }
+            out_push(r1());
+            emu.multi_write = (idx == 25);
+            emu.write_block = block;
+            emu.rx = RX_WRITE_TOKEN;
+            break;
+        case 55:  // APP_CMD
+            emu.app_cmd = true;
+            push_response_start();
+            out_push(r1());
+            break;
+        case 58: {  // READ_OCR (R3)
+            uint32_t ocr = 0x00FF8000;  // 2.7 - 3.6 V
+            if (!emu.idle) {
+                ocr |= 1u << 31;        // Power up status
+                if (emu.cfg.type == SD_EMU_SDHC) ocr |= 1u << 30;  // CCS
+            }
+            push_response_start();
+            out_push(r1());
+            out_push(ocr >> 24);
+            out_push(ocr >> 16);
+            out_push(ocr >> 8);
+            out_push(ocr);
+            break;
+        }
+        case 59:  // CRC_ON_OFF
+            emu.crc_on = arg & 1;
+            push_response_start();
+            out_push(r1());
+            break;
+        default:
+            push_response_start();
+            out_push(r1() | 0x04);  // Illegal command
+            break;
+    }
+}
+
+static void finish_write_block(void) {
+    emu.writes_seen++;
+    uint8_t status = 0x05;  // Data accepted
+    if (emu.crc_on) {
+        uint16_t crc = (uint16_t)(emu.wbuf[EMU_BLOCK_SIZE] << 8) | emu.wbuf[EMU_BLOCK_SIZE + 1];
+        if (crc != emu_crc16(emu.wbuf, EMU_BLOCK_SIZE)) {
+            status = 0x0B;  // CRC error
+            emu.stats.crc_errors++;
+        }
+    }
+    if (status == 0x05 && emu.cfg.reject_write_at && emu.writes_seen == emu.cfg.reject_write_at) {
+        status = 0x0D;  // Write error
+    }
+    if (status == 0x05 && emu.write_block >= emu.cfg.sectors) {
+        status = 0x0D;
+    }
+    if (status == 0x05) {
+        memcpy(emu.mem + (size_t)emu.write_block * EMU_BLOCK_SIZE, emu.wbuf, EMU_BLOCK_SIZE);
+        emu.stats.blocks_written++;
+        emu.write_block++;
+    }
+    out_push(0xE0 | status);
+    start_busy(emu.cfg.write_busy_us);
+    // Após um erro o cartão abandona a escrita múltipla
+    emu.rx = (emu.multi_write && status == 0x05) ? RX_WRITE_TOKEN : RX_CMD;
+}
+
+static void rx_byte(uint8_t b) {
+    switch (emu.rx) {
+        case RX_CMD:
+            if (emu.cmd_len == 0 && (b & 0xC0) != 0x40) return;
+            emu.cmd[emu.cmd_len++] = b;
+            if (emu.cmd_len == 6) {
+                emu.cmd_len = 0;
+                handle_cmd();
+            }
+            break;
+        case RX_WRITE_TOKEN:
+            if (still_busy()) return;
+            if (b == 0xFE || b == 0xFC) {
+                emu.wlen = 0;
+                emu.rx = RX_WRITE_DATA;
+            } else if (b == 0xFD && emu.multi_write) {
+                // Stop Tran: fim da escrita múltipla
+                emu.rx = RX_CMD;
+                start_busy(emu.cfg.stop_busy_us);
+            } else if ((b & 0xC0) == 0x40) {
+                // Um comando no lugar do token encerra a espera
+                emu.rx = RX_CMD;
+                rx_byte(b);
+            }
+            break;
+        case RX_WRITE_DATA:
+            emu.wbuf[emu.wlen++] = b;
+            if (emu.wlen == EMU_BLOCK_SIZE + 2) {
+                finish_write_block();
+            }
+            break;
+    }
+}
+
+static uint8_t tx_byte(void) {
+    if (emu.out_pos < emu.out_len) {
+        uint8_t b = emu.out[emu.out_pos++];
+        if (emu.out_pos == emu.out_len) out_reset();
+        return b;
+    }
+    if (emu.streaming) {
+        if (emu.stream_block >= emu.cfg.sectors) {
+            emu.streaming = false;
+        } else {
+            push_read_block(emu.stream_block++);
+            return tx_byte();
+        }
+    }
+    if (still_busy()) {
+        emu.stats.busy_bytes++;
+        return 0x00;
+    }
+    return 0xFF;
+}
+
+static uint8_t sd_emu_clock(uint8_t mosi) {
+    uint32_t baud = spi_get_baudrate(spi0);
+    uint64_t byte_ns = baud ? 8000000000ull / baud : 0;
+    emu.stats.bytes_clocked++;
+    emu.stats.bus_ns += byte_ns;
+    host_clock_advance_ns(byte_ns);
+    if (!emu.attached || !emu.present || !emu.selected) return 0xFF;
+    uint8_t miso = tx_byte();
+    rx_byte(mosi);
+    return miso;
+}
+
+static void emu_gpio_put(uint gpio, bool value) {
+    if (!emu.attached || gpio != emu.cs_gpio) return;
+    bool select = !value;
+    if (select && !emu.selected) emu.stats.cs_selects++;
+    if (!select && emu.selected) {
+        // Desselecionado: o cartão solta o DO e descarta o frame parcial.
+        // A programação em andamento (busy) continua.
+        emu.cmd_len = 0;
+        if (emu.rx == RX_WRITE_DATA) emu.rx = RX_CMD;
+        out_reset();
+    }
+    emu.selected = select;
+}
+
+/* ********************************************************************** */
+// API pública
+
+void sd_emu_default_config(sd_emu_config_t *cfg) {
+    memset(cfg, 0, sizeof *cfg);
+    cfg->type = SD_EMU_SDHC;
+    cfg->sectors = 64 * 2048;  // 64 MiB
+    cfg->ncr_bytes = 1;
+    cfg->nac_bytes = 2;
+    cfg->acmd41_busy_polls = 2;
+    cfg->write_busy_us = 250;
+    cfg->stop_busy_us = 50;
+}
+
+bool sd_emu_attach(const sd_emu_config_t *cfg, unsigned cs_gpio) {
+    sd_emu_detach();
+    uint32_t granule = cfg->type == SD_EMU_SDHC ? 1024 : 512;
+    if (!cfg->sectors || cfg->sectors % granule) {
+        printf("[SD_EMU] ERRO: capacidade deve ser multiplo de %u blocos\n", granule);
+        return false;
+    }
+    if (cfg->type != SD_EMU_SDHC && cfg->sectors > 4096u * 1024u) {
+        printf("[SD_EMU] ERRO: SDSC limitado a 2 GiB\n");
+        return false;
+    }
+    emu.mem = calloc(cfg->sectors, EMU_BLOCK_SIZE);
+    if (!emu.mem) return false;
+    emu.cfg = *cfg;
+    emu.cs_gpio = cs_gpio;
+    emu.attached = true;
+    emu.present = true;
+    host_gpio_put_hook = emu_gpio_put;
+    return true;
+}
+
+void sd_emu_detach(void) {
+    free(emu.mem);
+    memset(&emu, 0, sizeof emu);
+    host_gpio_put_hook = NULL;
+}
+
+void sd_emu_set_present(bool present) {
+    emu.present = present;
+    if (!present) {
+        // Ao ser reinserido o cartão volta ao modo SD nativo
+        emu.spi_mode = false;
+        emu.idle = true;
+        emu.streaming = false;
+        emu.busy = false;
+        emu.rx = RX_CMD;
+        emu.cmd_len = 0;
+        out_reset();
+    }
+}
+
+uint8_t *sd_emu_sector(uint32_t sector) {
+    if (!emu.mem || sector >= emu.cfg.sectors) return NULL;
+    return emu.mem + (size_t)sector * EMU_BLOCK_SIZE;
+}
+
+void sd_emu_get_stats(sd_emu_stats_t *stats) { *stats = emu.stats; }
+void sd_emu_reset_stats(void) { memset(&emu.stats, 0, sizeof emu.stats); }
+
+/* ********************************************************************** */
+// Substitui spi.c: o "DMA" é um laço byte a byte sobre o emulador
+
+bool spi_transfer(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length) {
+    (void)pSPI;
+    emu.stats.transfers++;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t b = sd_emu_clock(tx ? tx[i] : SPI_FILL_CHAR);
+        if (rx) rx[i] = b;
+    }
+    return true;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    (void)spi;
+    emu.stats.transfers++;
+    for (size_t i = 0; i < len; i++) sd_emu_clock(src[i]);
+    return (int)len;
+}
+
+void spi_lock(spi_t *pSPI) { mutex_enter_blocking(&pSPI->mutex); }
+void spi_unlock(spi_t *pSPI) { mutex_exit(&pSPI->mutex); }
+
+bool my_spi_init(spi_t *pSPI) {
+    if (!pSPI->initialized) {
+        mutex_init(&pSPI->mutex);
+        spi_init(pSPI->hw_inst, 100 * 1000);
+        pSPI->initialized = true;
+    }
+    return true;
+}
+
+void set_spi_dma_irq_channel(bool useChannel1, bool shared) {
+    (void)useChannel1;
+    (void)shared;
+}
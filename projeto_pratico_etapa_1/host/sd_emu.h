@@ -0,0 +1,74 @@
+/**
+ * @file sd_emu.h
+ * @brief Emulador de cartão SD no nível do barramento SPI, para o build de
+ * host. Implementa spi_transfer()/spi_write_blocking() e observa o chip
+ * select via gpio_put(), de modo que sd_card.c, sd_spi.c e crc.c rodem sem
+ * alterações contra ele.
+ *
+ * Modela: modo SD -> SPI (CMD0), CMD8/ACMD41/CMD58 (SDSC v1, SDSC v2, SDHC),
+ * endereçamento em bytes (SDSC) ou blocos (SDHC), CSD v1/v2, CMD17/18/24/25/12,
+ * tokens de dados, CRC7/CRC16 (CMD59), tempo de ocupado (busy) após escrita
+ * e injeção de erros.
+ */
+#ifndef SD_EMU_H
+#define SD_EMU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    SD_EMU_SDSC_V1,   // Não aceita CMD8; endereçamento em bytes
+    SD_EMU_SDSC_V2,   // Aceita CMD8; CCS = 0; endereçamento em bytes
+    SD_EMU_SDHC       // CCS = 1; endereçamento em blocos
+} sd_emu_card_type_t;
+
+typedef struct {
+    sd_emu_card_type_t type;
+    uint32_t sectors;            // Capacidade em blocos de 512 bytes
+    uint8_t ncr_bytes;           // Bytes 0xFF entre o comando e o R1 (1..8)
+    uint16_t nac_bytes;          // Bytes 0xFF antes do token de dados na leitura
+    uint16_t acmd41_busy_polls;  // ACMD41 respondidos com "idle" antes de ficar pronto
+    uint32_t write_busy_us;      // Tempo de programação por bloco escrito
+    uint32_t stop_busy_us;       // Ocupado após CMD12 / token Stop Tran
+
+    // Injeção de erros: a N-ésima ocorrência (1 = primeira); 0 = nunca
+    uint32_t corrupt_read_at;    // Bloco lido com CRC16 errado
+    uint32_t error_token_at;     // Leitura responde com Data Error Token
+    uint32_t reject_write_at;    // Escrita respondida com "write error"
+    uint32_t drop_cmd_at;        // Comando ignorado (sem R1)
+} sd_emu_config_t;
+
+typedef struct {
+    uint64_t bytes_clocked;      // Total de bytes no barramento
+    uint64_t transfers;          // Chamadas a spi_transfer/spi_write_blocking
+    uint64_t bus_ns;             // Tempo de barramento estimado pelo baud rate
+    uint64_t busy_bytes;         // Bytes lidos com o cartão ocupado
+    uint32_t cs_selects;         // Bordas de descida do chip select
+    uint32_t commands;           // Comandos aceitos (incluindo ACMDs)
+    uint32_t cmd_count[64];      // Por índice de comando (CMDn)
+    uint32_t acmd_count[64];     // Por índice de ACMD
+    uint32_t crc_errors;         // Comandos/blocos rejeitados por CRC
+    uint64_t blocks_read;
+    uint64_t blocks_written;
+} sd_emu_stats_t;
+
+// Valores padrão: SDHC de 64 MiB, NCR de 1 byte, 250 us de busy por bloco
+void sd_emu_default_config(sd_emu_config_t *cfg);
+
+/**
+ * @brief Cria (ou recria) o cartão emulado, apagado, ligado ao chip select
+ * cs_gpio. Chame antes de sd_init_driver().
+ */
+bool sd_emu_attach(const sd_emu_config_t *cfg, unsigned cs_gpio);
+void sd_emu_detach(void);
+
+// "Remove" o cartão: o barramento passa a ler só 0xFF
+void sd_emu_set_present(bool present);
+
+// Acesso direto à memória do cartão (verificação nos testes)
+uint8_t *sd_emu_sector(uint32_t sector);
+
+void sd_emu_get_stats(sd_emu_stats_t *stats);
+void sd_emu_reset_stats(void);
+
+#endif // SD_EMU_H
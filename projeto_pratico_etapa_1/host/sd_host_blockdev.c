@@ -0,0 +1,263 @@
+/**
+ * @file sd_host_blockdev.c
+ * @brief Cartão SD sobre arquivo de imagem para o build de host.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sd_host_blockdev.h"
+#include "hw_config.h"
+#include "diskio.h"  // STA_NOINIT, STA_NODISK
+
+static int img_fd = -1;
+static uint8_t *img_map = NULL;   // != NULL quando usando mmap
+static uint64_t img_size = 0;
+
+static sd_host_faults_t faults;
+static sd_host_stats_t stats;
+static uint32_t rng_state = 1;
+
+// Mesma estrutura de hw_config.c, sem SPI real por trás
+static spi_t spis[] = {
+    {
+        .hw_inst = spi0,
+        .baud_rate = 12500 * 1000
+    }
+};
+
+static int host_init(sd_card_t *pSD);
+static int host_read_blocks(sd_card_t *pSD, uint8_t *buffer,
+                            uint64_t ulSectorNumber, uint32_t ulSectorCount);
+static int host_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
+                             uint64_t ulSectorNumber, uint32_t blockCnt);
+static bool host_test_com(sd_card_t *pSD);
+
+static sd_card_t sd_cards[] = {
+    {
+        .pcName = "0:",
+        .spi = &spis[0],
+        .use_card_detect = false,
+        .m_Status = STA_NOINIT,
+        .init = host_init,
+        .read_blocks = host_read_blocks,
+        .write_blocks = host_write_blocks,
+        .sd_test_com = host_test_com
+    }
+};
+
+/* ********************************************************************** */
+// Funções de acesso de hw_config.c
+size_t sd_get_num() { return count_of(sd_cards); }
+sd_card_t *sd_get_by_num(size_t num) {
+    if (num < sd_get_num()) {
+        return &sd_cards[num];
+    } else {
+        return NULL;
+    }
+}
+size_t spi_get_num() { return count_of(spis); }
+spi_t *spi_get_by_num(size_t num) {
+    if (num < spi_get_num()) {
+        return &spis[num];
+    } else {
+        return NULL;
+    }
+}
+
+// Funções públicas de sd_card.c
+bool sd_init_driver() {
+    static bool initialized;
+    if (!initialized) {
+        for (size_t i = 0; i < sd_get_num(); i++) {
+            mutex_init(&sd_get_by_num(i)->mutex);
+        }
+        initialized = true;
+    }
+    return true;
+}
+
+bool sd_card_detect(sd_card_t *pSD) {
+    if (img_fd < 0 && !img_map) {
+        pSD->m_Status |= STA_NODISK;
+        return false;
+    }
+    pSD->m_Status &= ~STA_NODISK;
+    return true;
+}
+
+uint64_t sd_sectors(sd_card_t *pSD) { return pSD->sectors; }
+
+/* ********************************************************************** */
+
+bool sd_host_open(const char *path, uint64_t size_bytes, bool use_mmap) {
+    sd_host_close();
+    if (path) {
+        img_fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (img_fd < 0) {
+            printf("[SD_HOST] ERRO: Nao foi possivel abrir '%s': %s\n", path, strerror(errno));
+            return false;
+        }
+        struct stat st;
+        fstat(img_fd, &st);
+        if (size_bytes && (uint64_t)st.st_size < size_bytes) {
+            if (ftruncate(img_fd, (off_t)size_bytes) != 0) {
+                printf("[SD_HOST] ERRO: ftruncate falhou: %s\n", strerror(errno));
+                sd_host_close();
+                return false;
+            }
+            img_size = size_bytes;
+        } else {
+            img_size = (uint64_t)st.st_size;
+        }
+    } else {
+        // Sem arquivo: imagem anônima em RAM (sempre mapeada)
+        img_size = size_bytes;
+        use_mmap = true;
+    }
+    img_size -= img_size % SD_HOST_BLOCK_SIZE;
+    if (!img_size) {
+        printf("[SD_HOST] ERRO: Imagem vazia.\n");
+        sd_host_close();
+        return false;
+    }
+    if (use_mmap) {
+        int flags = path ? MAP_SHARED : (MAP_PRIVATE | MAP_ANONYMOUS);
+        void *p = mmap(NULL, img_size, PROT_READ | PROT_WRITE, flags, path ? img_fd : -1, 0);
+        if (p == MAP_FAILED) {
+            printf("[SD_HOST] ERRO: mmap falhou: %s\n", strerror(errno));
+            sd_host_close();
+            return false;
+        }
+        img_map = p;
+    }
+    sd_card_t *pSD = sd_get_by_num(0);
+    pSD->sectors = img_size / SD_HOST_BLOCK_SIZE;
+    pSD->m_Status = STA_NOINIT;
+    return true;
+}
+
+void sd_host_close(void) {
+    if (img_map) {
+        msync(img_map, img_size, MS_SYNC);
+        munmap(img_map, img_size);
+        img_map = NULL;
+    }
+    if (img_fd >= 0) {
+        close(img_fd);
+        img_fd = -1;
+    }
+    img_size = 0;
+    sd_cards[0].m_Status = STA_NOINIT;
+}
+
+void sd_host_set_faults(const sd_host_faults_t *f) {
+    faults = *f;
+    rng_state = f->seed ? f->seed : 1;
+}
+
+void sd_host_get_stats(sd_host_stats_t *s) { *s = stats; }
+void sd_host_reset_stats(void) { memset(&stats, 0, sizeof stats); }
+
+/* ********************************************************************** */
+
+// xorshift32: reprodutível entre execuções com a mesma semente
+static uint32_t next_rand(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static bool should_fail(uint32_t call_no, uint32_t fail_at, uint16_t permille) {
+    if (fail_at && call_no == fail_at) return true;
+    if (permille && next_rand() % 1000 < permille) return true;
+    return false;
+}
+
+static int fail_code(void) {
+    stats.failures++;
+    return faults.fail_code ? faults.fail_code : SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+}
+
+static int image_io(bool write, uint8_t *buffer, uint64_t sector, uint32_t count) {
+    uint64_t off = sector * SD_HOST_BLOCK_SIZE;
+    size_t len = (size_t)count * SD_HOST_BLOCK_SIZE;
+    if (img_map) {
+        if (write)
+            memcpy(img_map + off, buffer, len);
+        else
+            memcpy(buffer, img_map + off, len);
+        return SD_BLOCK_DEVICE_ERROR_NONE;
+    }
+    ssize_t n = write ? pwrite(img_fd, buffer, len, (off_t)off)
+                      : pread(img_fd, buffer, len, (off_t)off);
+    return n == (ssize_t)len ? SD_BLOCK_DEVICE_ERROR_NONE : SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+}
+
+static int host_init(sd_card_t *pSD) {
+    stats.inits++;
+    if (!sd_card_detect(pSD)) return pSD->m_Status;
+    if (!(pSD->m_Status & STA_NOINIT)) return pSD->m_Status;
+    if (faults.init_latency_us) busy_wait_us(faults.init_latency_us);
+    if (should_fail(stats.inits, faults.fail_init_at, 0)) {
+        stats.failures++;
+        return pSD->m_Status;
+    }
+    pSD->m_Status &= ~STA_NOINIT;
+    return pSD->m_Status;
+}
+
+static int host_read_blocks(sd_card_t *pSD, uint8_t *buffer,
+                            uint64_t ulSectorNumber, uint32_t ulSectorCount) {
+    if (ulSectorNumber + ulSectorCount > pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    mutex_enter_blocking(&pSD->mutex);
+    stats.reads++;
+    uint64_t lat = faults.read_latency_us + (uint64_t)faults.read_per_block_us * ulSectorCount;
+    if (lat) busy_wait_us(lat);
+    int rc;
+    if (should_fail(stats.reads, faults.fail_read_at, faults.read_fail_permille)) {
+        rc = fail_code();
+    } else {
+        rc = image_io(false, buffer, ulSectorNumber, ulSectorCount);
+        if (!rc) stats.blocks_read += ulSectorCount;
+    }
+    mutex_exit(&pSD->mutex);
+    return rc;
+}
+
+static int host_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
+                             uint64_t ulSectorNumber, uint32_t blockCnt) {
+    if (ulSectorNumber + blockCnt > pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    mutex_enter_blocking(&pSD->mutex);
+    stats.writes++;
+    uint64_t lat = faults.write_latency_us + (uint64_t)faults.write_per_block_us * blockCnt;
+    if (lat) busy_wait_us(lat);
+    int rc;
+    if (should_fail(stats.writes, faults.fail_write_at, faults.write_fail_permille)) {
+        if (faults.torn_writes && blockCnt > 1) {
+            image_io(true, (uint8_t *)buffer, ulSectorNumber, blockCnt / 2);
+            stats.blocks_written += blockCnt / 2;
+        }
+        rc = fail_code();
+    } else {
+        rc = image_io(true, (uint8_t *)buffer, ulSectorNumber, blockCnt);
+        if (!rc) stats.blocks_written += blockCnt;
+    }
+    mutex_exit(&pSD->mutex);
+    return rc;
+}
+
+static bool host_test_com(sd_card_t *pSD) { return sd_card_detect(pSD); }
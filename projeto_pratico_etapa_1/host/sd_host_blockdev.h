@@ -0,0 +1,66 @@
+/**
+ * @file sd_host_blockdev.h
+ * @brief Cartão SD "virtual" para o build de host: implementa os callbacks
+ * init/read_blocks/write_blocks de sd_card_t sobre um arquivo de imagem
+ * (pread/pwrite ou mmap), com latência e falhas injetáveis por operação.
+ *
+ * Substitui hw_config.c e a parte de bloco de sd_card.c; o restante da pilha
+ * (ff.c, glue.c, ff_stdio.c, sd_card_handler.c) roda sem alterações.
+ */
+#ifndef SD_HOST_BLOCKDEV_H
+#define SD_HOST_BLOCKDEV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sd_card.h"
+
+#define SD_HOST_BLOCK_SIZE 512
+
+// Modelo de latência e falhas. Tudo zerado = dispositivo ideal.
+typedef struct {
+    // Latência fixa por chamada, mais um custo por bloco transferido (us)
+    uint32_t init_latency_us;
+    uint32_t read_latency_us;
+    uint32_t write_latency_us;
+    uint32_t read_per_block_us;
+    uint32_t write_per_block_us;
+
+    // Falha determinística: a N-ésima chamada (1 = primeira) falha; 0 = nunca
+    uint32_t fail_init_at;
+    uint32_t fail_read_at;
+    uint32_t fail_write_at;
+    // Falha aleatória, em partes por mil (0..1000)
+    uint16_t read_fail_permille;
+    uint16_t write_fail_permille;
+    uint32_t seed;             // Semente do gerador (0 = fixa em 1)
+
+    // Código devolvido nas falhas (0 = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE)
+    int fail_code;
+    // Numa escrita com falha, grava só a primeira metade dos blocos
+    // (simula queda de energia no meio de uma rajada)
+    bool torn_writes;
+} sd_host_faults_t;
+
+typedef struct {
+    uint32_t inits;
+    uint32_t reads;
+    uint32_t writes;
+    uint64_t blocks_read;
+    uint64_t blocks_written;
+    uint32_t failures;
+} sd_host_stats_t;
+
+/**
+ * @brief Abre (ou cria) a imagem que fará o papel do cartão.
+ * @param path Arquivo de imagem; NULL usa uma região anônima em RAM.
+ * @param size_bytes Tamanho a criar/estender; 0 usa o tamanho atual do arquivo.
+ * @param use_mmap true mapeia a imagem em memória; false usa pread/pwrite.
+ */
+bool sd_host_open(const char *path, uint64_t size_bytes, bool use_mmap);
+void sd_host_close(void);
+
+void sd_host_set_faults(const sd_host_faults_t *faults);
+void sd_host_get_stats(sd_host_stats_t *stats);
+void sd_host_reset_stats(void);
+
+#endif // SD_HOST_BLOCKDEV_H
@@ -0,0 +1,317 @@
+/**
+ * @file sd_host_tool.c
+ * @brief Ferramenta de linha de comando para exercitar a pilha de
+ * armazenamento (FatFs + sd_card_handler) sobre uma imagem de cartão no host.
+ *
+ * Uso: sd_host_tool [opções] <imagem> <comando>...
+ *   Opções:
+ *     -s <MiB>   cria/estende a imagem com esse tamanho (padrão: 64)
+ *     -m         usa mmap em vez de pread/pwrite
+ *     -r <us>    latência por leitura     -R <us>  latência por bloco lido
+ *     -w <us>    latência por escrita     -W <us>  latência por bloco escrito
+ *     -f <N>     falha a N-ésima escrita  -p <‰>   falha aleatória de escrita
+ *   Comandos:
+ *     mkfs          formata a imagem (FAT32/exFAT conforme o tamanho)
+ *     log <N>       grava N registros de embarque com Sdh_LogBoarding()
+ *     print         imprime o log com Sdh_PrintLogsToSerial()
+ *     delete        apaga o log com Sdh_DeleteLogFile()
+ *     test          executa Sdh_RunTest()
+ *     roster <csv>  gera roster.bin (cadastro por UID) a partir de linhas
+ *                   "uid_hex,id,nome[,rotas]", rotas como no provisionamento
+ *                   ("1/3"; sem a coluna, todas); '#' inicia comentário
+ *     lookup <uid>  procura um UID no roster.bin e mostra os blocos lidos
+ *     filter <csv> <bytes> <rota>
+ *                   gera o filtro de Bloom da rota com os alunos dela (mesmo
+ *                   formato de csv) e mede a taxa de falsos positivos com UIDs
+ *                   aleatórios
+ *     stats         mostra os contadores do dispositivo virtual
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ff.h"
+#include "f_util.h"
+#include "sd_card_handler.h"
+#include "roster.h"
+#include "uid_filter.h"
+#include "sd_host_blockdev.h"
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [-s MiB] [-m] [-r us] [-R us] [-w us] [-W us] [-f N] [-p permille]\n"
+            "       <imagem> {mkfs | log N | print | delete | test | roster CSV | lookup UID |\n"
+            "                 filter CSV BYTES ROTA | stats}...\n",
+            prog);
+}
+
+static bool do_mkfs(void) {
+    static BYTE work[FF_MAX_SS * 4];
+    MKFS_PARM opt = {FM_ANY, 0, 0, 0, 0};
+    FRESULT fr = f_mkfs("0:", &opt, work, sizeof work);
+    if (fr != FR_OK) {
+        printf("[HOST] ERRO: f_mkfs falhou: %s (%d)\n", FRESULT_str(fr), fr);
+        return false;
+    }
+    printf("[HOST] Imagem formatada.\n");
+    return true;
+}
+
+static bool do_log(unsigned count) {
+    StudentDataBlock data;
+    memset(&data, 0, sizeof data);
+    for (unsigned i = 0; i < count; i++) {
+        data.fields.student_id = 1000 + i;
+        snprintf(data.fields.student_name, sizeof data.fields.student_name, "ALUNO%03u", i % 1000);
+        data.fields.trip_count = (uint8_t)i;
+        if (!Sdh_LogBoarding(&data)) return false;
+    }
+    return true;
+}
+
+static int parse_uid(const char *hex, uint8_t uid[7]) {
+    size_t len = strlen(hex);
+    if (len != 8 && len != 14) return 0;
+    for (size_t i = 0; i < len / 2; i++) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+        char *end;
+        uid[i] = (uint8_t)strtoul(byte, &end, 16);
+        if (*end) return 0;
+    }
+    return (int)(len / 2);
+}
+
+// Rotas "1/3/7" -> bits 0, 2 e 6, como no provisionamento
+static bool parse_routes(char *txt, uint32_t *bitmap) {
+    *bitmap = 0;
+    for (char *tok = strtok(txt, "/ \t"); tok; tok = strtok(NULL, "/ \t")) {
+        char *end;
+        unsigned long route = strtoul(tok, &end, 10);
+        if (*end || route < 1 || route > 32) return false;
+        *bitmap |= 1u << (route - 1);
+    }
+    return true;
+}
+
+static roster_record_t records[ROSTER_MAX_SECTORS * ROSTER_RECORDS_PER_SECTOR];
+
+// Lê as linhas "uid_hex,id,nome[,rotas]" do csv para records
+static bool read_csv(const char *csv_path, uint32_t *count_out) {
+    FILE *csv = fopen(csv_path, "r");
+    if (!csv) {
+        perror(csv_path);
+        return false;
+    }
+    uint32_t count = 0;
+    char line[256];
+    unsigned line_no = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof line, csv)) {
+        line_no++;
+        line[strcspn(line, "\r\n#")] = '\0';
+        if (!line[strspn(line, " \t")]) continue;
+        char uid_hex[32], name[64], routes[64] = "";
+        unsigned long id;
+        if (count == sizeof records / sizeof records[0]) {
+            printf("[HOST] ERRO: %s: mais de %u alunos\n", csv_path, (unsigned)count);
+            ok = false;
+            break;
+        }
+        roster_record_t *r = &records[count];
+        memset(r, 0, sizeof *r);
+        if (sscanf(line, " %31[0-9A-Fa-f] , %lu , %63[^,\n] , %63[^\n]", uid_hex, &id, name, routes) < 3 ||
+            !(r->uid_size = (uint8_t)parse_uid(uid_hex, r->uid)) || !parse_routes(routes, &r->route_bitmap)) {
+            printf("[HOST] ERRO: %s:%u invalida\n", csv_path, line_no);
+            ok = false;
+            break;
+        }
+        r->student_id = (uint32_t)id;
+        snprintf(r->student_name, sizeof r->student_name, "%.*s", (int)sizeof r->student_name - 1, name);
+        count++;
+    }
+    fclose(csv);
+    *count_out = count;
+    return ok;
+}
+
+static bool do_roster(const char *csv_path) {
+    uint32_t count;
+    if (!read_csv(csv_path, &count)) return false;
+    if (!Ros_BuildFile(records, count)) {
+        printf("[HOST] ERRO: cadastro nao gerado (UID repetido?)\n");
+        return false;
+    }
+    printf("[HOST] %s: %lu alunos.\n", ROSTER_FILE, (unsigned long)count);
+    return true;
+}
+
+static bool do_lookup(const char *hex) {
+    uint8_t uid[7];
+    int size = parse_uid(hex, uid);
+    if (!size) {
+        printf("[HOST] ERRO: UID deve ter 8 ou 14 digitos hex\n");
+        return false;
+    }
+    if (!Ros_IsOpen() && !Ros_Open()) {
+        printf("[HOST] ERRO: sem %s\n", ROSTER_FILE);
+        return false;
+    }
+    sd_host_stats_t before, after;
+    sd_host_get_stats(&before);
+    roster_record_t r;
+    ros_result_t found = Ros_Lookup(uid, (uint8_t)size, &r);
+    sd_host_get_stats(&after);
+    if (found == ROS_IO_ERROR) {
+        printf("[HOST] ERRO: falha ao ler %s\n", ROSTER_FILE);
+        return false;
+    }
+    if (found == ROS_FOUND) {
+        printf("[HOST] %s: ID %lu, %s, rotas %08lX", hex, (unsigned long)r.student_id, r.student_name,
+               (unsigned long)r.route_bitmap);
+    } else {
+        printf("[HOST] %s: fora do cadastro", hex);
+    }
+    printf(" (%llu blocos lidos)\n", (unsigned long long)(after.blocks_read - before.blocks_read));
+    return true;
+}
+
+static int compare_uid(const void *a, const void *b) {
+    return memcmp(a, b, sizeof records[0].uid + sizeof records[0].uid_size);
+}
+
+static bool do_filter(const char *csv_path, uint32_t bytes, uint16_t route) {
+    uint32_t count;
+    if (!read_csv(csv_path, &count)) return false;
+    // Só os alunos da rota: os das outras ficam para o cadastro negar
+    uint32_t in_route = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (Ros_RouteAllowed(&records[i], (uint8_t)(route > 32 ? 0 : route))) records[in_route++] = records[i];
+    }
+    count = in_route;
+    uint8_t hashes = Ufl_OptimalHashes(bytes, count);
+    if (!Ufl_Create(route, bytes, hashes)) {
+        printf("[HOST] ERRO: filtro de 1 a %u bytes\n", UFL_MAX_BYTES);
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        Ufl_Add(records[i].uid, records[i].uid_size);
+    }
+    // As medidas usam o filtro relido do arquivo, como no ônibus
+    if (!Ufl_Save() || !Ufl_Load(route)) return false;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!Ufl_MayContain(records[i].uid, records[i].uid_size)) {
+            printf("[HOST] ERRO: UID %lu do csv negado pelo filtro\n", (unsigned long)i);
+            return false;
+        }
+    }
+
+    // Falsos positivos: UIDs aleatórios (4 e 7 bytes) fora do csv
+    qsort(records, count, sizeof records[0], compare_uid);
+    const uint32_t trials = 1000000;
+    uint32_t positives = 0;
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    for (uint32_t t = 0; t < trials;) {
+        roster_record_t probe;
+        memset(&probe, 0, sizeof probe);
+        probe.uid_size = (t & 1) ? 7 : 4;
+        for (uint8_t i = 0; i < probe.uid_size; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            probe.uid[i] = (uint8_t)(x >> 24);
+        }
+        if (bsearch(&probe, records, count, sizeof records[0], compare_uid)) continue;
+        positives += Ufl_MayContain(probe.uid, probe.uid_size);
+        t++;
+    }
+    double expected = pow(1.0 - exp(-(double)hashes * count / (bytes * 8.0)), hashes);
+    printf("[HOST] rota %u: %lu UIDs, %lu bytes (%.1f bits/UID), %u hashes\n", (unsigned)route,
+           (unsigned long)count, (unsigned long)bytes, count ? bytes * 8.0 / count : 0.0,
+           (unsigned)hashes);
+    printf("[HOST] falsos positivos: %.4f%% medido, %.4f%% teorico\n",
+           100.0 * positives / trials, 100.0 * expected);
+    return true;
+}
+
+static void print_stats(void) {
+    sd_host_stats_t s;
+    sd_host_get_stats(&s);
+    printf("[HOST] inits=%u leituras=%u (%llu blocos) escritas=%u (%llu blocos) falhas=%u\n",
+           s.inits, s.reads, (unsigned long long)s.blocks_read, s.writes,
+           (unsigned long long)s.blocks_written, s.failures);
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t size_mib = 64;
+    bool use_mmap = false;
+    sd_host_faults_t faults = {0};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:mr:R:w:W:f:p:")) != -1) {
+        switch (opt) {
+            case 's': size_mib = strtoull(optarg, NULL, 0); break;
+            case 'm': use_mmap = true; break;
+            case 'r': faults.read_latency_us = strtoul(optarg, NULL, 0); break;
+            case 'R': faults.read_per_block_us = strtoul(optarg, NULL, 0); break;
+            case 'w': faults.write_latency_us = strtoul(optarg, NULL, 0); break;
+            case 'W': faults.write_per_block_us = strtoul(optarg, NULL, 0); break;
+            case 'f': faults.fail_write_at = strtoul(optarg, NULL, 0); break;
+            case 'p': faults.write_fail_permille = (uint16_t)strtoul(optarg, NULL, 0); break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind + 2 > argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const char *image = argv[optind++];
+    if (!sd_host_open(image, size_mib * 1024 * 1024, use_mmap)) return 1;
+    sd_host_set_faults(&faults);
+
+    bool mounted = false;
+    bool ok = true;
+    for (int i = optind; ok && i < argc; i++) {
+        const char *cmd = argv[i];
+        if (!strcmp(cmd, "mkfs")) {
+            ok = do_mkfs();
+            continue;
+        }
+        if (!strcmp(cmd, "stats")) {
+            print_stats();
+            continue;
+        }
+        if (!mounted && !(mounted = Sdh_Init())) {
+            ok = false;
+            break;
+        }
+        if (!strcmp(cmd, "log") && i + 1 < argc) {
+            ok = do_log((unsigned)strtoul(argv[++i], NULL, 0));
+        } else if (!strcmp(cmd, "print")) {
+            ok = Sdh_PrintLogsToSerial();
+        } else if (!strcmp(cmd, "delete")) {
+            ok = Sdh_DeleteLogFile();
+        } else if (!strcmp(cmd, "test")) {
+            ok = Sdh_RunTest();
+        } else if (!strcmp(cmd, "roster") && i + 1 < argc) {
+            ok = do_roster(argv[++i]);
+        } else if (!strcmp(cmd, "lookup") && i + 1 < argc) {
+            ok = do_lookup(argv[++i]);
+        } else if (!strcmp(cmd, "filter") && i + 3 < argc) {
+            ok = do_filter(argv[i + 1], (uint32_t)strtoul(argv[i + 2], NULL, 0),
+                           (uint16_t)strtoul(argv[i + 3], NULL, 0));
+            i += 3;
+        } else {
+            usage(argv[0]);
+            ok = false;
+        }
+    }
+
+    Ros_Close();
+    if (mounted) f_unmount("0:");
+    sd_host_close();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file spi_manager_host.c
+ * @brief Versão de host do spi_manager: no Linux não há barramento
+ * compartilhado, então só registramos qual periférico está ativo.
+ */
+
+#include <stdio.h>
+#include "spi_manager.h"
+
+typedef enum {
+    PERIPHERAL_NONE,
+    PERIPHERAL_RFID,
+    PERIPHERAL_SD,
+    PERIPHERAL_WIFI
+} peripheral_state_t;
+
+static peripheral_state_t current_peripheral = PERIPHERAL_NONE;
+
+void spi_manager_add_rfid_cs(uint pin) { (void)pin; }
+void spi_manager_activate_rfid(void) { current_peripheral = PERIPHERAL_RFID; }
+void spi_manager_activate_sd(void) { current_peripheral = PERIPHERAL_SD; }
+void spi_manager_activate_wifi(void) { current_peripheral = PERIPHERAL_WIFI; }
+
+void spi_manager_deactivate_rfid(void) {
+    if (current_peripheral == PERIPHERAL_RFID) current_peripheral = PERIPHERAL_NONE;
+}
+void spi_manager_deactivate_sd(void) {
+    if (current_peripheral == PERIPHERAL_SD) current_peripheral = PERIPHERAL_NONE;
+}
+void spi_manager_deactivate_wifi(void) {
+    if (current_peripheral == PERIPHERAL_WIFI) current_peripheral = PERIPHERAL_NONE;
+}
+bool spi_manager_sd_active(void) { return current_peripheral == PERIPHERAL_SD; }
+void spi_manager_deactivate_all(void) { current_peripheral = PERIPHERAL_NONE; }
+
+void spi_manager_reactivate_wifi_for_core1(void) { current_peripheral = PERIPHERAL_WIFI; }
+void spi_manager_shutdown_wifi_power_save(void) { spi_manager_deactivate_wifi(); }
+void spi_manager_wakeup_wifi_power_save(void) { current_peripheral = PERIPHERAL_WIFI; }
+void wifi_activate(void) {}
+void wifi_deactivate(void) {}
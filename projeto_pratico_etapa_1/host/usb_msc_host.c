@@ -0,0 +1,238 @@
+/**
+ * @file usb_msc_host.c
+ * @brief Exercita a exportação USB MSC (inc/usb_msc/usb_msc.c) no host,
+ * fazendo o papel do PC: chama Msc_Read/Msc_Write como os callbacks
+ * READ10/WRITE10 do TinyUSB chamariam, em pacotes de CFG_TUD_MSC_EP_BUFSIZE.
+ *
+ * Sequência: grava um diário com Sdh_LogBoarding(), exporta, confere que o
+ * FatFs do dispositivo fica bloqueado, copia o cartão inteiro pelo MSC e
+ * procura os registros na cópia, altera um registro escrevendo pelo MSC,
+ * ejeta e confere que o FatFs remontado enxerga a alteração do "PC" e que o
+ * cadastro aberto antes da exportação volta a responder.
+ *
+ * Dois executáveis saem deste arquivo:
+ *   usb_msc_host  cartão sobre imagem em RAM (sd_host_blockdev.c)
+ *   usb_msc_emu   driver SPI real sobre o emulador, com relógio virtual: a
+ *                 taxa da cópia é a do lado SD (o USB full-speed limita a
+ *                 ~1 MB/s no alvo)
+ *
+ * Uso: usb_msc_{host,emu} [-n registros] [-s MiB] [-b bauds] [-o imagem]
+ *   -b só faz diferença no usb_msc_emu
+ *   -o grava a cópia feita pelo "PC" num arquivo
+ * Retorna 0 se todas as verificações passaram.
+ */
+
+#define _GNU_SOURCE  // memmem()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_card.h"
+#include "ff.h"
+#include "f_util.h"
+#include "roster.h"
+#include "sd_card_handler.h"
+#include "usb_msc.h"
+#include "tusb_config.h"
+#include "hardware/spi.h"
+#include "pico/time.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                       \
+    do {                                       \
+        if (!(cond)) {                         \
+            printf("  FALHA: " __VA_ARGS__);   \
+            printf("  (%s:%d)\n", __FILE__, __LINE__); \
+            failures++;                        \
+        }                                      \
+    } while (0)
+
+static bool make_journal(unsigned count) {
+    static BYTE work[FF_MAX_SS * 4];
+    MKFS_PARM opt = {FM_ANY, 0, 0, 0, 0};
+    FRESULT fr = f_mkfs("0:", &opt, work, sizeof work);
+    if (fr != FR_OK) {
+        printf("[HOST] ERRO: f_mkfs falhou: %s (%d)\n", FRESULT_str(fr), fr);
+        return false;
+    }
+    if (!Sdh_Init()) return false;
+
+    StudentDataBlock data;
+    memset(&data, 0, sizeof data);
+    for (unsigned i = 0; i < count; i++) {
+        data.fields.student_id = 1000 + i;
+        snprintf(data.fields.student_name, sizeof data.fields.student_name, "ALUNO%03u", i % 1000);
+        data.fields.trip_count = (uint8_t)i;
+        if (!Sdh_LogBoarding(&data)) return false;
+    }
+
+    // Cadastro aberto durante toda a exportação, como no modo RFID
+    roster_record_t alunos[2] = {
+        {.uid = {0xDE, 0xAD, 0xBE, 0xEF}, .uid_size = 4, .student_id = 4242, .student_name = "ROSTER"},
+        {.uid = {0x0A, 0x0B, 0x0C, 0x0D}, .uid_size = 4, .student_id = 4343, .route_bitmap = 1u << 2,
+         .student_name = "ROTA3"},
+    };
+    return Ros_BuildFile(alunos, 2) && Ros_Open();
+}
+
+// Cópia do cartão inteiro, como o PC faria ao ler a unidade
+static uint8_t *pc_copy(uint32_t blocks) {
+    uint8_t *image = malloc((size_t)blocks * MSC_BLOCK_SIZE);
+    if (!image) return NULL;
+    const uint32_t per_xfer = CFG_TUD_MSC_EP_BUFSIZE / MSC_BLOCK_SIZE;
+
+    uint64_t t0 = time_us_64();
+    for (uint32_t lba = 0; lba < blocks; lba += per_xfer) {
+        uint32_t n = blocks - lba < per_xfer ? blocks - lba : per_xfer;
+        int32_t rc = Msc_Read(lba, 0, image + (size_t)lba * MSC_BLOCK_SIZE, n * MSC_BLOCK_SIZE);
+        if (rc != (int32_t)(n * MSC_BLOCK_SIZE)) {
+            printf("  FALHA: READ10 do LBA %lu retornou %ld\n", (unsigned long)lba, (long)rc);
+            free(image);
+            return NULL;
+        }
+    }
+    uint64_t us = time_us_64() - t0;
+    double mb = (double)blocks * MSC_BLOCK_SIZE / 1E6;
+    printf("[HOST] Copia pelo MSC: %.1f MB em %.1f ms (%.2f MB/s)\n", mb, us / 1E3,
+           us ? mb / (us / 1E6) : 0.0);
+    return image;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned records = 50;
+    uint32_t size_mib = 16;
+    uint32_t baud = 12500000;
+    const char *out_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:b:o:")) != -1) {
+        switch (opt) {
+            case 'n': records = strtoul(optarg, NULL, 0); break;
+            case 's': size_mib = strtoul(optarg, NULL, 0); break;
+            case 'b': baud = strtoul(optarg, NULL, 0); break;
+            case 'o': out_path = optarg; break;
+            default:
+                fprintf(stderr, "Uso: %s [-n registros] [-s MiB] [-b bauds] [-o imagem]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (!records || records > 1000) {
+        fprintf(stderr, "registros: 1..1000\n");
+        return 2;
+    }
+
+    sd_card_t *pSD = bench_card_open(size_mib, NULL);
+    if (!pSD) return 1;
+#ifdef BENCH_EMU
+    pSD->spi->baud_rate = baud;
+    spi_set_baudrate(pSD->spi->hw_inst, baud);
+#else
+    (void)baud;
+#endif
+    if (!make_journal(records)) {
+        bench_card_close(pSD);
+        return 1;
+    }
+
+    printf("[HOST] Exportando...\n");
+    CHECK(!Msc_IsReady(), "midia pronta antes de exportar\n");
+    CHECK(Msc_Read(0, 0, (uint8_t[MSC_BLOCK_SIZE]){0}, MSC_BLOCK_SIZE) < 0,
+          "READ10 aceito antes de exportar\n");
+    if (!Msc_Export()) {
+        bench_card_close(pSD);
+        return 1;
+    }
+
+    StudentDataBlock extra = {.fields = {.student_id = 9999, .student_name = "INTRUSO"}};
+    CHECK(!Sdh_LogBoarding(&extra), "FatFs gravou com o cartao exportado\n");
+    CHECK(!Sdh_Init(), "Sdh_Init montou com o cartao exportado\n");
+    roster_record_t aluno;
+    CHECK(Ros_Lookup((const uint8_t[]){0xDE, 0xAD, 0xBE, 0xEF}, 4, &aluno) == ROS_IO_ERROR,
+          "cadastro consultado com o cartao exportado\n");
+
+    uint32_t blocks;
+    uint16_t block_size;
+    Msc_GetCapacity(&blocks, &block_size);
+    CHECK(blocks == pSD->sectors && block_size == MSC_BLOCK_SIZE,
+          "capacidade %lu x %u\n", (unsigned long)blocks, block_size);
+    uint8_t probe[2 * MSC_BLOCK_SIZE];
+    CHECK(Msc_Read(blocks - 1, 0, probe, sizeof probe) < 0, "READ10 passou do fim do cartao\n");
+    CHECK(Msc_Read(0, 16, probe, MSC_BLOCK_SIZE) < 0, "READ10 com offset aceito\n");
+
+    uint8_t *image = pc_copy(blocks);
+    CHECK(image, "copia pelo MSC falhou\n");
+    if (image) {
+        // Primeiro e último registros do diário devem estar na cópia
+        char first[32], last[32];
+        snprintf(first, sizeof first, "ID:%u,NOME:ALUNO%03u,", 1000, 0);
+        snprintf(last, sizeof last, "ID:%u,NOME:ALUNO%03u,", 1000 + records - 1, records - 1);
+        size_t len = (size_t)blocks * MSC_BLOCK_SIZE;
+        uint8_t *rec = memmem(image, len, first, strlen(first));
+        CHECK(rec, "primeiro registro ausente na copia\n");
+        CHECK(memmem(image, len, last, strlen(last)), "ultimo registro ausente na copia\n");
+
+        if (out_path) {
+            FILE *f = fopen(out_path, "wb");
+            CHECK(f && fwrite(image, 1, len, f) == len, "nao gravou %s\n", out_path);
+            if (f) fclose(f);
+        }
+
+        // O "PC" corrige um nome no diário, reescrevendo só aquele setor
+        if (rec) {
+            size_t off = (size_t)(rec - image) + strlen("ID:1000,NOME:");
+            memcpy(image + off, "CORRIGID", 8);
+            uint32_t lba = off / MSC_BLOCK_SIZE;
+            CHECK(Msc_Write(lba, 0, image + (size_t)lba * MSC_BLOCK_SIZE, MSC_BLOCK_SIZE) ==
+                      MSC_BLOCK_SIZE,
+                  "WRITE10 do LBA %lu falhou\n", (unsigned long)lba);
+        }
+        free(image);
+    }
+
+    Msc_StartStop(false, true);
+    CHECK(Msc_IsEjected() && !Msc_IsReady(), "eject nao tirou a midia\n");
+    CHECK(Msc_Read(0, 0, probe, MSC_BLOCK_SIZE) < 0, "READ10 aceito depois do eject\n");
+
+    msc_stats_t stats;
+    Msc_GetStats(&stats);
+    CHECK(stats.blocks_read == blocks && stats.blocks_written == 1 && !stats.errors,
+          "contadores: %llu lidos, %llu gravados, %lu erros\n",
+          (unsigned long long)stats.blocks_read, (unsigned long long)stats.blocks_written,
+          (unsigned long)stats.errors);
+
+    CHECK(Msc_Release(), "nao remontou depois do eject\n");
+    static char journal[64 * 1024];
+    CHECK(Sdh_ReadLogFile(journal, sizeof journal), "diario ilegivel apos a exportacao\n");
+    CHECK(strstr(journal, "NOME:CORRIGID,"), "alteracao do PC nao aparece no FatFs\n");
+    CHECK(Sdh_LogBoarding(&extra), "FatFs nao voltou a gravar apos a exportacao\n");
+    CHECK(Ros_Lookup((const uint8_t[]){0xDE, 0xAD, 0xBE, 0xEF}, 4, &aluno) == ROS_FOUND &&
+              aluno.student_id == 4242,
+          "cadastro nao responde apos a exportacao\n");
+    CHECK(Ros_Lookup((const uint8_t[]){0xDE, 0xAD, 0xBE, 0xF0}, 4, &aluno) == ROS_ABSENT,
+          "UID fora do cadastro nao deu ROS_ABSENT\n");
+    CHECK(Ros_Lookup((const uint8_t[]){0x0A, 0x0B, 0x0C, 0x0D}, 4, &aluno) == ROS_FOUND &&
+              aluno.route_bitmap == 1u << 2 && Ros_RouteAllowed(&aluno, 3) && !Ros_RouteAllowed(&aluno, 1) &&
+              !Ros_RouteAllowed(&aluno, 0),
+          "rotas do cadastro: %08lX\n", (unsigned long)aluno.route_bitmap);
+
+    // Repouso do SD e retomada no próximo acesso: a latência fica registrada
+    sdh_wake_stats_t wake;
+    Sdh_GetWakeStats(&wake);
+    uint32_t wakes = wake.count;
+    Sdh_SetIdleTimeout(1);
+    sleep_ms(2);
+    Sdh_IdleTask();
+    CHECK(Ros_Lookup((const uint8_t[]){0xDE, 0xAD, 0xBE, 0xEF}, 4, &aluno) == ROS_FOUND,
+          "cadastro nao responde apos o repouso\n");
+    Sdh_GetWakeStats(&wake);
+    CHECK(wake.count == wakes + 1 && wake.max_us >= wake.last_us, "retomada nao contada: %lu\n",
+          (unsigned long)(wake.count - wakes));
+    printf("[HOST] SD: retomada do repouso em %lu us (max %lu us)\n", (unsigned long)wake.last_us,
+           (unsigned long)wake.max_us);
+
+    bench_card_close(pSD);
+    printf("%s (%d falhas)\n", failures ? "FALHOU" : "OK", failures);
+    return failures ? 1 : 0;
+}
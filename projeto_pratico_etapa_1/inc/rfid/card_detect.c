@@ -0,0 +1,175 @@
+// Arquivo: inc/rfid/card_detect.c
+
+#include "card_detect.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    Uid uid;
+    bool seen;               // Respondeu ao inventário desta janela
+} cd_present_t;
+
+typedef struct {
+    MFRC522Ptr_t mfrc;
+    absolute_time_t next_slot;
+    absolute_time_t active_until;
+    absolute_time_t field_on_since;
+    bool field_on;
+    bool field_cycled;       // Campo religado nesta janela: quem está no leitor responde
+    bool active;             // Modo anunciado no último Cd_EndSlot()
+    cd_present_t present[CD_MAX_PRESENT];
+    uint8_t n_present;
+} cd_reader_t;
+
+static cd_config_t cd_config = {
+    .idle_interval_ms = CD_IDLE_INTERVAL_MS,
+    .active_interval_ms = CD_ACTIVE_INTERVAL_MS,
+    .active_hold_ms = CD_ACTIVE_HOLD_MS,
+    .field_settle_ms = CD_FIELD_SETTLE_MS,
+};
+static cd_reader_t cd_readers[MFRC_MAX_INSTANCES];
+static uint8_t cd_reader_count = 0;
+static cd_reader_t *cd_current = NULL;  // Leitor da janela em andamento (ou da última)
+static cd_stats_t cd_stats;
+
+static bool cd_is_active(const cd_reader_t *r) {
+    return absolute_time_diff_us(get_absolute_time(), r->active_until) > 0;
+}
+
+static void cd_field_off(cd_reader_t *r) {
+    if (!r->field_on) return;
+    PCD_AntennaOff(r->mfrc);
+    r->field_on = false;
+    cd_stats.field_on_ms += (uint32_t)(absolute_time_diff_us(r->field_on_since, get_absolute_time()) / 1000);
+}
+
+void Cd_Init(MFRC522Ptr_t mfrc, const cd_config_t *config) {
+    if (config) cd_config = *config;
+    cd_reader_count = 0;
+    cd_current = NULL;
+    cd_stats = (cd_stats_t){0};
+    Cd_AddReader(mfrc);
+}
+
+bool Cd_AddReader(MFRC522Ptr_t mfrc) {
+    if (cd_reader_count >= MFRC_MAX_INSTANCES) return false;
+    cd_reader_t *r = &cd_readers[cd_reader_count];
+    // PCD_Init() liga o campo; começa desligado, no modo ocioso
+    PCD_AntennaOff(mfrc);
+    *r = (cd_reader_t){
+        .mfrc = mfrc,
+        .next_slot = make_timeout_time_ms(cd_reader_count * cd_config.idle_interval_ms /
+                                          MFRC_MAX_INSTANCES),
+        .active_until = get_absolute_time(),
+    };
+    cd_reader_count++;
+    return true;
+}
+
+MFRC522Ptr_t Cd_WaitForSlot(void) {
+    // Janela que vence primeiro; no empate fica o leitor de menor índice, e
+    // como a janela seguinte dele é reagendada, o outro vem logo depois
+    cd_reader_t *r = &cd_readers[0];
+    for (uint8_t i = 1; i < cd_reader_count; i++) {
+        if (absolute_time_diff_us(cd_readers[i].next_slot, r->next_slot) > 0) {
+            r = &cd_readers[i];
+        }
+    }
+    sleep_until(r->next_slot);
+    r->field_cycled = !r->field_on;
+    if (!r->field_on) {
+        PCD_AntennaOn(r->mfrc);
+        r->field_on = true;
+        r->field_on_since = get_absolute_time();
+        sleep_ms(cd_config.field_settle_ms);
+    }
+    cd_stats.slots++;
+    cd_current = r;
+    return r->mfrc;
+}
+
+static cd_present_t *cd_find_present(cd_reader_t *r, const Uid *uid) {
+    for (uint8_t i = 0; i < r->n_present; i++) {
+        cd_present_t *p = &r->present[i];
+        if (p->uid.size == uid->size && !memcmp(p->uid.uidByte, uid->uidByte, uid->size)) return p;
+    }
+    return NULL;
+}
+
+bool Cd_IsPresent(const Uid *uid) {
+    if (!cd_current) return false;
+    cd_present_t *p = cd_find_present(cd_current, uid);
+    if (p) p->seen = true;
+    return p != NULL;
+}
+
+void Cd_MarkPresent(const Uid *uid) {
+    cd_reader_t *r = cd_current;
+    if (!r) return;
+    cd_present_t *p = cd_find_present(r, uid);
+    if (!p) {
+        if (r->n_present >= CD_MAX_PRESENT) return;
+        p = &r->present[r->n_present++];
+        p->uid = *uid;
+    }
+    p->seen = true;
+}
+
+// Com o campo religado, quem não respondeu saiu do leitor. Com o campo
+// ligado desde a janela anterior, os cartões em HALT ficam calados e a
+// lista não muda
+static void cd_sweep_present(cd_reader_t *r) {
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < r->n_present; i++) {
+        cd_present_t p = r->present[i];
+        if (!p.seen && r->field_cycled) continue;
+        p.seen = false;
+        r->present[kept++] = p;
+    }
+    r->n_present = kept;
+}
+
+void Cd_EndSlot(bool card_found) {
+    cd_reader_t *r = cd_current;
+    if (!r) return;
+    if (card_found) Cd_NotifyActivity();
+    cd_sweep_present(r);
+
+    bool active = cd_is_active(r);
+    if (active != r->active) {
+        printf("[CARD_DETECT] Leitor %u: modo %s.\n", (unsigned)(r - cd_readers),
+               active ? "ativo" : "ocioso");
+        r->active = active;
+    }
+    if (!active) cd_field_off(r);
+
+    // Próxima janela contada a partir do fim desta: leituras longas (SD,
+    // display) não geram uma rajada de janelas atrasadas
+    r->next_slot = make_timeout_time_ms(active ? cd_config.active_interval_ms
+                                               : cd_config.idle_interval_ms);
+}
+
+void Cd_NotifyActivity(void) {
+    if (cd_current) cd_current->active_until = make_timeout_time_ms(cd_config.active_hold_ms);
+}
+
+void Cd_GetConfig(cd_config_t *config) {
+    *config = cd_config;
+}
+
+void Cd_SetConfig(const cd_config_t *config) {
+    cd_config = *config;
+}
+
+void Cd_GetStats(cd_stats_t *stats) {
+    *stats = cd_stats;
+    stats->active = false;
+    for (uint8_t i = 0; i < cd_reader_count; i++) {
+        const cd_reader_t *r = &cd_readers[i];
+        if (cd_is_active(r)) stats->active = true;
+        if (r->field_on) {
+            stats->field_on_ms += (uint32_t)(absolute_time_diff_us(r->field_on_since, get_absolute_time()) / 1000);
+        }
+    }
+}
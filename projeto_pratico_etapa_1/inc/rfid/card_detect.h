@@ -0,0 +1,107 @@
+#ifndef CARD_DETECT_H
+#define CARD_DETECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mfrc522.h"
+
+// --- Agendador de detecção de cartões ---
+// Ocioso: o campo fica desligado e só é ligado em janelas curtas a cada
+// CD_IDLE_INTERVAL_MS. Depois de qualquer cartão, passa CD_ACTIVE_HOLD_MS em
+// modo ativo: campo sempre ligado e uma janela a cada CD_ACTIVE_INTERVAL_MS.
+// O MFRC522 não tem detecção de cartão em baixo consumo (LPCD); o REQA da
+// janela é a própria sonda.
+// Com vários leitores (portas dianteira e traseira), cada um tem o seu modo e
+// o seu relógio de janelas, e Cd_WaitForSlot() entrega o que vence primeiro:
+// as sondas se intercalam no SPI0 e uma porta movimentada não atrasa a outra.
+// Cartão apoiado no leitor: o HLTA do inventário vale só enquanto o campo
+// fica ligado. Quando o campo desliga, o cartão volta para IDLE e responde
+// de novo ao REQA; por isso cada leitor guarda os UIDs já tratados
+// (Cd_MarkPresent()) e só os esquece quando a primeira janela depois de
+// religar o campo não os encontra.
+
+#ifndef CD_IDLE_INTERVAL_MS
+#define CD_IDLE_INTERVAL_MS 200
+#endif
+#ifndef CD_ACTIVE_INTERVAL_MS
+#define CD_ACTIVE_INTERVAL_MS 50
+#endif
+#ifndef CD_ACTIVE_HOLD_MS
+#define CD_ACTIVE_HOLD_MS 5000
+#endif
+// ISO/IEC 14443-3: o cartão tem até 5 ms para energizar depois que o campo liga
+#ifndef CD_FIELD_SETTLE_MS
+#define CD_FIELD_SETTLE_MS 5
+#endif
+// UIDs lembrados por leitor; cheio, o cartão a mais volta a ser lido
+#ifndef CD_MAX_PRESENT
+#define CD_MAX_PRESENT 4
+#endif
+
+typedef struct {
+    uint32_t idle_interval_ms;
+    uint32_t active_interval_ms;
+    uint32_t active_hold_ms;
+    uint32_t field_settle_ms;
+} cd_config_t;
+
+// Somados sobre todos os leitores
+typedef struct {
+    uint32_t slots;          // Janelas de detecção executadas
+    uint32_t field_on_ms;    // Tempo total com o campo ligado
+    bool active;             // Algum leitor em modo ativo (polling rápido)
+} cd_stats_t;
+
+/**
+ * @brief Começa com um único leitor, no modo ocioso e com o campo desligado.
+ * @param config Intervalos (valem para todos os leitores); NULL usa os
+ * valores CD_* acima.
+ */
+void Cd_Init(MFRC522Ptr_t mfrc, const cd_config_t *config);
+
+/**
+ * @brief Acrescenta um leitor ao agendador, depois de Cd_Init(). A primeira
+ * janela dele é defasada das dos outros para espalhar as sondas.
+ * @return false se já houver MFRC_MAX_INSTANCES leitores.
+ */
+bool Cd_AddReader(MFRC522Ptr_t mfrc);
+
+/**
+ * @brief Dorme até a próxima janela de qualquer leitor e deixa o campo dele
+ * ligado e estável. Em seguida o chamador procura cartões nesse leitor
+ * (ex.: PICC_Inventory()).
+ * @return O leitor da janela.
+ */
+MFRC522Ptr_t Cd_WaitForSlot(void);
+
+/**
+ * @brief Fecha a janela aberta por Cd_WaitForSlot(). Com cartão, o leitor
+ * entra (ou continua) no modo ativo; sem cartão e fora do modo ativo,
+ * desliga o campo dele até a próxima janela.
+ */
+void Cd_EndSlot(bool card_found);
+
+/**
+ * @brief Confere, na janela aberta, se o UID do inventário é de um cartão já
+ * tratado que continua no leitor desde o último ciclo do campo. Não deve
+ * ser lido de novo nem conta como cartão em Cd_EndSlot().
+ */
+bool Cd_IsPresent(const Uid *uid);
+
+/**
+ * @brief Lembra o UID no leitor da janela aberta até ele faltar numa janela
+ * com o campo religado (ex.: depois de embarcar ou de ter o acesso negado).
+ */
+void Cd_MarkPresent(const Uid *uid);
+
+/**
+ * @brief Mantém o leitor da última janela no modo ativo por mais
+ * CD_ACTIVE_HOLD_MS (ex.: atividade que não passou pelo leitor).
+ */
+void Cd_NotifyActivity(void);
+
+void Cd_GetConfig(cd_config_t *config);
+void Cd_SetConfig(const cd_config_t *config);
+void Cd_GetStats(cd_stats_t *stats);
+
+#endif // CARD_DETECT_H
@@ -5,6 +5,10 @@
 */
 
 #include "mfrc522.h"
+#include "hardware/irq.h"
+#if MFRC522_PIO_SPI
+#include "mfrc522_pio_spi.h"
+#endif
 
 // ADT object allocation counter
 static int MFRC_Instance_Counter = 0;
@@ -13,6 +17,13 @@ static int MFRC_Instance_Counter = 0;
  * Set up the data structures of an MFRC522 ADT object and return a pointer
  */
 MFRC522Ptr_t MFRC522_Init() {
+	return MFRC522_InitPins(cs_pin, RESET_PIN, IRQ_PIN);
+}
+
+/**
+ * Set up an MFRC522 ADT object on the given CS/RST/IRQ pins
+ */
+MFRC522Ptr_t MFRC522_InitPins(uint csPin, uint resetPin, uint irqPin) {
 	// allocate instance struct array
 	static struct MFRC522_T mfrc_Instances[MFRC_MAX_INSTANCES];
 	//      static Chip_SSP_DATA_SETUP_T dataSetup_Instances[MFRC_MAX_INSTANCES];
@@ -21,12 +32,26 @@ MFRC522Ptr_t MFRC522_Init() {
 
 	// initialize fields
 	uint16_t i;
+
+	// Same reader again (e.g. a mode re-entered without a reset): reuse its
+	// instance, which also keeps its IRQ registration
+	for (i = 0; i < MFRC_Instance_Counter; i++) {
+		if (mfrc_Instances[i]._chipSelectPin == csPin) {
+			return &(mfrc_Instances[i]);
+		}
+	}
+	if (MFRC_Instance_Counter >= MFRC_MAX_INSTANCES) {
+		return NULL;
+	}
 	for (i = 0; i < BUFFER_SIZE; i++) {
 		mfrc_Instances[MFRC_Instance_Counter].Rx_Buf[i] = 0;
 		mfrc_Instances[MFRC_Instance_Counter].Tx_Buf[i] = 0;
 	}
 
-	mfrc_Instances[MFRC_Instance_Counter]._chipSelectPin = cs_pin;
+	mfrc_Instances[MFRC_Instance_Counter]._chipSelectPin = csPin;
+	mfrc_Instances[MFRC_Instance_Counter]._resetPin = resetPin;
+	mfrc_Instances[MFRC_Instance_Counter]._irqPin = irqPin;
+	mfrc_Instances[MFRC_Instance_Counter].irq_enabled = false;
 
 	// update instance counter
 	MFRC_Instance_Counter++;
@@ -40,6 +65,46 @@ MFRC522Ptr_t MFRC522_Init() {
 * Basic interface functions for communicating with the MFRC522
 *******************************************************************************/
 
+/**
+ * Sets up the reader bus: SPI0 on the reader pins, or the PIO state machine
+ * when MFRC522_PIO_SPI is set.
+ *
+ * @return false if the PIO bus could not be claimed
+ */
+static bool pcd_bus_init(MFRC522Ptr_t mfrc, spi_inst_t *spi) {
+	mfrc->spi = spi;
+#if MFRC522_PIO_SPI
+	if (!PCD_PioInit(sck_pin, mosi_pin, miso_pin, MFRC522_BIT_RATE)) {
+		printf("[MFRC522] PIO bus unavailable\n");
+		return false;
+	}
+#else
+	spi_init(mfrc->spi, MFRC522_BIT_RATE);
+	gpio_set_function(sck_pin, GPIO_FUNC_SPI);
+	gpio_set_function(mosi_pin, GPIO_FUNC_SPI);
+	gpio_set_function(miso_pin, GPIO_FUNC_SPI);
+#endif
+	return true;
+}
+
+/**
+ * Clocks len bytes out and in with chip select already asserted. rx may be
+ * NULL for writes.
+ */
+static void pcd_transfer(MFRC522Ptr_t mfrc, const uint8_t *tx, uint8_t *rx,
+						 size_t len) {
+#if MFRC522_PIO_SPI
+	(void)mfrc;
+	PCD_PioTransfer(tx, rx, len);
+#else
+	if (rx) {
+		spi_write_read_blocking(mfrc->spi, tx, rx, len);
+	} else {
+		spi_write_blocking(mfrc->spi, tx, len);
+	}
+#endif
+}
+
 /**
  * Writes a uint8_t to the specified register in the MFRC522 chip.
  * The interface is described in the datasheet section 8.1.2.
@@ -50,7 +115,7 @@ void PCD_WriteRegister(MFRC522Ptr_t mfrc, uint8_t reg, uint8_t value) {
 	msg[1] = value;
 
 	cs_select(mfrc->_chipSelectPin);
-	spi_write_blocking(mfrc->spi, msg, 2);
+	pcd_transfer(mfrc, msg, NULL, 2);
 	cs_deselect(mfrc->_chipSelectPin);
 }
 
@@ -73,7 +138,7 @@ void PCD_WriteNRegister(
 	}
 
 	cs_select(mfrc->_chipSelectPin);
-	spi_write_blocking(mfrc->spi, msg, count + 1);
+	pcd_transfer(mfrc, msg, NULL, count + 1);
 	cs_deselect(mfrc->_chipSelectPin);
 }
 
@@ -85,19 +150,20 @@ uint8_t PCD_ReadRegister(
 	MFRC522Ptr_t mfrc, 
 	uint8_t reg ///< The register to read from. One of the PCD_Register enums
 	) {
-	uint8_t buf = 0;
-	const uint8_t msg = 0x80 | reg;
+	const uint8_t msg[2] = {0x80 | reg, 0x00};
+	uint8_t buf[2];
 	
 	cs_select(mfrc->_chipSelectPin);
-	spi_write_blocking(mfrc->spi, &msg, 1);
-	spi_read_blocking(mfrc->spi, 0, &buf, 1);
+	pcd_transfer(mfrc, msg, buf, 2);
 	cs_deselect(mfrc->_chipSelectPin);
-	return buf;
+	return buf[1];
 }
 
 /**
  * Reads a number of uint8_ts from the specified register in the MFRC522 chip.
  * The interface is described in the datasheet section 8.1.2.
+ * Burst read: one CS assertion, the address byte is repeated for every value
+ * and each byte comes back while the next address goes out (section 8.1.2.1).
  */
 void PCD_ReadNRegister(
 	MFRC522Ptr_t mfrc,
@@ -106,25 +172,53 @@ void PCD_ReadNRegister(
 	uint8_t *values, ///< uint8_t array to store the values in.
 	uint8_t rxAlign ///< Only bit positions rxAlign..7 in values[0] are updated.
 	) {
-	uint8_t buf = 0;
-	const uint8_t msg = 0x80 | reg;
-	
+	if (count == 0) {
+		return;
+	}
+	uint8_t tx[count + 1];
+	uint8_t rx[count + 1];
+	memset(tx, 0x80 | reg, count);
+	tx[count] = 0x00; // Stops the reading
+
 	cs_select(mfrc->_chipSelectPin);
+	pcd_transfer(mfrc, tx, rx, count + 1);
+	cs_deselect(mfrc->_chipSelectPin);
 
-	// uint8_t i;
-	// for(i = 0; i < count; i++) {
-	// 	uint8_t value = 0;
-	// 	spi_write_blocking(mfrc->spi, &msg, 1);
-	// 	spi_read_blocking(mfrc->spi, 0, &value, 1);
-	// 	values[i] = value;
-	// }
+	// rx[0] was clocked in while the first address went out
+	if (rxAlign) { // Only update bit positions rxAlign..7 in values[0]
+		uint8_t mask = (0xFF << rxAlign) & 0xFF;
+		values[0] = (values[0] & ~mask) | (rx[1] & mask);
+	} else {
+		values[0] = rx[1];
+	}
+	memcpy(&values[1], &rx[2], count - 1);
+}
 
+/**
+ * Reads several different registers in one burst (same framing as
+ * PCD_ReadNRegister(), with a different address per byte).
+ */
+void PCD_ReadRegisters(
+	MFRC522Ptr_t mfrc,
+	const uint8_t *regs, ///< The registers to read. PCD_Register enums.
+	uint8_t count,		 ///< The number of registers
+	uint8_t *values		 ///< values[i] receives regs[i]
+	) {
+	if (count == 0) {
+		return;
+	}
+	uint8_t tx[count + 1];
+	uint8_t rx[count + 1];
 	uint8_t i;
-	for(i = 0; i < count; i++) {
-		values[i] = PCD_ReadRegister(mfrc, msg);
+	for (i = 0; i < count; i++) {
+		tx[i] = 0x80 | regs[i];
 	}
+	tx[count] = 0x00;
 
+	cs_select(mfrc->_chipSelectPin);
+	pcd_transfer(mfrc, tx, rx, count + 1);
 	cs_deselect(mfrc->_chipSelectPin);
+	memcpy(values, &rx[1], count);
 }
 
 /**
@@ -153,13 +247,117 @@ void PCD_ClearRegisterBitMask(
 	PCD_WriteRegister(mfrc, reg, tmp & (~mask)); // clear bit mask
 } // End PCD_ClearRegisterBitMask()
 
+/*******************************************************************************
+* IRQ pin: command completion signalled by the MFRC522
+*******************************************************************************/
+
+// Emergency limits for a command that never completes. A silent PICC is
+// normally reported earlier by the MFRC522 timer (TimerIRq, 25ms).
+#define PCD_COMMAND_TIMEOUT_US 36000
+#define PCD_CRC_TIMEOUT_US 89000
+
+#if MFRC522_USE_IRQ
+// Instances using their IRQ pin, scanned by the shared GPIO handler
+static MFRC522Ptr_t irq_instances[MFRC_MAX_INSTANCES];
+static uint8_t irq_instance_count = 0;
+
+static void pcd_irq_handler(void) {
+	uint8_t i;
+	for (i = 0; i < irq_instance_count; i++) {
+		MFRC522Ptr_t mfrc = irq_instances[i];
+		if (gpio_get_irq_event_mask(mfrc->_irqPin) & GPIO_IRQ_EDGE_FALL) {
+			gpio_acknowledge_irq(mfrc->_irqPin, GPIO_IRQ_EDGE_FALL);
+			mfrc->irq_pending = true; // No SPI here: the bus may belong to the SD card
+		}
+	}
+}
+#endif
+
+/**
+ * Routes command completion to the IRQ pin and hooks it to a falling-edge GPIO
+ * interrupt. A soft reset clears ComIEnReg/DivIEnReg, so this runs again after
+ * every reset.
+ */
+static void pcd_irq_setup(MFRC522Ptr_t mfrc) {
+#if MFRC522_USE_IRQ
+	// IRqInv=1 (active low); RxIRq, IdleIRq and TimerIRq end every command
+	PCD_WriteRegister(mfrc, ComIEnReg, 0x80 | 0x30 | 0x01);
+	// IRQPushPull=1; CRCIRq ends PCD_CalculateCRCOnChip()
+	PCD_WriteRegister(mfrc, DivIEnReg, 0x80 | 0x04);
+	PCD_WriteRegister(mfrc, ComIrqReg, 0x7F);
+	PCD_WriteRegister(mfrc, DivIrqReg, 0x7F);
+	mfrc->irq_pending = false;
+
+	if (mfrc->irq_enabled || mfrc->_irqPin == MFRC522_NO_PIN ||
+		irq_instance_count >= MFRC_MAX_INSTANCES) {
+		return;
+	}
+	gpio_init(mfrc->_irqPin);
+	gpio_set_dir(mfrc->_irqPin, GPIO_IN);
+	gpio_pull_up(mfrc->_irqPin);
+	irq_instances[irq_instance_count++] = mfrc;
+	gpio_add_raw_irq_handler(mfrc->_irqPin, pcd_irq_handler);
+	gpio_set_irq_enabled(mfrc->_irqPin, GPIO_IRQ_EDGE_FALL, true);
+	irq_set_enabled(IO_IRQ_BANK0, true);
+	mfrc->irq_enabled = true;
+#else
+	(void)mfrc;
+#endif
+}
+
+/**
+ * Waits until one of the bits in mask is set in reg (ComIrqReg or DivIrqReg).
+ * With the IRQ pin the core sleeps in WFE and SPI0 stays free until the
+ * MFRC522 signals; otherwise (or if the pin never fires) the register is
+ * polled.
+ *
+ * @return The last value read from reg, 0 on timeout.
+ */
+static uint8_t pcd_wait_irq(MFRC522Ptr_t mfrc, uint8_t reg, uint8_t mask,
+							uint32_t timeout_us) {
+	absolute_time_t deadline = make_timeout_time_us(timeout_us);
+	uint8_t n;
+
+	if (mfrc->irq_enabled) {
+		while (!mfrc->irq_pending && !best_effort_wfe_or_timeout(deadline)) {
+		}
+		if (!mfrc->irq_pending) {
+			n = PCD_ReadRegister(mfrc, reg);
+			if (!(n & mask)) {
+				return 0;
+			}
+			// The command finished but no edge arrived: pin not wired
+			printf("[MFRC522] IRQ on GPIO %u never fired, polling instead\n",
+				   mfrc->_irqPin);
+			mfrc->irq_enabled = false;
+			return n;
+		}
+	}
+
+	while (1) {
+		n = PCD_ReadRegister(mfrc, reg);
+		if (n & mask) {
+			break;
+		}
+		if (time_reached(deadline)) {
+			return 0;
+		}
+	}
+	if (mfrc->irq_enabled) {
+		// Release the IRQ line so that the next command gets a new edge
+		PCD_WriteRegister(mfrc, reg, n & 0x7F);
+	}
+	return n;
+}
+
 /**
  * Use the CRC coprocessor in the MFRC522 to calculate a CRC_A.
+ * Kept to validate PCD_CalculateCRCSoft() against the chip.
  *
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
 StatusCode
-PCD_CalculateCRC(MFRC522Ptr_t mfrc,
+PCD_CalculateCRCOnChip(MFRC522Ptr_t mfrc,
 				 uint8_t *data,  ///< In: Pointer to the data to transfer to the
 								 ///FIFO for CRC calculation.
 				 uint8_t length, ///< In: The number of uint8_ts to transfer.
@@ -169,38 +367,107 @@ PCD_CalculateCRC(MFRC522Ptr_t mfrc,
 	PCD_WriteRegister(mfrc, CommandReg, PCD_Idle); // Stop any active command.
 	PCD_WriteRegister(mfrc, DivIrqReg,
 					  0x04); // Clear the CRCIRq interrupt request bit
-	PCD_SetRegisterBitMask(mfrc, FIFOLevelReg,
-						   0x80); // FlushBuffer = 1, FIFO initialization
+	mfrc->irq_pending = false; // Any edge from now on is ours
+	PCD_WriteRegister(mfrc, FIFOLevelReg,
+					  0x80); // FlushBuffer = 1, FIFO initialization. The
+							 // other bits are read-only: no need to read first
 	PCD_WriteNRegister(mfrc, FIFODataReg, length,
 					   data);						  // Write data to the FIFO
 	PCD_WriteRegister(mfrc, CommandReg, PCD_CalcCRC); // Start the calculation
 
-	// Wait for the CRC calculation to complete. Each iteration of the
-	// while-loop takes 17.73�s.
-	uint16_t i = 5000;
-	uint8_t n;
-	while (1) {
-		n = PCD_ReadRegister(mfrc, DivIrqReg); // DivIrqReg[7..0] bits are: Set2
-											   // reserved reserved MfinActIRq
-											   // reserved CRCIRq reserved
-											   // reserved
-		if (n & 0x04) { // CRCIRq bit set - calculation done
-			break;
-		}
-		if (--i == 0) { // The emergency break. We will eventually terminate on
-						// this one after 89ms. Communication with the MFRC522
-						// might be down.
-			return STATUS_TIMEOUT;
-		}
+	// Wait for the CRC calculation to complete. DivIrqReg[7..0] bits are: Set2
+	// reserved reserved MfinActIRq reserved CRCIRq reserved reserved.
+	// The emergency break after 89ms means communication with the MFRC522
+	// might be down.
+	uint8_t n = pcd_wait_irq(mfrc, DivIrqReg, 0x04, PCD_CRC_TIMEOUT_US);
+	if (!(n & 0x04)) { // CRCIRq bit not set - calculation not done
+		return STATUS_TIMEOUT;
 	}
 	PCD_WriteRegister(
 		mfrc, CommandReg,
 		PCD_Idle); // Stop calculating CRC for new content in the FIFO.
 
 	// Transfer the result from the registers to the result buffer
-	result[0] = PCD_ReadRegister(mfrc, CRCResultRegL);
-	result[1] = PCD_ReadRegister(mfrc, CRCResultRegH);
+	static const uint8_t crcRegs[] = {CRCResultRegL, CRCResultRegH};
+	PCD_ReadRegisters(mfrc, crcRegs, 2, result);
+	return STATUS_OK;
+} // End PCD_CalculateCRCOnChip()
+
+// CRC_A (ISO/IEC 14443-3 Annex B): x^16 + x^12 + x^5 + 1, LSB first
+// (reflected polynomial 0x8408), preset 0x6363, no final XOR.
+static const uint16_t crc_a_table[256] = {
+	0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
+	0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
+	0x1081, 0x0108, 0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E,
+	0x9CC9, 0x8D40, 0xBFDB, 0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876,
+	0x2102, 0x308B, 0x0210, 0x1399, 0x6726, 0x76AF, 0x4434, 0x55BD,
+	0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E, 0xFAE7, 0xC87C, 0xD9F5,
+	0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E, 0x54B5, 0x453C,
+	0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD, 0xC974,
+	0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
+	0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3,
+	0x5285, 0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A,
+	0xDECD, 0xCF44, 0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72,
+	0x6306, 0x728F, 0x4014, 0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9,
+	0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5, 0xA96A, 0xB8E3, 0x8A78, 0x9BF1,
+	0x7387, 0x620E, 0x5095, 0x411C, 0x35A3, 0x242A, 0x16B1, 0x0738,
+	0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862, 0x9AF9, 0x8B70,
+	0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E, 0xF0B7,
+	0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
+	0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036,
+	0x18C1, 0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E,
+	0xA50A, 0xB483, 0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5,
+	0x2942, 0x38CB, 0x0A50, 0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD,
+	0xB58B, 0xA402, 0x9699, 0x8710, 0xF3AF, 0xE226, 0xD0BD, 0xC134,
+	0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7, 0x6E6E, 0x5CF5, 0x4D7C,
+	0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1, 0xA33A, 0xB2B3,
+	0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72, 0x3EFB,
+	0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
+	0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A,
+	0xE70E, 0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1,
+	0x6B46, 0x7ACF, 0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9,
+	0xF78F, 0xE606, 0xD49D, 0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330,
+	0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78,
+};
+
+/**
+ * Calculate a CRC_A on the MCU. Same result as PCD_CalculateCRCOnChip(),
+ * without the FIFO load, the command and the result reads over SPI.
+ */
+void PCD_CalculateCRCSoft(
+	const uint8_t *data, ///< In: The data to checksum.
+	uint8_t length,		 ///< In: The number of uint8_ts.
+	uint8_t *result		 ///< Out: result[0..1], low uint8_t first.
+	) {
+	uint16_t crc = 0x6363;
+	uint8_t i;
+	for (i = 0; i < length; i++) {
+		crc = (crc >> 8) ^ crc_a_table[(crc ^ data[i]) & 0xFF];
+	}
+	result[0] = crc & 0xFF;
+	result[1] = crc >> 8;
+} // End PCD_CalculateCRCSoft()
+
+/**
+ * Calculate a CRC_A, on the MCU or (MFRC522_SOFT_CRC = 0) on the MFRC522.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+StatusCode
+PCD_CalculateCRC(MFRC522Ptr_t mfrc,
+				 uint8_t *data,  ///< In: Pointer to the data to calculate
+								 ///the CRC_A over.
+				 uint8_t length, ///< In: The number of uint8_ts.
+				 uint8_t *result ///< Out: Pointer to result buffer. Result is
+								 ///written to result[0..1], low uint8_t first.
+				 ) {
+#if MFRC522_SOFT_CRC
+	(void)mfrc;
+	PCD_CalculateCRCSoft(data, length, result);
 	return STATUS_OK;
+#else
+	return PCD_CalculateCRCOnChip(mfrc, data, length, result);
+#endif
 } // End PCD_CalculateCRC()
 
 /*******************************************************************************
@@ -212,27 +479,27 @@ PCD_CalculateCRC(MFRC522Ptr_t mfrc,
  */
 void PCD_Init(MFRC522Ptr_t mfrc, spi_inst_t *spi) {
 
-    mfrc->spi = spi; // Usa a instância de SPI passada (spi0)
-
     // --- Inicialização do Hardware ---
-    // Inicializa o periférico SPI com uma velocidade
-    spi_init(mfrc->spi, 4000000); // 4 MHz
-
-    // Mapeia as funções do SPI para os pinos customizados
-    gpio_set_function(sck_pin, GPIO_FUNC_SPI);
-    gpio_set_function(mosi_pin, GPIO_FUNC_SPI);
-    gpio_set_function(miso_pin, GPIO_FUNC_SPI);
+    // Barramento do leitor: SPI0 (a instância passada) ou a PIO. Sem
+    // barramento não há o que configurar: o leitor lê como ausente
+    if (!pcd_bus_init(mfrc, spi)) {
+        return;
+    }
 
     // O pino Chip Select é configurado como uma saída digital padrão
-    gpio_init(cs_pin);
-    gpio_set_dir(cs_pin, GPIO_OUT);
-    gpio_put(cs_pin, 1); // Garante que comece desativado (nível alto)
-
-    // Reseta o MFRC522
-    gpio_put(RESET_PIN, 0);
-    sleep_ms(10); // Um tempo menor de reset é suficiente
-    gpio_put(RESET_PIN, 1);
-    sleep_ms(50);
+    gpio_init(mfrc->_chipSelectPin);
+    gpio_set_dir(mfrc->_chipSelectPin, GPIO_OUT);
+    gpio_put(mfrc->_chipSelectPin, 1); // Garante que comece desativado (nível alto)
+
+    // Reseta o MFRC522 (sem pino de reset, só o soft reset abaixo)
+    if (mfrc->_resetPin != MFRC522_NO_PIN) {
+        gpio_init(mfrc->_resetPin);
+        gpio_set_dir(mfrc->_resetPin, GPIO_OUT);
+        gpio_put(mfrc->_resetPin, 0);
+        sleep_ms(10); // Um tempo menor de reset é suficiente
+        gpio_put(mfrc->_resetPin, 1);
+        sleep_ms(50);
+    }
     // --- Fim da Inicialização do Hardware ---
 
 
@@ -248,9 +515,108 @@ void PCD_Init(MFRC522Ptr_t mfrc, spi_inst_t *spi) {
 
     PCD_WriteRegister(mfrc, TxASKReg, 0x40);
     PCD_WriteRegister(mfrc, ModeReg, 0x3D);
+    pcd_irq_setup(mfrc);
     PCD_AntennaOn(mfrc);
 } // End PCD_Init()
 
+/**
+ * Timer setup written by PCD_Init(). No other function touches these
+ *registers, so finding them after an MCU reset means the reader kept its
+ *configuration (it is powered separately from the RP2040).
+ */
+static const uint8_t warm_signature_regs[] = {VersionReg, TModeReg,
+											  TPrescalerReg, TReloadRegH,
+											  TReloadRegL};
+static const uint8_t warm_signature_vals[] = {0x00, 0x80, 0xA9, 0x03, 0xE8};
+
+/**
+ * Leaves soft power-down (if active) and waits for the oscillator.
+ *
+ * @return false if the PowerDown bit did not clear within timeout_us.
+ */
+static bool pcd_power_up(MFRC522Ptr_t mfrc, uint32_t timeout_us) {
+	// Writing Idle clears PowerDown and aborts any command left running
+	PCD_WriteRegister(mfrc, CommandReg, PCD_Idle);
+	absolute_time_t deadline = make_timeout_time_us(timeout_us);
+	while (PCD_ReadRegister(mfrc, CommandReg) & (1 << 4)) {
+		if (time_reached(deadline)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Drives a reader's RST (NRSTPD) pin high, setting the level before the pin
+ *becomes an output so there is no low pulse. Left floating, the RP2040 pad
+ *pull-down holds the MFRC522 in hard power-down, which wipes its registers.
+ *Call it at boot in every mode so the reader keeps its configuration across
+ *mode switches. Does nothing for MFRC522_NO_PIN.
+ */
+void PCD_HoldOutOfReset(uint resetPin) {
+	if (resetPin == MFRC522_NO_PIN) {
+		return;
+	}
+	gpio_init(resetPin);
+	gpio_put(resetPin, 1);
+	gpio_set_dir(resetPin, GPIO_OUT);
+} // End PCD_HoldOutOfReset()
+
+/**
+ * Brings the reader up after an MCU reset without the hard/soft reset and
+ *the fixed sleeps of PCD_Init(), when its registers still hold the
+ *configuration from a previous PCD_Init(). Otherwise runs PCD_Init().
+ *
+ * @return true if the warm path was taken.
+ */
+bool PCD_WarmInit(MFRC522Ptr_t mfrc, spi_inst_t *spi) {
+	uint8_t values[sizeof(warm_signature_regs)];
+	uint8_t i;
+
+	// RST high before probing: a reader found in hard power-down has lost its
+	// registers and fails the signature check below
+	PCD_HoldOutOfReset(mfrc->_resetPin);
+	if (!pcd_bus_init(mfrc, spi)) {
+		return false;
+	}
+	gpio_init(mfrc->_chipSelectPin);
+	gpio_set_dir(mfrc->_chipSelectPin, GPIO_OUT);
+	gpio_put(mfrc->_chipSelectPin, 1);
+
+	if (!pcd_power_up(mfrc, PCD_POWER_UP_TIMEOUT_US)) {
+		PCD_Init(mfrc, spi);
+		return false;
+	}
+	PCD_ReadRegisters(mfrc, warm_signature_regs, sizeof(values), values);
+	// 0x00/0xFF: no chip answering (MISO stuck), whatever the version
+	if (values[0] == 0x00 || values[0] == 0xFF) {
+		PCD_Init(mfrc, spi);
+		return false;
+	}
+	for (i = 1; i < sizeof(values); i++) {
+		if (values[i] != warm_signature_vals[i]) {
+			PCD_Init(mfrc, spi);
+			return false;
+		}
+	}
+
+	// State a previous session may have left behind
+	PCD_StopCrypto1(mfrc);
+	PCD_WriteRegister(mfrc, FIFOLevelReg, 0x80);
+	pcd_irq_setup(mfrc);
+	PCD_AntennaOn(mfrc);
+	return true;
+} // End PCD_WarmInit()
+
+/**
+ * Puts the reader in soft power-down: oscillator and field off, registers
+ *and FIFO kept, SPI still usable. PCD_WarmInit() wakes it up.
+ */
+void PCD_SoftPowerDown(MFRC522Ptr_t mfrc) {
+	PCD_AntennaOff(mfrc);
+	PCD_WriteRegister(mfrc, CommandReg, PCD_NoCmdChange | (1 << 4));
+} // End PCD_SoftPowerDown()
+
 /**
  * Performs a soft reset on the MFRC522 chip and waits for it to be ready again.
  */
@@ -270,6 +636,9 @@ void PCD_Reset(MFRC522Ptr_t mfrc) {
 		// PCD still restarting - unlikely after waiting 50ms, but better safe
 		// than sorry.
 	}
+	if (mfrc->irq_enabled) {
+		pcd_irq_setup(mfrc);
+	}
 } // End PCD_Reset()
 
 /**
@@ -331,9 +700,8 @@ uint8_t PCD_SelfTest(MFRC522Ptr_t mfrc) {
     //Clear the internal buffer by writing 25 bytes of 00h (and implement the config command)??.
     PCD_WriteRegister(mfrc, FIFOLevelReg, 0x80); //FIFOLevel indicates nbr of bytes in FIFO buffer. MSB = 1 -> Flush
 
-    for (int i = 0; i < 25; i++) {
-        PCD_WriteRegister(mfrc, FIFODataReg, 0x00);
-    }
+    uint8_t zeros[25] = {0};
+    PCD_WriteNRegister(mfrc, FIFODataReg, sizeof(zeros), zeros);
     PCD_WriteRegister(mfrc, CommandReg, PCD_Mem); //Transfer the 25 bytes from FIFO to internal buffer
     //printf("Clearing of internal buffer complete\n\r");
 
@@ -364,15 +732,15 @@ uint8_t PCD_SelfTest(MFRC522Ptr_t mfrc) {
 
     //When the self test has completed, the FIFO buffer contains the version bytes.
     uint8_t result[64];
-    for (int i = 0; i < 64; i++) {
-        uint8_t buf = PCD_ReadRegister(mfrc, FIFODataReg);
-        result[i] = buf;
-    }
+    PCD_ReadNRegister(mfrc, FIFODataReg, sizeof(result), result, 0);
     //printf("Bytes copied to result array\n\r");
 
     //Check if the received bytes correspond to the versions.
     PCD_WriteRegister(mfrc, AutoTestReg, 0x00); //Disable self-test
     //printf("Disabled self test\n\r");
+    if (mfrc->irq_enabled) {
+        pcd_irq_setup(mfrc); // The soft reset above disabled the IRQ sources
+    }
 
     /*printf("Self test result:\n\r");
     for (uint8_t i = 0; i < 64; i++) {
@@ -426,39 +794,24 @@ StatusCode PCD_TransceiveData(
 } // End PCD_TransceiveData()
 
 /**
- * Transfers data to the MFRC522 FIFO, executes a command, waits for completion
- *and transfers data back from the FIFO.
- * CRC validation can only be done if backData and backLen are specified.
+ * Loads the FIFO and starts a command on the MFRC522 without waiting for it.
+ * Completion is signalled on the IRQ pin (see PCD_CommandDone()); collect the
+ * result with PCD_FinishCommand().
  *
- * @return STATUS_OK on success, STATUS_??? otherwise.
+ * @return STATUS_OK once the command is running.
  */
-StatusCode PCD_CommunicateWithPICC(
+StatusCode PCD_StartCommand(
 	MFRC522Ptr_t mfrc,
 	uint8_t command, ///< The command to execute. One of the PCD_Command enums.
 	uint8_t waitIRq, ///< The bits in the ComIrqReg register that signals
 					 ///successful completion of the command.
 	uint8_t *sendData,  ///< Pointer to the data to transfer to the FIFO.
 	uint8_t sendLen,	///< Number of uint8_ts to transfer to the FIFO.
-	uint8_t *backData,  ///< NULL or pointer to buffer if data should be read
-						///back after executing the command.
-	uint8_t *backLen,   ///< In: Max number of uint8_ts to write to *backData.
-						///Out: The number of uint8_ts returned.
-	uint8_t *validBits, ///< In/Out: The number of valid bits in the last
-						///uint8_t. 0 for 8 valid bits.
-	uint8_t rxAlign,	///< In: Defines the bit position in backData[0] for the
-						///first bit received. Default 0.
-	bool checkCRC ///< In: True => The last two uint8_ts of the response is
-				  ///assumed to be a CRC_A that must be validated.
+	uint8_t *validBits, ///< In: The number of valid bits in the last uint8_t.
+						///0 for 8 valid bits. NULL = 0.
+	uint8_t rxAlign	///< In: Defines the bit position in backData[0] for the
+					///first bit received. Default 0.
 	) {
-	//		backData=NULL;
-	//		backLen=NULL;
-	//		validBits=NULL;
-	//		rxAlign=0;
-	//		checkCRC=false;
-
-	uint8_t n, _validBits;
-	unsigned int i;
-
 	// Prepare values for BitFramingReg
 	uint8_t txLastBits = validBits ? *validBits : 0;
 	uint8_t bitFraming =
@@ -468,44 +821,76 @@ StatusCode PCD_CommunicateWithPICC(
 	PCD_WriteRegister(mfrc, CommandReg, PCD_Idle); // Stop any active command.
 	PCD_WriteRegister(mfrc, ComIrqReg,
 					  0x7F); // Clear all seven interrupt request bits
-	PCD_SetRegisterBitMask(mfrc, FIFOLevelReg,
-						   0x80); // FlushBuffer = 1, FIFO initialization
+	mfrc->irq_pending = false;
+	mfrc->waitIRq = waitIRq;
+	PCD_WriteRegister(mfrc, FIFOLevelReg,
+					  0x80); // FlushBuffer = 1, FIFO initialization. The
+							 // other bits are read-only: no need to read first
 	PCD_WriteNRegister(mfrc, FIFODataReg, sendLen,
 					   sendData); // Write sendData to the FIFO
 	PCD_WriteRegister(mfrc, BitFramingReg, bitFraming); // Bit adjustments
 	PCD_WriteRegister(mfrc, CommandReg, command);		// Execute the command
 	if (command == PCD_Transceive) {
-		PCD_SetRegisterBitMask(
+		PCD_WriteRegister(
 			mfrc, BitFramingReg,
-			0x80); // StartSend=1, transmission of data starts
+			bitFraming | 0x80); // StartSend=1, transmission of data starts
 	}
+	return STATUS_OK;
+} // End PCD_StartCommand()
+
+/**
+ * Returns true once the command started by PCD_StartCommand() has finished
+ * (successfully or by timeout). With the IRQ pin this does not touch SPI.
+ */
+bool PCD_CommandDone(MFRC522Ptr_t mfrc) {
+	if (mfrc->irq_enabled) {
+		return mfrc->irq_pending;
+	}
+	return PCD_ReadRegister(mfrc, ComIrqReg) & (mfrc->waitIRq | 0x01);
+} // End PCD_CommandDone()
+
+/**
+ * Waits for the command started by PCD_StartCommand() and transfers data back
+ * from the FIFO.
+ * CRC validation can only be done if backData and backLen are specified.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+StatusCode PCD_FinishCommand(
+	MFRC522Ptr_t mfrc,
+	uint8_t *backData,  ///< NULL or pointer to buffer if data should be read
+						///back after executing the command.
+	uint8_t *backLen,   ///< In: Max number of uint8_ts to write to *backData.
+						///Out: The number of uint8_ts returned.
+	uint8_t *validBits, ///< Out: The number of valid bits in the last
+						///uint8_t. 0 for 8 valid bits.
+	uint8_t rxAlign,	///< In: Defines the bit position in backData[0] for the
+						///first bit received. Default 0.
+	bool checkCRC ///< In: True => The last two uint8_ts of the response is
+				  ///assumed to be a CRC_A that must be validated.
+	) {
+	uint8_t n, _validBits = 0;
 
 	// Wait for the command to complete.
 	// In PCD_Init() we set the TAuto flag in TModeReg. This means the timer
 	// automatically starts when the PCD stops transmitting.
-	// Each iteration of the do-while-loop takes 17.86�s.
-	i = 2000;
-	while (1) {
-		n = PCD_ReadRegister(mfrc, ComIrqReg); // ComIrqReg[7..0] bits are: Set1
-											   // TxIRq RxIRq IdleIRq HiAlertIRq
-											   // LoAlertIRq ErrIRq TimerIRq
-		if (n & waitIRq) { // One of the interrupts that signal success has been
-						   // set.
-			break;
-		}
-		if (n & 0x01) { // Timer interrupt - nothing received in 25ms
-			return STATUS_TIMEOUT;
-		}
-		if (--i == 0) { // The emergency break. If all other conditions fail we
-						// will eventually terminate on this one after 35.7ms.
-						// Communication with the MFRC522 might be down.
-			return STATUS_TIMEOUT;
-		}
+	// ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq
+	// LoAlertIRq ErrIRq TimerIRq
+	n = pcd_wait_irq(mfrc, ComIrqReg, mfrc->waitIRq | 0x01,
+					 PCD_COMMAND_TIMEOUT_US);
+	if (!(n & mfrc->waitIRq)) { // Timer interrupt - nothing received in 25ms -
+								// or the emergency break after 36ms.
+								// Communication with the MFRC522 might be down.
+		return STATUS_TIMEOUT;
 	}
 
+	// Error, FIFO level and last-bits status in a single SPI burst
+	static const uint8_t statusRegs[] = {ErrorReg, FIFOLevelReg, ControlReg};
+	uint8_t statusValues[3];
+	PCD_ReadRegisters(mfrc, statusRegs, 3, statusValues);
+
 	// Stop now if any errors except collisions were detected.
-	uint8_t errorRegValue =
-		PCD_ReadRegister(mfrc, ErrorReg); // ErrorReg[7..0] bits are: WrErr
+	uint8_t errorRegValue = statusValues[0]; // ErrorReg[7..0] bits are: WrErr
 										  // TempErr reserved BufferOvfl CollErr
 										  // CRCErr ParityErr ProtocolErr
 	if (errorRegValue & 0x13) {			  // BufferOvfl ParityErr ProtocolErr
@@ -514,15 +899,14 @@ StatusCode PCD_CommunicateWithPICC(
 
 	// If the caller wants data back, get it from the MFRC522.
 	if (backData && backLen) {
-		n = PCD_ReadRegister(mfrc,
-							 FIFOLevelReg); // Number of uint8_ts in the FIFO
+		n = statusValues[1]; // Number of uint8_ts in the FIFO
 		if (n > *backLen) {
 			return STATUS_NO_ROOM;
 		}
 		*backLen = n; // Number of uint8_ts returned
 		PCD_ReadNRegister(mfrc, FIFODataReg, n, backData,
 						  rxAlign); // Get received data from FIFO
-		_validBits = PCD_ReadRegister(mfrc, ControlReg) &
+		_validBits = statusValues[2] &
 					 0x07; // RxLastBits[2:0] indicates the number of valid bits
 						   // in the last received uint8_t. If this value is
 						   // 000b, the whole uint8_t is valid.
@@ -545,6 +929,7 @@ StatusCode PCD_CommunicateWithPICC(
 		// We need at least the CRC_A value and all 8 bits of the last uint8_t
 		// must be received.
 		if (*backLen < 2 || _validBits != 0) {
+			mfrc->crc_errors++;
 			return STATUS_CRC_WRONG;
 		}
 		// Verify CRC_A - do our own calculation and store the control in
@@ -557,11 +942,46 @@ StatusCode PCD_CommunicateWithPICC(
 		}
 		if ((backData[*backLen - 2] != controlBuffer[0]) ||
 			(backData[*backLen - 1] != controlBuffer[1])) {
+			mfrc->crc_errors++;
 			return STATUS_CRC_WRONG;
 		}
 	}
 
 	return STATUS_OK;
+} // End PCD_FinishCommand()
+
+/**
+ * Transfers data to the MFRC522 FIFO, executes a command, waits for completion
+ *and transfers data back from the FIFO.
+ * CRC validation can only be done if backData and backLen are specified.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+StatusCode PCD_CommunicateWithPICC(
+	MFRC522Ptr_t mfrc,
+	uint8_t command, ///< The command to execute. One of the PCD_Command enums.
+	uint8_t waitIRq, ///< The bits in the ComIrqReg register that signals
+					 ///successful completion of the command.
+	uint8_t *sendData,  ///< Pointer to the data to transfer to the FIFO.
+	uint8_t sendLen,	///< Number of uint8_ts to transfer to the FIFO.
+	uint8_t *backData,  ///< NULL or pointer to buffer if data should be read
+						///back after executing the command.
+	uint8_t *backLen,   ///< In: Max number of uint8_ts to write to *backData.
+						///Out: The number of uint8_ts returned.
+	uint8_t *validBits, ///< In/Out: The number of valid bits in the last
+						///uint8_t. 0 for 8 valid bits.
+	uint8_t rxAlign,	///< In: Defines the bit position in backData[0] for the
+						///first bit received. Default 0.
+	bool checkCRC ///< In: True => The last two uint8_ts of the response is
+				  ///assumed to be a CRC_A that must be validated.
+	) {
+	StatusCode status = PCD_StartCommand(mfrc, command, waitIRq, sendData,
+										 sendLen, validBits, rxAlign);
+	if (status != STATUS_OK) {
+		return status;
+	}
+	return PCD_FinishCommand(mfrc, backData, backLen, validBits, rxAlign,
+							 checkCRC);
 } // End PCD_CommunicateWithPICC()
 
 /**
@@ -679,6 +1099,7 @@ StatusCode PICC_Select(MFRC522Ptr_t mfrc,
 	uint8_t cascadeLevel = 1;
 	StatusCode result;
 	uint8_t count;
+	uint8_t checkBit;
 	uint8_t index;
 	uint8_t uidIndex; // The first index in uid->uiduint8_t[] that is used in
 					  // the current Cascade Level.
@@ -874,10 +1295,11 @@ StatusCode PICC_Select(MFRC522Ptr_t mfrc,
 				}
 				// Choose the PICC with the bit set.
 				currentLevelKnownBits = collisionPos;
-				count = (currentLevelKnownBits - 1) % 8; // The bit to modify
+				count = currentLevelKnownBits % 8;
+				checkBit = (currentLevelKnownBits - 1) % 8; // The bit to modify
 				index = 1 + (currentLevelKnownBits / 8) +
 						(count ? 1 : 0); // First uint8_t is index 0.
-				buffer[index] |= (1 << count);
+				buffer[index] |= (1 << checkBit);
 			} else if (result != STATUS_OK) {
 				return result;
 			} else {							   // STATUS_OK
@@ -915,6 +1337,7 @@ StatusCode PICC_Select(MFRC522Ptr_t mfrc,
 		}
 		if ((buffer[2] != responseBuffer[1]) ||
 			(buffer[3] != responseBuffer[2])) {
+			mfrc->crc_errors++;
 			return STATUS_CRC_WRONG;
 		}
 		if (responseBuffer[0] &
@@ -1167,6 +1590,53 @@ StatusCode MIFARE_Ultralight_Write(
 	return STATUS_OK;
 } // End MIFARE_Ultralight_Write()
 
+/**
+ * Reads the pages startPage..endPage with the FAST_READ command (NTAG21x,
+ *MIFARE Ultralight EV1). One frame instead of a READ per 4 pages; limited to
+ *15 pages so the answer and its CRC_A fit in the 64 uint8_t FIFO.
+ * Older Ultralight/Ultralight C answer with a NAK and fall back to IDLE.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+StatusCode MIFARE_Ultralight_FastRead(
+	MFRC522Ptr_t mfrc,
+	uint8_t startPage,  ///< The first page to read.
+	uint8_t endPage,	///< The last page to read (inclusive).
+	uint8_t *buffer,	///< The buffer to store the data in
+	uint8_t *bufferSize ///< Buffer size, at least 4 uint8_ts per page + 2.
+						///Also number of uint8_ts returned if STATUS_OK.
+	) {
+	StatusCode result;
+	uint8_t cmdBuffer[5];
+	uint8_t expected;
+
+	// Sanity check
+	if (buffer == NULL || endPage < startPage || endPage - startPage > 14) {
+		return STATUS_INVALID;
+	}
+	expected = (endPage - startPage + 1) * 4 + 2; // Pages + CRC_A
+	if (*bufferSize < expected) {
+		return STATUS_NO_ROOM;
+	}
+
+	// Build command buffer
+	cmdBuffer[0] = PICC_CMD_UL_FAST_READ;
+	cmdBuffer[1] = startPage;
+	cmdBuffer[2] = endPage;
+	result = PCD_CalculateCRC(mfrc, cmdBuffer, 3, &cmdBuffer[3]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// Transmit the buffer and receive the response, validate CRC_A.
+	result = PCD_TransceiveData(mfrc, cmdBuffer, sizeof(cmdBuffer), buffer,
+								bufferSize, NULL, 0, true);
+	if (result == STATUS_OK && *bufferSize != expected) {
+		return STATUS_ERROR;
+	}
+	return result;
+} // End MIFARE_Ultralight_FastRead()
+
 /**
  * MIFARE Decrement subtracts the delta from the value of the addressed block,
  *and stores the result in a volatile memory.
@@ -2253,6 +2723,82 @@ bool PICC_ReadCardSerial(MFRC522Ptr_t mfrc) {
 	return (result == STATUS_OK);
 } // End
 
+/**
+ * Collects the UIDs of every PICC in the field.
+ * Each round invites the IDLE PICCs with REQA, selects one of them through
+ *the anticollision loop in PICC_Select() and halts it, so it stays silent in
+ *the following rounds. Stops when REQA gets no answer or *uids is full.
+ * All PICCs found are left in state HALT: use PICC_WakeupAndSelect() to talk
+ *to one of them.
+ *
+ * @return The number of UIDs stored in uids[].
+ */
+uint8_t PICC_Inventory(MFRC522Ptr_t mfrc,
+					   Uid *uids,		///< Out: One entry per PICC found.
+					   uint8_t maxCount ///< Number of entries in uids[].
+					   ) {
+	uint8_t count = 0;
+	uint8_t failures = 0;
+	uint8_t i;
+
+	while (count < maxCount && failures < PICC_INVENTORY_MAX_FAILURES) {
+		uint8_t bufferATQA[2];
+		uint8_t bufferSize = sizeof(bufferATQA);
+		StatusCode result = PICC_RequestA(mfrc, bufferATQA, &bufferSize);
+		if (result == STATUS_TIMEOUT) {
+			break; // Nobody left in state IDLE
+		}
+		if (result != STATUS_OK && result != STATUS_COLLISION) {
+			failures++; // Garbled ATQA, usually two PICCs answering
+			continue;
+		}
+
+		Uid *uid = &uids[count];
+		if (PICC_Select(mfrc, uid, 0) != STATUS_OK) {
+			failures++;
+			continue;
+		}
+		PICC_HaltA(mfrc);
+
+		// A PICC that missed the HLTA answers again; list it only once
+		for (i = 0; i < count; i++) {
+			if (uids[i].size == uid->size &&
+				memcmp(uids[i].uidByte, uid->uidByte, uid->size) == 0) {
+				break;
+			}
+		}
+		if (i == count) {
+			count++;
+		} else {
+			failures++;
+		}
+	}
+	return count;
+} // End PICC_Inventory()
+
+/**
+ * Wakes the PICCs in state HALT and selects the one with the given UID, e.g.
+ *an entry returned by PICC_Inventory(). The other PICCs go back to HALT.
+ * On success mfrc->uid holds the UID (and SAK), as after
+ *PICC_ReadCardSerial().
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+StatusCode PICC_WakeupAndSelect(MFRC522Ptr_t mfrc,
+								const Uid *uid ///< The UID to select.
+								) {
+	uint8_t bufferATQA[2];
+	uint8_t bufferSize = sizeof(bufferATQA);
+	StatusCode result = PICC_WakeupA(mfrc, bufferATQA, &bufferSize);
+	if (result != STATUS_OK && result != STATUS_COLLISION) {
+		return result;
+	}
+	// With all UID bits known PICC_Select() sends SELECT directly, no
+	// anticollision rounds
+	mfrc->uid = *uid;
+	return PICC_Select(mfrc, &mfrc->uid, mfrc->uid.size * 8);
+} // End PICC_WakeupAndSelect()
+
 static inline void cs_select(const uint cs) {
     asm volatile("nop \n nop \n nop");
     gpio_put(cs, 0); // Active low
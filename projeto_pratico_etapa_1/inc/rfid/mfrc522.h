@@ -27,12 +27,42 @@
  ******************************************************************************/
 // send only one byte per transfer, see WriteRegister functions
 #define BUFFER_SIZE  1 
-// Defined as 4MHz in the original library
-#define MFRC522_BIT_RATE 4000000 
+// SPI clock. The original library used 4MHz; the MFRC522 accepts up to 10MHz.
+// Lower it here if the wiring to the reader is long.
+#ifndef MFRC522_BIT_RATE
+#define MFRC522_BIT_RATE 10000000
+#endif
+// Drive the reader bus from a PIO state machine (mfrc522_pio_spi.c) on the
+// same pins instead of the SPI0 block, which is then left to the SD card.
+// Set by the RFID_PIO_SPI CMake option.
+#ifndef MFRC522_PIO_SPI
+#define MFRC522_PIO_SPI 0
+#endif
 // Used for ADT object allocation
 #define MFRC_MAX_INSTANCES 2	 
 // Reset pin to MFRC522
 #define RESET_PIN 20
+// Pin argument of MFRC522_InitPins() for a reader without RST or IRQ wired:
+// no hard reset, and command completion found by polling
+#define MFRC522_NO_PIN 0xFFu
+// IRQ pin of the MFRC522 (active low, push-pull). Command completion wakes the
+// core through a GPIO interrupt instead of polling ComIrqReg/DivIrqReg over
+// SPI. Set MFRC522_USE_IRQ to 0 on boards where the pin is not wired.
+#ifndef MFRC522_USE_IRQ
+#define MFRC522_USE_IRQ 1
+#endif
+#define IRQ_PIN 4
+// CRC_A computed on the MCU (table driven) instead of the MFRC522 CRC
+// coprocessor, which costs a FIFO load, a command and two register reads per
+// block. 0 selects the coprocessor, e.g. to validate the software version.
+#ifndef MFRC522_SOFT_CRC
+#define MFRC522_SOFT_CRC 1
+#endif
+// Oscillator restart after soft power-down: crystal start-up + 37.74 us
+// (datasheet 8.8.2). Past this PCD_WarmInit() falls back to PCD_Init().
+#define PCD_POWER_UP_TIMEOUT_US 5000
+// Failed REQA/SELECT rounds tolerated by PICC_Inventory() before it gives up
+#define PICC_INVENTORY_MAX_FAILURES 3
 
 static const uint8_t FIFO_SIZE = 64; // Size of the MFRC522 FIFO
 
@@ -237,7 +267,9 @@ typedef enum _PICC_Command {
 	// http://www.nxp.com/documents/data_sheet/MF0ICU1.pdf, Section 8.6)
 	// The PICC_CMD_MF_READ and PICC_CMD_MF_WRITE can also be used for MIFARE
 	// Ultralight.
-	PICC_CMD_UL_WRITE = 0xA2 // Writes one 4 byte page to the PICC.
+	PICC_CMD_UL_WRITE = 0xA2, // Writes one 4 byte page to the PICC.
+	// NTAG21x and MIFARE Ultralight EV1 only
+	PICC_CMD_UL_FAST_READ = 0x3A // Reads pages start..end in one frame.
 } PICC_Command;
 
 // MIFARE constants that does not fit anywhere else
@@ -304,6 +336,12 @@ struct MFRC522_T {
 	// Variables used in the SSP(SPI) peripheral of the board
 	spi_inst_t *spi; // Select SSP0 or SSP1
 	uint _chipSelectPin; // = {1, 8}; // As default example use GPIO1[8]= P1_5
+	uint _resetPin;		 // MFRC522_NO_PIN: not wired
+	uint _irqPin;		 // MFRC522_NO_PIN: not wired
+	bool irq_enabled;			// false: completion is found by polling
+	volatile bool irq_pending;	// Set by the GPIO interrupt, cleared per command
+	uint8_t waitIRq;			// ComIrqReg bits of the command in flight
+	uint16_t crc_errors;		// Frames received with a bad or short CRC_A
 	uint8_t Tx_Buf[BUFFER_SIZE];
 	uint8_t Rx_Buf[BUFFER_SIZE];
 };
@@ -317,6 +355,16 @@ typedef struct MFRC522_T *MFRC522Ptr_t;
  */
 MFRC522Ptr_t MFRC522_Init();
 
+/**
+ * Sets up an MFRC522 ADT object for a reader on its own pins. All readers
+ * share SCK/MOSI/MISO of SPI0; each one needs its own chip select. RST and
+ * IRQ may be MFRC522_NO_PIN. MFRC522_Init() is this with cs_pin, RESET_PIN
+ * and IRQ_PIN.
+ * @return the instance (the existing one if csPin was already set up), NULL
+ *         when MFRC_MAX_INSTANCES are in use
+ */
+MFRC522Ptr_t MFRC522_InitPins(uint csPin, uint resetPin, uint irqPin);
+
 /*******************************************************************************
 * Basic interface functions for communicating with the MFRC522
 *******************************************************************************/
@@ -326,11 +374,16 @@ void PCD_WriteNRegister(MFRC522Ptr_t mfrc, uint8_t reg, uint8_t count,
 uint8_t PCD_ReadRegister(MFRC522Ptr_t mfrc, uint8_t reg);
 void PCD_ReadNRegister(MFRC522Ptr_t mfrc, uint8_t reg, uint8_t count,
 					   uint8_t *values, uint8_t rxAlign);
+void PCD_ReadRegisters(MFRC522Ptr_t mfrc, const uint8_t *regs, uint8_t count,
+					   uint8_t *values);
 void setBitMask(unsigned char reg, unsigned char mask);
 void PCD_SetRegisterBitMask(MFRC522Ptr_t mfrc, uint8_t reg, uint8_t mask);
 void PCD_ClearRegisterBitMask(MFRC522Ptr_t mfrc, uint8_t reg, uint8_t mask);
 StatusCode PCD_CalculateCRC(MFRC522Ptr_t mfrc, uint8_t *data, uint8_t length,
 							uint8_t *result);
+StatusCode PCD_CalculateCRCOnChip(MFRC522Ptr_t mfrc, uint8_t *data,
+								  uint8_t length, uint8_t *result);
+void PCD_CalculateCRCSoft(const uint8_t *data, uint8_t length, uint8_t *result);
 							
 //Chip select for pi pico SPI
 static inline void cs_select(const uint cs);
@@ -340,6 +393,9 @@ static inline void cs_deselect(const uint cs);
 * Functions for manipulating the MFRC522
 *******************************************************************************/
 void PCD_Init(MFRC522Ptr_t mfrc, spi_inst_t *spi);
+bool PCD_WarmInit(MFRC522Ptr_t mfrc, spi_inst_t *spi);
+void PCD_HoldOutOfReset(uint resetPin);
+void PCD_SoftPowerDown(MFRC522Ptr_t mfrc);
 void PCD_Reset(MFRC522Ptr_t mfrc);
 void PCD_AntennaOn(MFRC522Ptr_t mfrc);
 void PCD_AntennaOff(MFRC522Ptr_t mfrc);
@@ -354,6 +410,13 @@ StatusCode PCD_TransceiveData(MFRC522Ptr_t mfrc, uint8_t *sendData,
 							  uint8_t sendLen, uint8_t *backData,
 							  uint8_t *backLen, uint8_t *validBits,
 							  uint8_t rxAlign, bool checkCRC);
+StatusCode PCD_StartCommand(MFRC522Ptr_t mfrc, uint8_t command, uint8_t waitIRq,
+							uint8_t *sendData, uint8_t sendLen,
+							uint8_t *validBits, uint8_t rxAlign);
+bool PCD_CommandDone(MFRC522Ptr_t mfrc);
+StatusCode PCD_FinishCommand(MFRC522Ptr_t mfrc, uint8_t *backData,
+							 uint8_t *backLen, uint8_t *validBits,
+							 uint8_t rxAlign, bool checkCRC);
 StatusCode PCD_CommunicateWithPICC(MFRC522Ptr_t mfrc, uint8_t command,
 								   uint8_t waitIRq, uint8_t *sendData,
 								   uint8_t sendLen, uint8_t *backData,
@@ -380,6 +443,9 @@ StatusCode MIFARE_Write(MFRC522Ptr_t mfrc, uint8_t blockAddr, uint8_t *buffer,
 						uint8_t bufferSize);
 StatusCode MIFARE_Ultralight_Write(MFRC522Ptr_t mfrc, uint8_t page,
 								   uint8_t *buffer, uint8_t bufferSize);
+StatusCode MIFARE_Ultralight_FastRead(MFRC522Ptr_t mfrc, uint8_t startPage,
+									  uint8_t endPage, uint8_t *buffer,
+									  uint8_t *bufferSize);
 StatusCode MIFARE_Decrement(MFRC522Ptr_t mfrc, uint8_t blockAddr, long delta);
 StatusCode MIFARE_Increment(MFRC522Ptr_t mfrc, uint8_t blockAddr, long delta);
 StatusCode MIFARE_Restore(MFRC522Ptr_t mfrc, uint8_t blockAddr);
@@ -395,6 +461,7 @@ StatusCode PCD_NTAG216_AUTH(MFRC522Ptr_t mfrc, uint8_t *passWord,
 StatusCode PCD_MIFARE_Transceive(MFRC522Ptr_t mfrc, uint8_t *sendData,
 								 uint8_t sendLen, bool acceptTimeout);
 const char *GetStatusCodeName(StatusCode code);
+PICC_Type PICC_GetType(uint8_t sak);
 const char *PICC_GetTypeName(PICC_Type type);
 StatusCode MIFARE_TwoStepHelper(MFRC522Ptr_t mfrc, uint8_t command,
 								uint8_t blockAddr, long data);
@@ -422,5 +489,7 @@ bool MIFARE_UnbrickUidSector(MFRC522Ptr_t mfrc, bool logErrors);
 *******************************************************************************/
 bool PICC_IsNewCardPresent(MFRC522Ptr_t mfrc);
 bool PICC_ReadCardSerial(MFRC522Ptr_t mfrc);
+uint8_t PICC_Inventory(MFRC522Ptr_t mfrc, Uid *uids, uint8_t maxCount);
+StatusCode PICC_WakeupAndSelect(MFRC522Ptr_t mfrc, const Uid *uid);
 
 #endif
\ No newline at end of file
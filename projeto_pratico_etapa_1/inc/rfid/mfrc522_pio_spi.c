@@ -0,0 +1,133 @@
+/**
+* mfrc522 library for pi pico c/c++ sdk
+* Bus of the MFRC522 on a PIO state machine, see mfrc522_pio_spi.h.
+*/
+
+#include "mfrc522_pio_spi.h"
+#include <stdio.h>
+#include <string.h>
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "mfrc522_spi.pio.h"
+
+static PIO pcd_pio;
+static uint pcd_sm;
+static int pcd_dma_tx = -1;
+static int pcd_dma_rx = -1; // -1: no DMA, the CPU feeds the FIFOs
+static bool pcd_pio_ready = false;
+
+bool PCD_PioInit(uint sckPin, uint mosiPin, uint misoPin, uint baudrate) {
+	uint offset;
+	uint lo, hi;
+
+	if (pcd_pio_ready) {
+		return true;
+	}
+	lo = MIN(sckPin, MIN(mosiPin, misoPin));
+	hi = MAX(sckPin, MAX(mosiPin, misoPin));
+	if (!pio_claim_free_sm_and_add_program_for_gpio_range(
+			&mfrc522_spi_program, &pcd_pio, &pcd_sm, &offset, lo, hi - lo + 1,
+			true)) {
+		printf("[MFRC522] No free PIO state machine for the reader bus\n");
+		return false;
+	}
+
+	pio_sm_config c = mfrc522_spi_program_get_default_config(offset);
+	sm_config_set_out_pins(&c, mosiPin, 1);
+	sm_config_set_in_pins(&c, misoPin);
+	sm_config_set_sideset_pins(&c, sckPin);
+	// MSB first: shift left, autopull/autopush every 8 bits
+	sm_config_set_out_shift(&c, false, true, 8);
+	sm_config_set_in_shift(&c, false, true, 8);
+	float div = (float)clock_get_hz(clk_sys) / (4.0f * baudrate);
+	sm_config_set_clkdiv(&c, div < 1.0f ? 1.0f : div);
+
+	// SCK and MOSI low, MISO input
+	pio_sm_set_pins_with_mask(pcd_pio, pcd_sm, 0, (1u << sckPin) | (1u << mosiPin));
+	pio_sm_set_pindirs_with_mask(pcd_pio, pcd_sm, (1u << sckPin) | (1u << mosiPin),
+								 (1u << sckPin) | (1u << mosiPin) | (1u << misoPin));
+	pio_gpio_init(pcd_pio, mosiPin);
+	pio_gpio_init(pcd_pio, misoPin);
+	pio_gpio_init(pcd_pio, sckPin);
+	// The bus is synchronous: skip the 2-cycle input synchroniser on MISO
+	hw_set_bits(&pcd_pio->input_sync_bypass, 1u << misoPin);
+
+	pio_sm_init(pcd_pio, pcd_sm, offset, &c);
+	pio_sm_set_enabled(pcd_pio, pcd_sm, true);
+
+	pcd_dma_tx = dma_claim_unused_channel(false);
+	pcd_dma_rx = dma_claim_unused_channel(false);
+	if (pcd_dma_tx < 0 || pcd_dma_rx < 0) {
+		if (pcd_dma_tx >= 0) {
+			dma_channel_unclaim(pcd_dma_tx);
+		}
+		if (pcd_dma_rx >= 0) {
+			dma_channel_unclaim(pcd_dma_rx);
+		}
+		pcd_dma_tx = pcd_dma_rx = -1;
+	}
+	pcd_pio_ready = true;
+	return true;
+}
+
+/**
+ * DMA-fed transfer. The RX channel is armed first and always runs, into a
+ * scratch byte for writes, so autopush never stalls the state machine.
+ */
+static void pcd_pio_transfer_dma(const uint8_t *tx, uint8_t *rx, size_t len) {
+	static uint8_t discard;
+	dma_channel_config c;
+
+	c = dma_channel_get_default_config(pcd_dma_rx);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, false);
+	channel_config_set_write_increment(&c, rx != NULL);
+	channel_config_set_dreq(&c, pio_get_dreq(pcd_pio, pcd_sm, false));
+	dma_channel_configure(pcd_dma_rx, &c, rx ? rx : &discard,
+						  &pcd_pio->rxf[pcd_sm], len, true);
+
+	c = dma_channel_get_default_config(pcd_dma_tx);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, true);
+	channel_config_set_write_increment(&c, false);
+	channel_config_set_dreq(&c, pio_get_dreq(pcd_pio, pcd_sm, true));
+	dma_channel_configure(pcd_dma_tx, &c, &pcd_pio->txf[pcd_sm], tx, len,
+						  true);
+
+	// The last RX byte arrives after the last SCK edge: the frame is over
+	dma_channel_wait_for_finish_blocking(pcd_dma_rx);
+}
+
+void PCD_PioTransfer(const uint8_t *tx, uint8_t *rx, size_t len) {
+	if (!pcd_pio_ready) {
+		if (rx) {
+			memset(rx, 0, len);
+		}
+		return;
+	}
+	if (len >= PCD_PIO_DMA_MIN_LEN && pcd_dma_rx >= 0) {
+		pcd_pio_transfer_dma(tx, rx, len);
+		return;
+	}
+
+	// 8-bit accesses: a byte store is replicated to the top lane the
+	// left-shifting OSR sends first; a byte load takes the ISR's low lane
+	io_rw_8 *txfifo = (io_rw_8 *)&pcd_pio->txf[pcd_sm];
+	io_rw_8 *rxfifo = (io_rw_8 *)&pcd_pio->rxf[pcd_sm];
+	size_t tx_remain = len;
+	size_t rx_remain = len;
+	while (tx_remain || rx_remain) {
+		if (tx_remain && !pio_sm_is_tx_fifo_full(pcd_pio, pcd_sm)) {
+			*txfifo = *tx++;
+			tx_remain--;
+		}
+		if (rx_remain && !pio_sm_is_rx_fifo_empty(pcd_pio, pcd_sm)) {
+			uint8_t b = *rxfifo;
+			if (rx) {
+				*rx++ = b;
+			}
+			rx_remain--;
+		}
+	}
+}
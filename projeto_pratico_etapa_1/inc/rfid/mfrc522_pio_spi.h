@@ -0,0 +1,38 @@
+/*
+ * mfrc522_pio_spi.h
+ *
+ * Bus of the MFRC522 on a PIO state machine (mfrc522_spi.pio) instead of
+ * the SPI0 block. The reader keeps its pins and SPI0 stays with the SD card,
+ * so the two no longer have to hand the bus over on every access.
+ * Built when MFRC522_PIO_SPI is 1 (CMake option RFID_PIO_SPI).
+ */
+
+#ifndef MFRC522_PIO_SPI_h
+#define MFRC522_PIO_SPI_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "pico/types.h"
+
+// Transfers at least this long go through DMA (FIFO loads and burst reads);
+// shorter ones (register access) are cheaper with the CPU feeding the FIFOs
+#ifndef PCD_PIO_DMA_MIN_LEN
+#define PCD_PIO_DMA_MIN_LEN 8
+#endif
+
+/**
+ * Claims a state machine and two DMA channels and starts the bus. Safe to
+ * call again (e.g. once per reader): later calls do nothing.
+ * @return false if no PIO had room for the program
+ */
+bool PCD_PioInit(uint sckPin, uint mosiPin, uint misoPin, uint baudrate);
+
+/**
+ * Clocks len bytes out of tx and the same number in. Chip select is up to the
+ * caller. rx may be NULL for writes. Before a successful PCD_PioInit() nothing
+ * is clocked and rx reads as zeros, like a reader that does not answer.
+ */
+void PCD_PioTransfer(const uint8_t *tx, uint8_t *rx, size_t len);
+
+#endif
@@ -0,0 +1,130 @@
+// Arquivo: inc/rfid/provisioning.c
+
+#include "provisioning.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+static prv_entry_t *prv_entries;
+static uint32_t prv_capacity;
+static uint32_t prv_count;
+static uint32_t prv_done;
+static uint32_t prv_next;  // Nenhum aluno sem cartão pendente antes deste
+
+// Tira os espaços das pontas (no próprio buffer)
+static char *prv_trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+// UID em hex (8 ou 14 dígitos); "" é um aluno sem cartão
+static bool prv_parse_uid(const char *hex, uint8_t uid[7], uint8_t *size) {
+    size_t len = strlen(hex);
+    if (len != 0 && len != 8 && len != 14) return false;
+    for (size_t i = 0; i < len / 2; i++) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+        char *end;
+        uid[i] = (uint8_t)strtoul(byte, &end, 16);
+        if (*end) return false;
+    }
+    *size = (uint8_t)(len / 2);
+    return true;
+}
+
+// Rotas "1/3/7" -> bits 0, 2 e 6; "" = todas (0)
+static bool prv_parse_routes(char *txt, uint32_t *bitmap) {
+    *bitmap = 0;
+    for (char *tok = strtok(txt, "/"); tok; tok = strtok(NULL, "/")) {
+        char *end;
+        unsigned long route = strtoul(prv_trim(tok), &end, 10);
+        if (*end || route < 1 || route > 32) return false;
+        *bitmap |= 1u << (route - 1);
+    }
+    return true;
+}
+
+static prv_entry_t *prv_find(const uint8_t *uid, uint8_t size) {
+    for (uint32_t i = 0; i < prv_count; i++) {
+        prv_entry_t *e = &prv_entries[i];
+        if (e->uid_size == size && memcmp(e->uid, uid, size) == 0) return e;
+    }
+    return NULL;
+}
+
+bool Prv_Reset(uint32_t capacity) {
+    prv_count = 0;
+    prv_done = 0;
+    prv_next = 0;
+    if (capacity > PRV_MAX_STUDENTS) capacity = PRV_MAX_STUDENTS;
+    if (capacity != prv_capacity) {
+        free(prv_entries);
+        prv_entries = capacity ? malloc(capacity * sizeof *prv_entries) : NULL;
+        prv_capacity = prv_entries ? capacity : 0;
+    }
+    return prv_capacity == capacity;
+}
+
+bool Prv_AddLine(const char *line) {
+    char buf[96];
+    strncpy(buf, line, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    buf[strcspn(buf, "\r\n#")] = '\0';
+    if (!*prv_trim(buf)) return true;
+
+    char *id_txt = strchr(buf, ',');
+    char *name = id_txt ? strchr(id_txt + 1, ',') : NULL;
+    if (!name || prv_count == prv_capacity) return false;
+    *id_txt++ = '\0';
+    *name++ = '\0';
+    char *routes_txt = strchr(name, ',');
+    if (routes_txt) *routes_txt++ = '\0';
+    name = prv_trim(name);
+    id_txt = prv_trim(id_txt);
+
+    prv_entry_t *e = &prv_entries[prv_count];
+    memset(e, 0, sizeof *e);
+    char *end;
+    unsigned long id = strtoul(id_txt, &end, 10);
+    uint32_t routes = 0;
+    if (!prv_parse_uid(prv_trim(buf), e->uid, &e->uid_size) || !*id_txt || *end || !*name ||
+        (routes_txt && !prv_parse_routes(routes_txt, &routes))) {
+        return false;
+    }
+    if (e->uid_size && prv_find(e->uid, e->uid_size)) return false;
+    Tdh_PrepareV4Identity(&e->ident, (uint32_t)id, name, routes);
+    prv_count++;
+    return true;
+}
+
+prv_entry_t *Prv_Assign(const Uid *uid) {
+    if (uid->size > sizeof prv_entries->uid) return NULL;
+    prv_entry_t *e = prv_find(uid->uidByte, uid->size);
+    if (e) return e;
+    while (prv_next < prv_count &&
+           (prv_entries[prv_next].uid_size || prv_entries[prv_next].state == PRV_DONE)) {
+        prv_next++;
+    }
+    return prv_next < prv_count ? &prv_entries[prv_next] : NULL;
+}
+
+void Prv_Complete(prv_entry_t *entry, const Uid *uid, bool ok) {
+    if (!ok || uid->size > sizeof entry->uid) {
+        if (entry->state != PRV_DONE) entry->state = PRV_FAILED;
+        return;
+    }
+    if (entry->state != PRV_DONE) prv_done++;
+    entry->state = PRV_DONE;
+    memcpy(entry->uid, uid->uidByte, uid->size);
+    entry->uid_size = uid->size;
+}
+
+uint32_t Prv_Count(void) {
+    return prv_count;
+}
+
+uint32_t Prv_Done(void) {
+    return prv_done;
+}
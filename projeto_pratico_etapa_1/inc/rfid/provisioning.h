@@ -0,0 +1,65 @@
+#ifndef PROVISIONING_H
+#define PROVISIONING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mfrc522.h"
+#include "tag_data_handler.h"
+
+// --- Provisionamento em lote ---
+// Lista de alunos no formato do csv do cadastro ("uid_hex,id,nome"), com uma
+// quarta coluna opcional de rotas permitidas ("1/3"; vazia = todas). Os
+// registros ficam montados na RAM antes do primeiro cartão, numa lista
+// alocada por Prv_Reset() do tamanho do lote. Cada cartão
+// apresentado recebe o aluno do seu UID ou, se o UID não está na lista, o
+// próximo aluno sem UID (linha ",id,nome").
+
+// Alunos por lote (44 bytes cada na heap, só no modo de provisionamento)
+#ifndef PRV_MAX_STUDENTS
+#define PRV_MAX_STUDENTS 512
+#endif
+
+typedef enum {
+    PRV_PENDING = 0,
+    PRV_DONE,
+    PRV_FAILED,          // Última tentativa falhou; volta na próxima
+} prv_state_t;
+
+typedef struct {
+    TdhV4Identity ident;     // Pronta para gravar (Tdh_ProvisionAnyCard())
+    uint8_t uid[7];
+    uint8_t uid_size;        // 0: aluno ainda sem cartão
+    uint8_t state;           // prv_state_t
+} prv_entry_t;
+
+/**
+ * @brief Esvazia a lista e a realoca para capacity alunos (no máximo
+ * PRV_MAX_STUDENTS).
+ * @return false se faltou memória (lista sem espaço para alunos).
+ */
+bool Prv_Reset(uint32_t capacity);
+
+/**
+ * @brief Acrescenta o aluno de uma linha do csv. Linhas vazias e
+ * comentários ('#') são aceitas sem gerar aluno.
+ * @return false se a linha for inválida, o UID repetido ou a lista estiver cheia.
+ */
+bool Prv_AddLine(const char *line);
+
+/**
+ * @brief Aluno a gravar no cartão: o do UID, senão o primeiro sem cartão
+ * ainda não gravado. Um aluno já gravado volta com state PRV_DONE.
+ * @return NULL se o UID não está na lista e não sobrou aluno sem cartão, ou
+ * se o UID não cabe em prv_entry_t (10 bytes).
+ */
+prv_entry_t *Prv_Assign(const Uid *uid);
+
+/**
+ * @brief Registra o resultado da gravação; com ok, o aluno fica com o UID.
+ */
+void Prv_Complete(prv_entry_t *entry, const Uid *uid, bool ok);
+
+uint32_t Prv_Count(void);
+uint32_t Prv_Done(void);
+
+#endif // PROVISIONING_H
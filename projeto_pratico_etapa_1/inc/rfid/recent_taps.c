@@ -0,0 +1,98 @@
+// Arquivo: inc/rfid/recent_taps.c
+
+#include "recent_taps.h"
+#include "pico/stdlib.h"
+#include <string.h>
+
+#define RTP_MASK (RTP_TABLE_SIZE - 1)
+
+static rtp_table_t *rtp = NULL;
+static uint32_t rtp_clock_base;  // clock_ms - to_ms_since_boot() neste boot
+
+// Relógio monotônico da tabela, contínuo entre resets
+static uint32_t rtp_now(void) {
+    rtp->clock_ms = rtp_clock_base + to_ms_since_boot(get_absolute_time());
+    return rtp->clock_ms;
+}
+
+static bool rtp_expired(const rtp_entry_t *e, uint32_t now) {
+    return now - e->boarded_ms >= rtp->window_ms;
+}
+
+// FNV-1a sobre os bytes do UID
+static uint32_t rtp_hash(const Uid *uid) {
+    uint32_t h = 2166136261u;
+    for (uint8_t i = 0; i < uid->size; i++) {
+        h = (h ^ uid->uidByte[i]) * 16777619u;
+    }
+    return h;
+}
+
+static bool rtp_matches(const rtp_entry_t *e, const Uid *uid) {
+    return e->size == uid->size && memcmp(e->uid, uid->uidByte, uid->size) == 0;
+}
+
+void Rtp_Init(rtp_table_t *table, uint32_t window_ms) {
+    rtp = table;
+    if (table->magic != RTP_TABLE_MAGIC) {
+        memset(table, 0, sizeof *table);
+        table->magic = RTP_TABLE_MAGIC;
+    }
+    table->window_ms = window_ms;
+    rtp_clock_base = table->clock_ms - to_ms_since_boot(get_absolute_time());
+}
+
+void Rtp_SetWindow(uint32_t window_ms) {
+    if (rtp) rtp->window_ms = window_ms;
+}
+
+bool Rtp_IsRecent(const Uid *uid) {
+    if (!rtp || !rtp->window_ms || uid->size > sizeof rtp->entries[0].uid) return false;
+    uint32_t now = rtp_now();
+    // Sondagem linear; uma entrada nunca usada encerra a busca
+    uint32_t h = rtp_hash(uid);
+    for (uint32_t i = 0; i < RTP_TABLE_SIZE; i++) {
+        const rtp_entry_t *e = &rtp->entries[(h + i) & RTP_MASK];
+        if (!e->size) break;
+        if (rtp_matches(e, uid)) {
+            if (rtp_expired(e, now)) return false;
+            rtp->suppressed++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Rtp_Remember(const Uid *uid) {
+    if (!rtp || !rtp->window_ms || uid->size > sizeof rtp->entries[0].uid) return;
+    uint32_t now = rtp_now();
+    uint32_t h = rtp_hash(uid);
+
+    // O próprio UID, senão a primeira entrada livre ou expirada da sondagem
+    // (expiradas continuam ocupadas para não cortar a busca de outros UIDs)
+    rtp_entry_t *slot = NULL;
+    rtp_entry_t *oldest = NULL;
+    for (uint32_t i = 0; i < RTP_TABLE_SIZE; i++) {
+        rtp_entry_t *e = &rtp->entries[(h + i) & RTP_MASK];
+        if (rtp_matches(e, uid)) {
+            slot = e;
+            break;
+        }
+        if (!slot && (!e->size || rtp_expired(e, now))) slot = e;
+        if (!e->size) break;
+        if (!oldest || now - e->boarded_ms > now - oldest->boarded_ms) oldest = e;
+    }
+    if (!slot) {
+        // Cheia e tudo na janela: sai o embarque mais antigo
+        slot = oldest;
+        rtp->evicted++;
+    }
+    memcpy(slot->uid, uid->uidByte, uid->size);
+    slot->size = uid->size;
+    slot->boarded_ms = now;
+}
+
+void Rtp_Clear(void) {
+    if (!rtp) return;
+    memset(rtp->entries, 0, sizeof rtp->entries);
+}
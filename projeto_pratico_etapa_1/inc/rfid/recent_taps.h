@@ -0,0 +1,73 @@
+#ifndef RECENT_TAPS_H
+#define RECENT_TAPS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mfrc522.h"
+
+// --- Supressão de toques repetidos ---
+// Tabela hash de tamanho fixo com os UIDs embarcados há pouco. Um cartão que
+// volta dentro da janela é confirmado só pelo UID do inventário, sem
+// autenticar, ler, gravar no cartão nem gerar registro no SD e no envio.
+// Cheia, a tabela descarta o embarque mais antigo (LRU).
+
+// Entradas na tabela (potência de 2)
+#ifndef RTP_TABLE_SIZE
+#define RTP_TABLE_SIZE 32
+#endif
+#if RTP_TABLE_SIZE & (RTP_TABLE_SIZE - 1)
+#error "RTP_TABLE_SIZE deve ser potência de 2"
+#endif
+
+// Janela padrão; cada rota pode usar a sua (Rtp_SetWindow())
+#ifndef RTP_WINDOW_MS
+#define RTP_WINDOW_MS 60000
+#endif
+
+typedef struct {
+    uint8_t uid[7];          // UIDs de 4 ou 7 bytes (os de 10 não são guardados)
+    uint8_t size;            // 0 = entrada nunca usada
+    uint32_t boarded_ms;     // Relógio da tabela no embarque
+} rtp_entry_t;
+
+/**
+ * @brief Tabela completa. Pode ficar numa região de RAM que sobrevive ao
+ * reset do watchdog: Rtp_Init() reaproveita o conteúdo se o magic conferir.
+ */
+typedef struct {
+    uint32_t magic;          // RTP_TABLE_MAGIC
+    uint32_t window_ms;
+    uint32_t clock_ms;       // Relógio da tabela no último acesso
+    uint32_t suppressed;     // Toques repetidos confirmados sem leitura
+    uint32_t evicted;        // Embarques descartados ainda dentro da janela
+    rtp_entry_t entries[RTP_TABLE_SIZE];
+} rtp_table_t;
+
+#define RTP_TABLE_MAGIC 0x52545031  // "RTP1"
+
+/**
+ * @brief Passa a usar table. Com magic válido, mantém os embarques
+ * anteriores: o relógio da tabela continua de onde parou, sem contar o tempo
+ * do reset e dos outros modos (as entradas só expiram mais tarde, nunca
+ * antes). Senão, começa vazia.
+ * @param window_ms Janela de supressão; 0 desliga.
+ */
+void Rtp_Init(rtp_table_t *table, uint32_t window_ms);
+
+void Rtp_SetWindow(uint32_t window_ms);
+
+/**
+ * @brief Confere se o UID embarcou dentro da janela. Um acerto conta em
+ * suppressed e não renova a entrada: a janela vale a partir do embarque.
+ */
+bool Rtp_IsRecent(const Uid *uid);
+
+/**
+ * @brief Registra o embarque do UID agora.
+ */
+void Rtp_Remember(const Uid *uid);
+
+// Esquece todos os embarques (ex.: fim da rota)
+void Rtp_Clear(void);
+
+#endif // RECENT_TAPS_H
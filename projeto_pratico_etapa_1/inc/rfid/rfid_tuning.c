@@ -0,0 +1,217 @@
+// Arquivo: inc/rfid/rfid_tuning.c
+
+#include "rfid_tuning.h"
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+// Degraus de ganho do receptor (os códigos 010b e 011b repetem 18/23 dB)
+static const uint8_t rx_gain_steps[] = {
+    RxGain_18dB, RxGain_23dB, RxGain_33dB, RxGain_38dB, RxGain_43dB, RxGain_48dB,
+};
+#define RX_GAIN_STEPS (sizeof(rx_gain_steps) / sizeof(rx_gain_steps[0]))
+
+// TxASKReg: Force100ASK (modulação 100% ASK), a única do ISO 14443A; não
+// entra na varredura
+#define RFT_TX_ASK 0x40
+
+// ModeReg de PCD_Init(): TxWaitRF, PolMFin alto, CRC preset 6363h. Não muda
+// o enlace de RF; fica no perfil para que Rft_Apply() seja completo
+#define RFT_MODE_DEFAULT 0x3D
+
+// Perfil em uso e monitor de cada leitor: portas diferentes têm antenas e
+// cabos diferentes, então as falhas de uma não mexem no ganho da outra
+typedef struct {
+    MFRC522Ptr_t mfrc;
+    rft_profile_t current;
+    uint8_t taps;
+    uint8_t failures;
+    uint8_t last_fail_pct;
+    int8_t direction;       // Próximo passo de ganho: +1 ou -1
+    bool just_nudged;
+} rft_reader_t;
+
+static rft_reader_t rft_readers[MFRC_MAX_INSTANCES];
+
+static rft_reader_t *reader_for(MFRC522Ptr_t mfrc) {
+    for (uint8_t i = 0; i < MFRC_MAX_INSTANCES; i++) {
+        if (rft_readers[i].mfrc == mfrc) return &rft_readers[i];
+    }
+    for (uint8_t i = 0; i < MFRC_MAX_INSTANCES; i++) {
+        if (!rft_readers[i].mfrc) {
+            rft_readers[i] = (rft_reader_t){.mfrc = mfrc, .direction = 1};
+            return &rft_readers[i];
+        }
+    }
+    // Mais leitores que instâncias do driver não acontece; reaproveita o primeiro
+    return &rft_readers[0];
+}
+
+static uint8_t profile_checksum(const rft_profile_t *profile) {
+    const uint8_t *p = (const uint8_t *)profile;
+    uint8_t sum = 0;
+    for (size_t i = 0; i < offsetof(rft_profile_t, checksum); i++) {
+        sum ^= p[i];
+    }
+    return sum;
+}
+
+void Rft_DefaultProfile(rft_profile_t *profile) {
+    memset(profile, 0, sizeof(*profile));
+    profile->magic = RFT_PROFILE_MAGIC;
+    profile->rx_gain = RxGain_avg;  // Padrão do chip após o reset
+    profile->tx_ask = RFT_TX_ASK;
+    profile->mode = RFT_MODE_DEFAULT;
+    profile->checksum = profile_checksum(profile);
+}
+
+bool Rft_IsValidProfile(const rft_profile_t *profile) {
+    return profile->magic == RFT_PROFILE_MAGIC && profile->checksum == profile_checksum(profile);
+}
+
+void Rft_Apply(MFRC522Ptr_t mfrc, const rft_profile_t *profile) {
+    PCD_SetAntennaGain(mfrc, profile->rx_gain);
+    PCD_WriteRegister(mfrc, TxASKReg, profile->tx_ask);
+    PCD_WriteRegister(mfrc, ModeReg, profile->mode);
+    reader_for(mfrc)->current = *profile;
+}
+
+static uint8_t gain_index(uint8_t rx_gain) {
+    for (uint8_t i = 0; i < RX_GAIN_STEPS; i++) {
+        if (rx_gain_steps[i] == rx_gain) return i;
+    }
+    return 2;  // 33 dB
+}
+
+static unsigned gain_db(uint8_t rx_gain) {
+    static const uint8_t db[] = {18, 23, 33, 38, 43, 48};
+    return db[gain_index(rx_gain)];
+}
+
+// --- Calibração ---
+
+// Uma leitura completa do cartão de referência, como num embarque
+static bool cal_trial(MFRC522Ptr_t mfrc, const Uid *ref) {
+    static MIFARE_Key factory_key = {{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
+    uint8_t buffer[18];
+    uint8_t size = sizeof(buffer);
+    StatusCode status = PICC_WakeupAndSelect(mfrc, ref);
+
+    if (status == STATUS_OK && PICC_GetType(mfrc->uid.sak) != PICC_TYPE_MIFARE_UL) {
+        status = PCD_Authenticate(mfrc, PICC_CMD_MF_AUTH_KEY_A, 4, &factory_key, &mfrc->uid);
+    }
+    if (status == STATUS_OK) {
+        status = MIFARE_Read(mfrc, 4, buffer, &size);
+    }
+    PICC_HaltA(mfrc);
+    PCD_StopCrypto1(mfrc);
+    return status == STATUS_OK;
+}
+
+bool Rft_Calibrate(MFRC522Ptr_t mfrc, uint8_t trials, rft_profile_t *best) {
+    Uid ref;
+    if (PICC_Inventory(mfrc, &ref, 1) == 0) {
+        printf("[RFT] Nenhum cartao de referencia no leitor.\n");
+        return false;
+    }
+    printf("[RFT] Calibrando com o cartao %02X%02X%02X%02X (%s), %u tentativas por ajuste\n",
+           ref.uidByte[0], ref.uidByte[1], ref.uidByte[2], ref.uidByte[3],
+           PICC_GetTypeName(PICC_GetType(ref.sak)), trials);
+    printf("[RFT]  ganho  sucesso  media_us\n");
+
+    rft_profile_t candidate;
+    Rft_DefaultProfile(&candidate);
+    *best = candidate;
+    best->success_pct = 0;
+    bool found = false;
+
+    for (uint8_t g = 0; g < RX_GAIN_STEPS; g++) {
+        candidate.rx_gain = rx_gain_steps[g];
+        Rft_Apply(mfrc, &candidate);
+        watchdog_update();
+
+        uint8_t ok = 0;
+        uint32_t total_us = 0;
+        for (uint8_t t = 0; t < trials; t++) {
+            uint64_t t0 = time_us_64();
+            if (cal_trial(mfrc, &ref)) {
+                ok++;
+                total_us += (uint32_t)(time_us_64() - t0);
+            }
+        }
+        candidate.success_pct = trials ? (uint8_t)(100u * ok / trials) : 0;
+        candidate.mean_us = ok ? (uint16_t)(total_us / ok) : 0;
+        printf("[RFT]  %2u dB   %3u%%    %5u\n", gain_db(candidate.rx_gain),
+               candidate.success_pct, candidate.mean_us);
+
+        if (ok && (candidate.success_pct > best->success_pct ||
+                   (candidate.success_pct == best->success_pct &&
+                    candidate.mean_us < best->mean_us))) {
+            *best = candidate;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        printf("[RFT] Nenhum ajuste leu o cartao; mantendo o padrao.\n");
+        Rft_DefaultProfile(best);
+        Rft_Apply(mfrc, best);
+        return false;
+    }
+    best->checksum = profile_checksum(best);
+    Rft_Apply(mfrc, best);
+    printf("[RFT] Escolhido: %u dB (%u%%, %u us)\n", gain_db(best->rx_gain),
+           best->success_pct, best->mean_us);
+
+    rft_reader_t *r = reader_for(mfrc);
+    r->taps = r->failures = 0;
+    r->just_nudged = false;
+    return true;
+}
+
+// --- Monitor em operação ---
+
+bool Rft_RecordTap(MFRC522Ptr_t mfrc, StatusCode status) {
+    rft_reader_t *r = reader_for(mfrc);
+    switch (status) {
+        case STATUS_OK:
+            break;
+        case STATUS_TIMEOUT:
+        case STATUS_COLLISION:
+        case STATUS_ERROR:
+        case STATUS_CRC_WRONG:
+            r->failures++;
+            break;
+        default:
+            return false;
+    }
+    r->taps++;
+    if (r->taps < RFT_MONITOR_WINDOW) return false;
+
+    uint8_t fail_pct = (uint8_t)(100u * r->failures / r->taps);
+    r->taps = r->failures = 0;
+
+    // O último passo piorou: inverte a direção
+    if (r->just_nudged && fail_pct > r->last_fail_pct) {
+        r->direction = -r->direction;
+    }
+    r->last_fail_pct = fail_pct;
+    r->just_nudged = false;
+    if (fail_pct <= RFT_MONITOR_MAX_FAIL_PCT) return false;
+
+    int idx = gain_index(r->current.rx_gain) + r->direction;
+    if (idx < 0 || idx >= (int)RX_GAIN_STEPS) {
+        r->direction = -r->direction;
+        idx = gain_index(r->current.rx_gain) + r->direction;
+    }
+    rft_profile_t nudged = r->current;
+    nudged.rx_gain = rx_gain_steps[idx];
+    nudged.checksum = profile_checksum(&nudged);
+    printf("[RFT] %u%% de falhas nas ultimas %u leituras: ganho %u -> %u dB\n", fail_pct,
+           RFT_MONITOR_WINDOW, gain_db(r->current.rx_gain), gain_db(nudged.rx_gain));
+    Rft_Apply(mfrc, &nudged);
+    r->just_nudged = true;
+    return true;
+}
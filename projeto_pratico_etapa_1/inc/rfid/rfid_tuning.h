@@ -0,0 +1,78 @@
+#ifndef RFID_TUNING_H
+#define RFID_TUNING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mfrc522.h"
+
+// Arquivo no cartão SD com o perfil escolhido pela calibração
+#define RFT_PROFILE_FILE "rfid_cal.bin"
+
+// Calibração: tentativas (selecionar, autenticar, ler) por combinação testada
+#ifndef RFT_CAL_TRIALS
+#define RFT_CAL_TRIALS 10
+#endif
+
+// Monitor: a cada RFT_MONITOR_WINDOW leituras, se mais de
+// RFT_MONITOR_MAX_FAIL_PCT % falharam, o ganho do receptor sobe ou desce um passo
+#ifndef RFT_MONITOR_WINDOW
+#define RFT_MONITOR_WINDOW 20
+#endif
+#ifndef RFT_MONITOR_MAX_FAIL_PCT
+#define RFT_MONITOR_MAX_FAIL_PCT 20
+#endif
+
+/**
+ * @brief Ajustes de RF do MFRC522 (gravados no SD como estão).
+ */
+typedef struct {
+    uint32_t magic;        // RFT_PROFILE_MAGIC
+    uint8_t rx_gain;       // RFCfgReg RxGain[2:0] (valores de PCD_RxGain)
+    uint8_t tx_ask;        // TxASKReg (bit 6: Force100ASK)
+    uint8_t mode;          // ModeReg
+    uint8_t success_pct;   // Taxa de sucesso medida na calibração
+    uint16_t mean_us;      // Latência média de uma leitura bem-sucedida
+    uint8_t reserved;
+    uint8_t checksum;      // XOR dos bytes anteriores
+} rft_profile_t;
+
+#define RFT_PROFILE_MAGIC 0x52464331  // "RFC1"
+
+/**
+ * @brief Perfil padrão, igual ao que PCD_Init() configura.
+ */
+void Rft_DefaultProfile(rft_profile_t *profile);
+
+/**
+ * @brief Confere magic e checksum de um perfil lido do SD.
+ */
+bool Rft_IsValidProfile(const rft_profile_t *profile);
+
+/**
+ * @brief Escreve o perfil nos registradores e passa a usá-lo no monitor.
+ */
+void Rft_Apply(MFRC522Ptr_t mfrc, const rft_profile_t *profile);
+
+/**
+ * @brief Varre o ganho do receptor com um cartão de referência no leitor e
+ * aplica o melhor degrau (maior taxa de sucesso, depois menor latência).
+ * TxASK fica em Force100ASK, a modulação do ISO 14443A. Classic: autenticação com a chave de fábrica e leitura do bloco
+ * 4; Ultralight/NTAG: leitura da página 4.
+ * @param best Recebe o perfil escolhido, pronto para gravar no SD.
+ * @return false se não houver cartão ou nenhuma combinação funcionar.
+ */
+bool Rft_Calibrate(MFRC522Ptr_t mfrc, uint8_t trials, rft_profile_t *best);
+
+/**
+ * @brief Registra um toque no monitor do leitor mfrc (cada leitor tem a sua
+ * janela e o seu ganho). Só entram as etapas que dependem do enlace: o
+ * resultado da anticolisão/SELECT ou STATUS_CRC_WRONG se algum quadro chegou
+ * com CRC_A errado (mfrc->crc_errors). Falhas de autenticação, tipo de
+ * cartão e checksum do registro não devem ser passadas aqui.
+ * STATUS_OK conta como sucesso; timeout, colisão, erro de protocolo e CRC_A
+ * como falha; os demais códigos são ignorados.
+ * @return true se o ganho foi alterado nesta chamada.
+ */
+bool Rft_RecordTap(MFRC522Ptr_t mfrc, StatusCode status);
+
+#endif // RFID_TUNING_H
@@ -1,6 +1,10 @@
 #include "tag_data_handler.h"
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
+
+// Chave de fábrica dos cartões MIFARE Classic, usada quando key == NULL
+static MIFARE_Key default_key = {{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
 
 // Função interna para calcular o checksum. Inalterada.
 static uint8_t calculate_checksum(const uint8_t *data) {
@@ -11,6 +15,12 @@ static uint8_t calculate_checksum(const uint8_t *data) {
     return checksum;
 }
 
+// Registro v3 íntegro: checksum e versão (com ou sem o contador em bloco de valor)
+static bool v3_valid(const StudentDataBlock *data_block) {
+    return data_block->fields.checksum == calculate_checksum(data_block->buffer) &&
+           (data_block->fields.data_version & 0x7F) == 3;
+}
+
 // Função atualizada para preparar uma NOVA tag, zerando o contador.
 void Tdh_PrepareNewStudentTag(StudentDataBlock *data_block, uint32_t id, const char* name) {
     memset(data_block->buffer, 0, sizeof(data_block->buffer));
@@ -24,93 +34,627 @@ void Tdh_PrepareNewStudentTag(StudentDataBlock *data_block, uint32_t id, const c
     data_block->fields.checksum = calculate_checksum(data_block->buffer);
 }
 
-// Função de escrita. Essencialmente a mesma de antes.
+// --- Registro v4 ---
+
+_Static_assert(sizeof(TdhV4Identity) == 32, "TdhV4Identity deve ocupar 2 blocos");
+
+static uint16_t crc_a(const uint8_t *data, uint8_t length) {
+    uint8_t result[2];
+    PCD_CalculateCRCSoft(data, length, result);
+    return (uint16_t)(result[0] | result[1] << 8);
+}
+
+static bool v4_identity_ok(const TdhV4Identity *ident) {
+    return ident->fields.format == TDH_V4_FORMAT &&
+           ident->fields.crc == crc_a(ident->buffer, offsetof(TdhV4Identity, fields.crc));
+}
+
+void Tdh_PrepareV4Identity(TdhV4Identity *ident, uint32_t id, const char *name, uint32_t route_bitmap) {
+    memset(ident->buffer, 0, sizeof(ident->buffer));
+    ident->fields.format = TDH_V4_FORMAT;
+    ident->fields.student_id = id;
+    ident->fields.route_bitmap = route_bitmap;
+    strncpy(ident->fields.student_name, name, sizeof(ident->fields.student_name) - 1);
+    ident->fields.crc = crc_a(ident->buffer, offsetof(TdhV4Identity, fields.crc));
+}
+
+// --- Sessão por setor ---
+
+StatusCode Tdh_SessionOpen(TdhSession *session, MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key) {
+    // 1K/2K: setores de 4 blocos; 4K: acima do bloco 128, setores de 16
+    uint8_t span = blockAddr < 128 ? 4 : 16;
+    session->mfrc = mfrc;
+    session->first_block = blockAddr & ~(span - 1);
+    session->trailer = session->first_block + span - 1;
+    session->open = false;
+
+    StatusCode status = PCD_Authenticate(mfrc, PICC_CMD_MF_AUTH_KEY_A, session->trailer,
+                                         key ? key : &default_key, &(mfrc->uid));
+    if (status != STATUS_OK) {
+        PCD_StopCrypto1(mfrc);
+        return status;
+    }
+    session->open = true;
+    return STATUS_OK;
+}
+
+// Bloco de dados (não trailer) dentro do setor autenticado?
+static bool session_owns(const TdhSession *session, uint8_t blockAddr) {
+    return session->open && blockAddr >= session->first_block && blockAddr < session->trailer;
+}
+
+StatusCode Tdh_SessionRead(TdhSession *session, uint8_t blockAddr, uint8_t *data) {
+    if (!session_owns(session, blockAddr)) {
+        return STATUS_INVALID;
+    }
+    uint8_t read_buffer[18];
+    uint8_t read_size = sizeof(read_buffer);
+    StatusCode status = MIFARE_Read(session->mfrc, blockAddr, read_buffer, &read_size);
+    if (status == STATUS_OK) {
+        memcpy(data, read_buffer, 16);
+    }
+    return status;
+}
+
+StatusCode Tdh_SessionWrite(TdhSession *session, uint8_t blockAddr, const uint8_t *data) {
+    if (!session_owns(session, blockAddr)) {
+        return STATUS_INVALID;
+    }
+    uint8_t write_buffer[16];
+    memcpy(write_buffer, data, sizeof(write_buffer));
+    return MIFARE_Write(session->mfrc, blockAddr, write_buffer, sizeof(write_buffer));
+}
+
+void Tdh_SessionClose(TdhSession *session) {
+    if (session->open) {
+        PCD_StopCrypto1(session->mfrc);
+        session->open = false;
+    }
+}
+
+// Confere o registro já lido do bloco principal; se inválido, usa a cópia
+static StatusCode session_check_record(TdhSession *session, uint8_t blockAddr, StudentDataBlock *data_block) {
+    if (v3_valid(data_block)) {
+        return STATUS_OK;
+    }
+#if TDH_BACKUP_COPY
+    StudentDataBlock backup;
+    if (Tdh_SessionRead(session, blockAddr + 1, backup.buffer) == STATUS_OK && v3_valid(&backup)) {
+        printf("Registro do bloco %u corrompido, usando a copia.\n", blockAddr);
+        *data_block = backup;
+        return STATUS_OK;
+    }
+#endif
+    return STATUS_CRC_WRONG;
+}
+
+// Lê o registro do bloco principal ou, se não conferir, da cópia
+static StatusCode session_read_record(TdhSession *session, uint8_t blockAddr, StudentDataBlock *data_block) {
+    StatusCode status = Tdh_SessionRead(session, blockAddr, data_block->buffer);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    return session_check_record(session, blockAddr, data_block);
+}
+
+// Grava o registro e a cópia. A cópia só existe se o bloco seguinte for de
+// dados do mesmo setor; falha nela não invalida o registro principal.
+static StatusCode session_write_record(TdhSession *session, uint8_t blockAddr, const StudentDataBlock *data_block) {
+    StatusCode status = Tdh_SessionWrite(session, blockAddr, data_block->buffer);
+    if (status != STATUS_OK) {
+        return status;
+    }
+#if TDH_BACKUP_COPY
+    if (session_owns(session, blockAddr + 1) &&
+        Tdh_SessionWrite(session, blockAddr + 1, data_block->buffer) != STATUS_OK) {
+        printf("Aviso: copia do bloco %u nao foi gravada.\n", blockAddr);
+    }
+#endif
+    return STATUS_OK;
+}
+
+// --- Contador em bloco de valor ---
+
+static bool uses_value_counter(const StudentDataBlock *data_block) {
+    return (data_block->fields.data_version & TDH_VALUE_COUNTER_FLAG) != 0;
+}
+
+// Lê o bloco de valor e confere o formato (valor, ~valor, valor, endereço)
+static StatusCode session_read_value(TdhSession *session, uint8_t valueBlock, int32_t *value) {
+    uint8_t b[16];
+    StatusCode status = Tdh_SessionRead(session, valueBlock, b);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (b[i] != b[i + 8] || (uint8_t)(b[i] ^ b[i + 4]) != 0xFF) {
+            return STATUS_CRC_WRONG;
+        }
+    }
+    if (b[12] != valueBlock || b[14] != valueBlock ||
+        (uint8_t)(b[13] ^ valueBlock) != 0xFF || (uint8_t)(b[15] ^ valueBlock) != 0xFF) {
+        return STATUS_CRC_WRONG;
+    }
+    *value = (int32_t)((uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24);
+    return STATUS_OK;
+}
+
+// Converte o registro já lido (v3) na sessão aberta. O bloco de valor é
+// gravado antes do registro: se o cartão sair no meio, a tag continua v3
+// válida e a migração é refeita no próximo embarque.
+static StatusCode session_migrate(TdhSession *session, uint8_t blockAddr, StudentDataBlock *data_block, int32_t count) {
+    uint8_t valueBlock = blockAddr + TDH_VALUE_BLOCK_OFFSET;
+    if (!session_owns(session, valueBlock)) {
+        return STATUS_INVALID;
+    }
+    StatusCode status = MIFARE_SetValue(session->mfrc, valueBlock, count);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    data_block->fields.data_version |= TDH_VALUE_COUNTER_FLAG;
+    data_block->fields.checksum = calculate_checksum(data_block->buffer);
+    return session_write_record(session, blockAddr, data_block);
+}
+
+// INCREMENT + TRANSFER do bloco de valor já lido em *count: o cartão
+// atualiza o bloco numa única operação, sem a janela de uma regravação de
+// 16 bytes
+static StatusCode session_increment_value(TdhSession *session, uint8_t valueBlock, int32_t *count) {
+    StatusCode status = MIFARE_Increment(session->mfrc, valueBlock, 1);
+    if (status == STATUS_OK) {
+        status = MIFARE_Transfer(session->mfrc, valueBlock);
+    }
+    if (status == STATUS_OK) {
+        (*count)++;
+    }
+    return status;
+}
+
+// Escrita do registro (provisionamento): uma sessão para o registro e a cópia.
 StatusCode Tdh_WriteStudentData(MFRC522Ptr_t mfrc, StudentDataBlock *data_block, uint8_t blockAddr, MIFARE_Key *key) {
-    StatusCode status = PCD_Authenticate(mfrc, PICC_CMD_MF_AUTH_KEY_A, blockAddr, key, &(mfrc->uid));
+    TdhSession session;
+    StatusCode status = Tdh_SessionOpen(&session, mfrc, blockAddr, key);
     if (status != STATUS_OK) {
         printf("Erro de autenticacao na escrita: %s\n", GetStatusCodeName(status));
         return status;
     }
 
-    status = MIFARE_Write(mfrc, blockAddr, data_block->buffer, 16);
+    status = session_write_record(&session, blockAddr, data_block);
     if (status != STATUS_OK) {
         printf("Erro ao gravar na tag: %s\n", GetStatusCodeName(status));
     }
     
-    PCD_StopCrypto1(mfrc);
+    Tdh_SessionClose(&session);
     return status;
 }
 
-// Função de leitura. Essencialmente a mesma de antes.
+// Leitura do registro, com recurso à cópia na mesma sessão.
 StatusCode Tdh_ReadStudentData(MFRC522Ptr_t mfrc, StudentDataBlock *data_block, uint8_t blockAddr, MIFARE_Key *key) {
-    uint8_t read_buffer[18];
-    uint8_t read_size = sizeof(read_buffer);
-
-    StatusCode status = PCD_Authenticate(mfrc, PICC_CMD_MF_AUTH_KEY_A, blockAddr, key, &(mfrc->uid));
+    TdhSession session;
+    StatusCode status = Tdh_SessionOpen(&session, mfrc, blockAddr, key);
     if (status != STATUS_OK) {
         // Não imprime erro para não poluir a tela em loops de leitura
         return status;
     }
     
-    status = MIFARE_Read(mfrc, blockAddr, read_buffer, &read_size);
-    if (status != STATUS_OK) {
-        PCD_StopCrypto1(mfrc);
+    status = session_read_record(&session, blockAddr, data_block);
+    if (status == STATUS_OK && uses_value_counter(data_block)) {
+        // trip_count do registro está congelado; o contador é o bloco de valor
+        int32_t count;
+        status = session_read_value(&session, blockAddr + TDH_VALUE_BLOCK_OFFSET, &count);
+        if (status == STATUS_OK) {
+            data_block->fields.trip_count = count > 255 ? 255 : (uint8_t)count;
+        }
+    }
+    Tdh_SessionClose(&session);
+    return status;
+}
+
+// Incremento de um registro v3 já lido e conferido, na sessão aberta
+static StatusCode session_trip_v3(TdhSession *session, uint8_t blockAddr, StudentDataBlock *data_read) {
+    StatusCode status;
+
+    // Contador em bloco de valor: uma operação atômica no lugar da regravação
+    if (uses_value_counter(data_read)) {
+        uint8_t valueBlock = blockAddr + TDH_VALUE_BLOCK_OFFSET;
+        int32_t count;
+        status = session_read_value(session, valueBlock, &count);
+        if (status == STATUS_OK) {
+            status = session_increment_value(session, valueBlock, &count);
+        }
+        if (status == STATUS_OK) {
+            data_read->fields.trip_count = count > 255 ? 255 : (uint8_t)count;
+        } else {
+            printf("Incremento falhou: Bloco de valor (%s).\n", GetStatusCodeName(status));
+        }
         return status;
     }
-    
-    memcpy(data_block->buffer, read_buffer, 16);
-    uint8_t expected_checksum = data_block->fields.checksum;
-    uint8_t actual_checksum = calculate_checksum(data_block->buffer);
-    PCD_StopCrypto1(mfrc);
 
-    if (expected_checksum != actual_checksum) {
-        return STATUS_CRC_WRONG;
+#if TDH_VALUE_COUNTER_MIGRATE
+    // Tag v3: migra já com a viagem atual contada
+    status = session_migrate(session, blockAddr, data_read, data_read->fields.trip_count + 1);
+    if (status == STATUS_OK) {
+        data_read->fields.trip_count++;
+        return STATUS_OK;
     }
+    printf("Migracao para bloco de valor falhou (%s), mantendo v3.\n", GetStatusCodeName(status));
+#endif
 
-    return STATUS_OK;
+    // Incrementa o contador, recalcula o checksum e regrava na mesma sessão
+    data_read->fields.trip_count++;
+    data_read->fields.checksum = calculate_checksum(data_read->buffer);
+    status = session_write_record(session, blockAddr, data_read);
+    if (status != STATUS_OK) {
+        printf("Incremento falhou: Erro ao reescrever na tag.\n");
+    }
+    return status;
 }
 
-// Nova função que encapsula a lógica de negócio do embarque.
+// Lógica de negócio do embarque: ler, verificar, incrementar e gravar sem
+// autenticar de novo entre os passos.
 StatusCode Tdh_ProcessTrip(MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key, StudentDataBlock *data_read) {
     // Passo 1: Inicia uma ÚNICA sessão de autenticação
-    StatusCode status = PCD_Authenticate(mfrc, PICC_CMD_MF_AUTH_KEY_A, blockAddr, key, &(mfrc->uid));
+    TdhSession session;
+    StatusCode status = Tdh_SessionOpen(&session, mfrc, blockAddr, key);
     if (status != STATUS_OK) {
         printf("Incremento falhou: Autenticacao inicial falhou.\n");
         return status;
     }
 
-    // A sessão está ativa. Agora vamos ler, modificar e escrever.
-    
-    // Passo 2: Lê os dados da tag
-    uint8_t read_buffer[18];
-    uint8_t read_size = sizeof(read_buffer);
-    status = MIFARE_Read(mfrc, blockAddr, read_buffer, &read_size);
+    // Passo 2: Lê os dados da tag e verifica o checksum
+    status = session_read_record(&session, blockAddr, data_read);
     if (status != STATUS_OK) {
-        printf("Incremento falhou: Nao foi possivel ler a tag apos autenticar.\n");
-        PCD_StopCrypto1(mfrc); // Importante parar a criptografia em caso de falha
+        printf("Incremento falhou: Nao foi possivel ler a tag (%s).\n", GetStatusCodeName(status));
+        Tdh_SessionClose(&session); // Importante parar a criptografia em caso de falha
         return status;
     }
+
+    // Passos 3 e 4 (incremento e gravação)
+    status = session_trip_v3(&session, blockAddr, data_read);
+
+    // Passo 5: Finaliza a sessão criptografada
+    Tdh_SessionClose(&session);
     
-    // Copia os dados lidos para a estrutura do usuário e verifica o checksum
-    memcpy(data_read->buffer, read_buffer, 16);
-    if (data_read->fields.checksum != calculate_checksum(data_read->buffer)) {
-         printf("Incremento falhou: Checksum invalido na leitura.\n");
-         PCD_StopCrypto1(mfrc);
-         return STATUS_CRC_WRONG;
+    return status;
+}
+
+// --- Ultralight / NTAG ---
+
+static StatusCode ul_auth(MFRC522Ptr_t mfrc, const uint8_t *pwd) {
+    if (!pwd) {
+        return STATUS_OK;
+    }
+    uint8_t password[4];
+    uint8_t pack[2];
+    memcpy(password, pwd, sizeof(password));
+    return PCD_NTAG216_AUTH(mfrc, password, pack);
+}
+
+// Cópias que ficaram para trás na leitura (ul_read_record)
+#define UL_STALE_RECORD 0x01  // Registro corrompido, valeu a cópia
+#define UL_STALE_BACKUP 0x02  // Cópia lida e diferente do registro
+
+// Registro e cópia: um FAST_READ das páginas 4..11 ou READ (4 páginas) do
+// registro e, se o checksum falhar, da cópia. Em *stale (pode ser NULL), as
+// cópias que o próximo embarque precisa regravar inteiras; sem FAST_READ, a
+// cópia só é conferida quando o registro falha
+static StatusCode ul_read_record(MFRC522Ptr_t mfrc, const uint8_t *pwd, StudentDataBlock *data_block,
+                                 uint8_t *stale) {
+    uint8_t pages[2 * 16 + 2];
+    uint8_t size = sizeof(pages);
+    uint8_t ignored;
+    StatusCode status;
+
+    if (!stale) {
+        stale = &ignored;
+    }
+    *stale = 0;
+
+#if TDH_NTAG_FAST_READ && TDH_BACKUP_COPY
+    status = MIFARE_Ultralight_FastRead(mfrc, TDH_UL_RECORD_PAGE, TDH_UL_BACKUP_PAGE + 3, pages, &size);
+    if (status != STATUS_OK) {
+        // Ultralight/Ultralight C: o NAK leva a tag para IDLE, seleciona de novo
+        status = PICC_WakeupAndSelect(mfrc, &mfrc->uid);
+        if (status == STATUS_OK) {
+            status = ul_auth(mfrc, pwd);
+        }
+        if (status != STATUS_OK) {
+            return status;
+        }
+        size = 0;
+    }
+#else
+    size = 0;
+#endif
+    if (size == 0) {
+        size = sizeof(pages);
+        status = MIFARE_Read(mfrc, TDH_UL_RECORD_PAGE, pages, &size);
+        if (status != STATUS_OK) {
+            return status;
+        }
+        size = 0;  // Cópia ainda não lida
+    }
+
+    memcpy(data_block->buffer, pages, 16);
+    if (v3_valid(data_block)) {
+#if TDH_BACKUP_COPY
+        if (size != 0 && memcmp(pages + 16, pages, 16) != 0) {
+            *stale = UL_STALE_BACKUP;
+        }
+#endif
+        return STATUS_OK;
+    }
+#if TDH_BACKUP_COPY
+    if (size == 0) {
+        size = sizeof(pages) - 16;
+        if (MIFARE_Read(mfrc, TDH_UL_BACKUP_PAGE, pages + 16, &size) != STATUS_OK) {
+            return STATUS_CRC_WRONG;
+        }
+    }
+    StudentDataBlock backup;
+    memcpy(backup.buffer, pages + 16, 16);
+    if (v3_valid(&backup)) {
+        printf("Registro da pagina %u corrompido, usando a copia.\n", TDH_UL_RECORD_PAGE);
+        *data_block = backup;
+        *stale = UL_STALE_RECORD;
+        return STATUS_OK;
+    }
+#endif
+    return STATUS_CRC_WRONG;
+}
+
+// Grava as páginas [first, first + count) de um registro a partir de 'page'
+static StatusCode ul_write_pages(MFRC522Ptr_t mfrc, uint8_t page, const StudentDataBlock *data_block,
+                                 uint8_t first, uint8_t count) {
+    for (uint8_t i = first; i < first + count; i++) {
+        uint8_t buffer[4];
+        memcpy(buffer, &data_block->buffer[4 * i], sizeof(buffer));
+        StatusCode status = MIFARE_Ultralight_Write(mfrc, page + i, buffer, sizeof(buffer));
+        if (status != STATUS_OK) {
+            return status;
+        }
+    }
+    return STATUS_OK;
+}
+
+// Registro e depois a cópia; falha na cópia não invalida o registro
+static StatusCode ul_write_record(MFRC522Ptr_t mfrc, const StudentDataBlock *data_block, uint8_t first, uint8_t count) {
+    StatusCode status = ul_write_pages(mfrc, TDH_UL_RECORD_PAGE, data_block, first, count);
+    if (status != STATUS_OK) {
+        return status;
+    }
+#if TDH_BACKUP_COPY
+    if (ul_write_pages(mfrc, TDH_UL_BACKUP_PAGE, data_block, first, count) != STATUS_OK) {
+        printf("Aviso: copia da pagina %u nao foi gravada.\n", TDH_UL_RECORD_PAGE);
+    }
+#endif
+    return STATUS_OK;
+}
+
+StatusCode Tdh_UlReadStudentData(MFRC522Ptr_t mfrc, StudentDataBlock *data_block, const uint8_t *pwd) {
+    StatusCode status = ul_auth(mfrc, pwd);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    return ul_read_record(mfrc, pwd, data_block, NULL);
+}
+
+StatusCode Tdh_UlWriteStudentData(MFRC522Ptr_t mfrc, StudentDataBlock *data_block, const uint8_t *pwd) {
+    StatusCode status = ul_auth(mfrc, pwd);
+    if (status != STATUS_OK) {
+        printf("Erro de autenticacao na escrita: %s\n", GetStatusCodeName(status));
+        return status;
+    }
+    status = ul_write_record(mfrc, data_block, 0, 4);
+    if (status != STATUS_OK) {
+        printf("Erro ao gravar na tag: %s\n", GetStatusCodeName(status));
+    }
+    return status;
+}
+
+StatusCode Tdh_UlProcessTrip(MFRC522Ptr_t mfrc, const uint8_t *pwd, StudentDataBlock *data_read) {
+    StatusCode status = ul_auth(mfrc, pwd);
+    if (status != STATUS_OK) {
+        printf("Incremento falhou: Senha NTAG recusada.\n");
+        return status;
+    }
+    uint8_t stale;
+    status = ul_read_record(mfrc, pwd, data_read, &stale);
+    if (status != STATUS_OK) {
+        printf("Incremento falhou: Nao foi possivel ler a tag (%s).\n", GetStatusCodeName(status));
+        return status;
     }
 
-    // Passo 3: Incrementa o contador e recalcula o checksum
     data_read->fields.trip_count++;
     data_read->fields.checksum = calculate_checksum(data_read->buffer);
-    
-    // Passo 4: Escreve os dados atualizados de volta na tag (ainda na mesma sessão)
-    status = MIFARE_Write(mfrc, blockAddr, data_read->buffer, 16);
+
+    // Só a página 3 (nome[8], trip_count, data_version, checksum) de cada
+    // cópia; a que ficou para trás é regravada inteira, senão continuaria
+    // corrompida e o embarque contaria sempre a partir da outra
+    uint8_t first = (stale & UL_STALE_RECORD) ? 0 : 3;
+    status = ul_write_pages(mfrc, TDH_UL_RECORD_PAGE, data_read, first, 4 - first);
     if (status != STATUS_OK) {
         printf("Incremento falhou: Erro ao reescrever na tag.\n");
+        return status;
+    }
+#if TDH_BACKUP_COPY
+    first = (stale & UL_STALE_BACKUP) ? 0 : 3;
+    if (ul_write_pages(mfrc, TDH_UL_BACKUP_PAGE, data_read, first, 4 - first) != STATUS_OK) {
+        printf("Aviso: copia da pagina %u nao foi gravada.\n", TDH_UL_RECORD_PAGE);
     }
+#endif
+    return STATUS_OK;
+}
 
-    // Passo 5: Finaliza a sessão criptografada
-    PCD_StopCrypto1(mfrc);
-    
+// --- Provisionamento com verificação ---
+
+// Classic: identidade v4 e contador zerado gravados e lidos de volta numa
+// única sessão
+static StatusCode classic_provision(MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key,
+                                    const TdhV4Identity *ident) {
+    TdhSession session;
+    uint8_t counterBlock = blockAddr + TDH_V4_COUNTER_OFFSET;
+
+    StatusCode status = Tdh_SessionOpen(&session, mfrc, blockAddr, key);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    if (!session_owns(&session, counterBlock)) {
+        status = STATUS_INVALID;  // O registro v4 não cabe no setor a partir daqui
+    }
+    for (uint8_t i = 0; status == STATUS_OK && i < 2; i++) {
+        status = Tdh_SessionWrite(&session, blockAddr + i, ident->buffer + 16 * i);
+    }
+    if (status == STATUS_OK) {
+        status = MIFARE_SetValue(mfrc, counterBlock, 0);
+    }
+    for (uint8_t i = 0; status == STATUS_OK && i < 2; i++) {
+        uint8_t check[16];
+        status = Tdh_SessionRead(&session, blockAddr + i, check);
+        if (status == STATUS_OK && memcmp(check, ident->buffer + 16 * i, sizeof(check)) != 0) {
+            status = STATUS_CRC_WRONG;
+        }
+    }
+    int32_t count;
+    if (status == STATUS_OK) {
+        status = session_read_value(&session, counterBlock, &count);
+    }
+    if (status == STATUS_OK && count != 0) {
+        status = STATUS_CRC_WRONG;
+    }
+    Tdh_SessionClose(&session);
     return status;
-}
\ No newline at end of file
+}
+
+// Ultralight/NTAG: um READ devolve as 4 páginas do registro (ou da cópia)
+static StatusCode ul_provision(MFRC522Ptr_t mfrc, const uint8_t *pwd, const StudentDataBlock *data_block) {
+    StatusCode status = ul_auth(mfrc, pwd);
+    if (status == STATUS_OK) {
+        status = ul_write_record(mfrc, data_block, 0, 4);
+    }
+    static const uint8_t pages[] = {TDH_UL_RECORD_PAGE, TDH_UL_BACKUP_PAGE};
+    for (uint8_t i = 0; status == STATUS_OK && i < 1 + TDH_BACKUP_COPY; i++) {
+        uint8_t check[18];
+        uint8_t size = sizeof(check);
+        status = MIFARE_Read(mfrc, pages[i], check, &size);
+        if (status == STATUS_OK && memcmp(check, data_block->buffer, 16) != 0) {
+            status = STATUS_CRC_WRONG;
+        }
+    }
+    return status;
+}
+
+StatusCode Tdh_ProvisionAnyCard(MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key,
+                                const uint8_t *pwd, const TdhV4Identity *ident) {
+    StudentDataBlock data_block;
+    switch (PICC_GetType(mfrc->uid.sak)) {
+        case PICC_TYPE_MIFARE_UL:
+            Tdh_PrepareNewStudentTag(&data_block, ident->fields.student_id, ident->fields.student_name);
+            return ul_provision(mfrc, pwd, &data_block);
+        case PICC_TYPE_MIFARE_MINI:
+        case PICC_TYPE_MIFARE_1K:
+        case PICC_TYPE_MIFARE_4K:
+            return classic_provision(mfrc, blockAddr, key, ident);
+        default:
+            return STATUS_ERROR;
+    }
+}
+
+// --- Embarque em qualquer versão de registro ---
+
+static void record_from_v3(const StudentDataBlock *data_block, TdhStudentRecord *rec) {
+    rec->version = data_block->fields.data_version & 0x7F;
+    rec->student_id = data_block->fields.student_id;
+    memcpy(rec->student_name, data_block->fields.student_name, sizeof(data_block->fields.student_name));
+    rec->student_name[sizeof(data_block->fields.student_name) - 1] = '\0';
+    rec->trip_count = data_block->fields.trip_count;
+}
+
+// Contador do v4 na sessão aberta: confere o bloco de valor, testa a rota e
+// incrementa. Bloco ilegível é recusado, nunca zerado
+static StatusCode session_board_v4(TdhSession *session, uint8_t blockAddr, const TdhV4Identity *ident,
+                                   uint8_t route, TdhStudentRecord *rec) {
+    uint8_t counterBlock = blockAddr + TDH_V4_COUNTER_OFFSET;
+    int32_t count;
+    StatusCode status = session_read_value(session, counterBlock, &count);
+    if (status != STATUS_OK) {
+        printf("Contador v4 do bloco %u ilegivel (%s).\n", counterBlock, GetStatusCodeName(status));
+        return status;
+    }
+    rec->version = 4;
+    rec->student_id = ident->fields.student_id;
+    memcpy(rec->student_name, ident->fields.student_name, sizeof(rec->student_name));
+    rec->student_name[sizeof(rec->student_name) - 1] = '\0';
+    rec->route_bitmap = ident->fields.route_bitmap;
+    rec->trip_count = (uint32_t)count;
+
+    uint32_t routes = ident->fields.route_bitmap;
+    if (routes && (route < 1 || route > 32 || !((routes >> (route - 1)) & 1))) {
+        rec->route_denied = true;
+        return STATUS_OK;
+    }
+    status = session_increment_value(session, counterBlock, &count);
+    if (status == STATUS_OK) {
+        rec->trip_count = (uint32_t)count;
+    }
+    return status;
+}
+
+// Classic: a versão sai do primeiro bloco lido, sem leitura extra para o v3
+static StatusCode classic_board(MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key,
+                                uint8_t route, TdhStudentRecord *rec) {
+    TdhSession session;
+    TdhV4Identity ident;
+    StudentDataBlock data_block;
+    StatusCode status = Tdh_SessionOpen(&session, mfrc, blockAddr, key);
+    if (status != STATUS_OK) {
+        printf("Embarque falhou: Autenticacao inicial falhou.\n");
+        return status;
+    }
+    status = Tdh_SessionRead(&session, blockAddr, ident.buffer);
+    memcpy(data_block.buffer, ident.buffer, sizeof(data_block.buffer));
+
+    // O byte do formato também pode ser o ID de um v3: vale o que conferir
+    if (status == STATUS_OK && ident.fields.format == TDH_V4_FORMAT && !v3_valid(&data_block)) {
+        status = Tdh_SessionRead(&session, blockAddr + 1, ident.buffer + 16);
+        if (status == STATUS_OK) {
+            status = v4_identity_ok(&ident)
+                         ? session_board_v4(&session, blockAddr, &ident, route, rec)
+                         : STATUS_CRC_WRONG;
+        }
+    } else if (status == STATUS_OK) {
+        status = session_check_record(&session, blockAddr, &data_block);
+        if (status == STATUS_OK) {
+            status = session_trip_v3(&session, blockAddr, &data_block);
+        }
+        if (status == STATUS_OK) {
+            record_from_v3(&data_block, rec);
+        }
+    }
+    if (status != STATUS_OK) {
+        printf("Embarque falhou: %s\n", GetStatusCodeName(status));
+    }
+    Tdh_SessionClose(&session);
+    return status;
+}
+
+StatusCode Tdh_BoardAnyCard(MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key, const uint8_t *pwd,
+                            uint8_t route, TdhStudentRecord *rec) {
+    StudentDataBlock data_block;
+    StatusCode status;
+    memset(rec, 0, sizeof(*rec));
+    switch (PICC_GetType(mfrc->uid.sak)) {
+        case PICC_TYPE_MIFARE_UL:
+            status = Tdh_UlProcessTrip(mfrc, pwd, &data_block);
+            if (status == STATUS_OK) {
+                record_from_v3(&data_block, rec);
+            }
+            return status;
+        case PICC_TYPE_MIFARE_MINI:
+        case PICC_TYPE_MIFARE_1K:
+        case PICC_TYPE_MIFARE_4K:
+            return classic_board(mfrc, blockAddr, key, route, rec);
+        default:
+            return STATUS_ERROR;
+    }
+}
@@ -16,6 +16,112 @@ typedef union {
     uint8_t buffer[16];
 } StudentDataBlock;
 
+// --- Registro v4 (MIFARE Classic) ---
+// Três blocos de dados do setor:
+//   blocos 4 e 5  TdhV4Identity: gravada só no provisionamento, protegida por
+//                 CRC_A (o CRC-16 do ISO 14443, PCD_CalculateCRCSoft()) em
+//                 vez do XOR do v3
+//   bloco 6       trip_count num bloco de valor MIFARE, atualizado com
+//                 INCREMENT + TRANSFER como no v3 com TDH_VALUE_COUNTER_FLAG
+// O embarque não regrava bloco nenhum: cartão retirado no meio fica com a
+// contagem antiga ou a nova. Não sobra bloco no setor para hora e rota do
+// último embarque; elas ficam só no diário do SD.
+// Ultralight/NTAG continuam no v3.
+#define TDH_V4_FORMAT 0xC4
+#define TDH_V4_NAME_SIZE 18        // 17 caracteres + '\0'
+#define TDH_V4_COUNTER_OFFSET 2    // Bloco de valor do contador, a partir da identidade
+
+typedef union {
+    struct {
+        uint8_t  format;                         // TDH_V4_FORMAT
+        uint8_t  reserved[3];
+        uint32_t student_id;
+        uint32_t route_bitmap;                   // Bit r-1: rota r permitida; 0 = todas
+        char     student_name[TDH_V4_NAME_SIZE];
+        uint16_t crc;                            // CRC_A dos 30 bytes anteriores
+    } fields;
+    uint8_t buffer[32];
+} TdhV4Identity;
+
+/**
+ * @brief Registro decodificado de qualquer versão (v3 ou v4).
+ */
+typedef struct {
+    uint8_t  version;                        // 3 ou 4
+    bool     route_denied;                   // Rota fora de route_bitmap: viagem não contada
+    uint32_t student_id;
+    char     student_name[TDH_V4_NAME_SIZE];
+    uint32_t trip_count;
+    uint32_t route_bitmap;                   // 0 no v3
+} TdhStudentRecord;
+
+// Cópia de segurança do registro no bloco seguinte do mesmo setor (ex.: 4 -> 5).
+// Lida quando o checksum do bloco principal não confere.
+#ifndef TDH_BACKUP_COPY
+#define TDH_BACKUP_COPY 1
+#endif
+
+// Layout com contador em bloco de valor: o registro continua no bloco
+// principal, mas trip_count fica congelado e o contador real vai para um bloco
+// de valor MIFARE dois blocos adiante (ex.: 4 -> 6), atualizado com
+// INCREMENT + TRANSFER em vez de regravar o registro inteiro.
+// Marcado no registro pelo bit abaixo em data_version (v3 -> 0x83).
+#define TDH_VALUE_COUNTER_FLAG   0x80
+#define TDH_VALUE_BLOCK_OFFSET   2
+
+// 1: tags v3 (Classic) são migradas para o contador em bloco de valor no
+// próprio embarque, já com a viagem contada. Se a migração falhar, o
+// embarque segue regravando o registro v3.
+#ifndef TDH_VALUE_COUNTER_MIGRATE
+#define TDH_VALUE_COUNTER_MIGRATE 1
+#endif
+
+// Ultralight/NTAG (páginas de 4 bytes, sem Crypto1): o mesmo StudentDataBlock
+// ocupa as páginas 4..7 e a cópia as páginas 8..11. trip_count, data_version
+// e checksum caem todos na última página, então um embarque grava 1 página.
+#define TDH_UL_RECORD_PAGE 4
+#define TDH_UL_BACKUP_PAGE 8
+
+// 1: lê registro e cópia num único FAST_READ (NTAG21x, Ultralight EV1). Se a
+// tag recusar, volta para READ comum.
+#ifndef TDH_NTAG_FAST_READ
+#define TDH_NTAG_FAST_READ 1
+#endif
+
+/**
+ * @brief Sessão autenticada num setor MIFARE Classic.
+ *
+ * Uma única autenticação Crypto1 cobre todos os blocos do setor: leituras e
+ * escritas seguidas (registro, cópia, metadados) não repetem o handshake.
+ */
+typedef struct {
+    MFRC522Ptr_t mfrc;
+    uint8_t first_block;  // Primeiro bloco do setor
+    uint8_t trailer;      // Bloco do trailer (chaves e bits de acesso)
+    bool open;
+} TdhSession;
+
+/**
+ * @brief Autentica (chave A) o setor que contém blockAddr no cartão selecionado.
+ * @param key Chave A; NULL usa a chave de fábrica FF FF FF FF FF FF.
+ */
+StatusCode Tdh_SessionOpen(TdhSession *session, MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key);
+
+/**
+ * @brief Lê 16 bytes de um bloco de dados do setor da sessão.
+ */
+StatusCode Tdh_SessionRead(TdhSession *session, uint8_t blockAddr, uint8_t *data);
+
+/**
+ * @brief Grava 16 bytes num bloco de dados do setor. O trailer é recusado.
+ */
+StatusCode Tdh_SessionWrite(TdhSession *session, uint8_t blockAddr, const uint8_t *data);
+
+/**
+ * @brief Encerra a sessão (PCD_StopCrypto1). Pode ser chamada mais de uma vez.
+ */
+void Tdh_SessionClose(TdhSession *session);
+
 /**
  * @brief Prepara os dados de um novo aluno, INICIANDO o contador de viagens em 0.
  * @param data_block Ponteiro para o bloco de dados a ser preenchido.
@@ -25,7 +131,7 @@ typedef union {
 void Tdh_PrepareNewStudentTag(StudentDataBlock *data_block, uint32_t id, const char* name);
 
 /**
- * @brief Escreve um bloco de dados na tag. Função genérica de escrita.
+ * @brief Escreve um bloco de dados na tag (e a cópia, se TDH_BACKUP_COPY).
  */
 StatusCode Tdh_WriteStudentData(MFRC522Ptr_t mfrc, StudentDataBlock *data_block, uint8_t blockAddr, MIFARE_Key *key);
 
@@ -36,8 +142,58 @@ StatusCode Tdh_ReadStudentData(MFRC522Ptr_t mfrc, StudentDataBlock *data_block,
 
 /**
  * @brief Função principal da operação: lê a tag, incrementa o contador e reescreve.
+ * Leitura, verificação, incremento e gravação numa única sessão autenticada.
+ * Em tags com contador em bloco de valor, trip_count volta com o valor do
+ * contador (saturado em 255).
  * @return StatusCode indicando o resultado da operação completa.
  */
 StatusCode Tdh_ProcessTrip(MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key, StudentDataBlock *data_read);
 
+/**
+ * @brief Lê o registro de uma tag Ultralight/NTAG.
+ * @param pwd Senha NTAG (PWD_AUTH, 4 bytes) ou NULL para tags sem proteção.
+ */
+StatusCode Tdh_UlReadStudentData(MFRC522Ptr_t mfrc, StudentDataBlock *data_block, const uint8_t *pwd);
+
+/**
+ * @brief Grava o registro (e a cópia) numa tag Ultralight/NTAG.
+ */
+StatusCode Tdh_UlWriteStudentData(MFRC522Ptr_t mfrc, StudentDataBlock *data_block, const uint8_t *pwd);
+
+/**
+ * @brief Embarque numa tag Ultralight/NTAG: lê, confere e regrava só a página
+ * do contador.
+ */
+StatusCode Tdh_UlProcessTrip(MFRC522Ptr_t mfrc, const uint8_t *pwd, StudentDataBlock *data_read);
+
+/**
+ * @brief Monta a identidade v4 de um aluno novo (nome truncado em 17
+ * caracteres), com o CRC.
+ */
+void Tdh_PrepareV4Identity(TdhV4Identity *ident, uint32_t id, const char *name, uint32_t route_bitmap);
+
+/**
+ * @brief Provisionamento: grava o registro e lê de volta, numa única
+ * autenticação. MIFARE Classic recebe o v4 (identidade e contador zerado);
+ * Ultralight/NTAG, o v3 com o nome truncado e a cópia. Só retorna STATUS_OK
+ * se o cartão devolver o que foi gravado; senão STATUS_CRC_WRONG ou o erro
+ * da comunicação.
+ */
+StatusCode Tdh_ProvisionAnyCard(MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key,
+                                const uint8_t *pwd, const TdhV4Identity *ident);
+
+/**
+ * @brief Embarque em qualquer tag e versão de registro, escolhendo o
+ * caminho pelo SAK: Ultralight/NTAG sem Crypto1 (v3), MIFARE Classic com
+ * sessão no setor. No Classic, a versão é reconhecida, o registro
+ * conferido e o contador gravado numa única sessão; v3 segue o caminho de
+ * Tdh_ProcessTrip().
+ * @param route Rota atual (1..32), conferida com route_bitmap do v4.
+ * @return STATUS_OK também com rec->route_denied (nada gravado);
+ * STATUS_CRC_WRONG com o bloco de valor do v4 ilegível (o contador não
+ * recomeça).
+ */
+StatusCode Tdh_BoardAnyCard(MFRC522Ptr_t mfrc, uint8_t blockAddr, MIFARE_Key *key, const uint8_t *pwd,
+                            uint8_t route, TdhStudentRecord *rec);
+
 #endif // TAG_DATA_HANDLER_H
\ No newline at end of file
@@ -30,7 +30,12 @@ static sd_card_t sd_cards[] = {  // Um para cada cartão SD
         // Se não estiver usando, pode ser desativado.
         .use_card_detect = false, // <--- MUDANÇA: Desativado para simplificar
         .card_detect_gpio = 22,   // Exemplo, pode ser qualquer pino livre se ativado
-        .card_detected_true = 1   
+        .card_detected_true = 1,
+        // Load switch (ex.: TPS22918) na alimentação do cartão. Permite
+        // desligar o cartão quando ocioso (ver Sdh_IdleTask).
+        .use_power_switch = false, // Ative se a placa tiver o load switch
+        .power_switch_gpio = 21,   // Pino EN do load switch
+        .power_switch_on = 1       // Nível que liga o cartão
     }
 };
 
@@ -0,0 +1,220 @@
+// Arquivo: inc/sd_card/roster.c
+
+#include "roster.h"
+#include "sd_card_handler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(roster_record_t) == 32, "roster_record_t mudou de tamanho");
+_Static_assert(ROSTER_SECTOR_SIZE % sizeof(roster_record_t) == 0, "registro atravessa setor");
+
+// Fragmentos do arquivo que a tabela do fast seek comporta: (N - 1) / 2
+#define ROSTER_CLMT_LEN 32
+
+static FIL ros_fil;
+static DWORD ros_clmt[ROSTER_CLMT_LEN];
+static bool ros_open = false;
+static uint32_t ros_mount;  // Sdh_MountCount() de quando ros_fil foi aberto
+static roster_header_t ros_header;
+static uint8_t ros_index[ROSTER_MAX_SECTORS][ROSTER_KEY_SIZE];
+static uint8_t ros_sector[ROSTER_SECTOR_SIZE];
+
+static void ros_make_key(uint8_t key[ROSTER_KEY_SIZE], const uint8_t *uid, uint8_t uid_size) {
+    memset(key, 0, ROSTER_KEY_SIZE);
+    memcpy(key, uid, uid_size);
+    key[ROSTER_KEY_SIZE - 1] = uid_size;
+}
+
+// A chave são os primeiros 8 bytes do registro (uid + uid_size)
+static int ros_compare(const void *a, const void *b) {
+    return memcmp(a, b, ROSTER_KEY_SIZE);
+}
+
+static bool ros_read_sector(uint32_t sector, void *buffer) {
+    UINT br = 0;
+    return f_lseek(&ros_fil, (FSIZE_t)sector * ROSTER_SECTOR_SIZE) == FR_OK &&
+           f_read(&ros_fil, buffer, ROSTER_SECTOR_SIZE, &br) == FR_OK && br == ROSTER_SECTOR_SIZE;
+}
+
+bool Ros_Open(void) {
+    Ros_Close();
+    if (!Sdh_Wake()) return false;
+    ros_mount = Sdh_MountCount();
+    if (f_open(&ros_fil, ROSTER_FILE, FA_READ) != FR_OK) {
+        return false;  // Sem cadastro: UIDs desconhecidos ficam só com o UID
+    }
+
+    bool ok = ros_read_sector(0, ros_sector);
+    memcpy(&ros_header, ros_sector, sizeof ros_header);
+    const roster_header_t *h = &ros_header;
+    ok = ok && h->magic == ROSTER_MAGIC && h->version == ROSTER_VERSION &&
+         h->record_size == sizeof(roster_record_t) &&
+         h->data_sectors == (h->count + ROSTER_RECORDS_PER_SECTOR - 1) / ROSTER_RECORDS_PER_SECTOR &&
+         h->index_sectors == (h->data_sectors * ROSTER_KEY_SIZE + ROSTER_SECTOR_SIZE - 1) / ROSTER_SECTOR_SIZE &&
+         f_size(&ros_fil) == (FSIZE_t)(1 + h->index_sectors + h->data_sectors) * ROSTER_SECTOR_SIZE;
+    if (ok && h->data_sectors > ROSTER_MAX_SECTORS) {
+        printf("ROSTER: %lu alunos, acima do limite de %u.\n", (unsigned long)h->count,
+               (unsigned)(ROSTER_MAX_SECTORS * ROSTER_RECORDS_PER_SECTOR));
+        ok = false;
+    }
+    for (uint32_t s = 0; ok && s < h->index_sectors; s++) {
+        ok = ros_read_sector(1 + s, ros_sector);
+        uint32_t first = s * (ROSTER_SECTOR_SIZE / ROSTER_KEY_SIZE);
+        uint32_t n = h->data_sectors - first;
+        if (n > ROSTER_SECTOR_SIZE / ROSTER_KEY_SIZE) n = ROSTER_SECTOR_SIZE / ROSTER_KEY_SIZE;
+        memcpy(ros_index[first], ros_sector, n * ROSTER_KEY_SIZE);
+    }
+    if (!ok) {
+        printf("ROSTER: %s invalido, ignorado.\n", ROSTER_FILE);
+        f_close(&ros_fil);
+        return false;
+    }
+
+    // Fast seek: o f_lseek de cada consulta não percorre a FAT
+    ros_fil.cltbl = ros_clmt;
+    ros_clmt[0] = ROSTER_CLMT_LEN;
+    if (f_lseek(&ros_fil, CREATE_LINKMAP) != FR_OK) {
+        ros_fil.cltbl = NULL;  // Fragmentado demais: seek comum
+    }
+    ros_open = true;
+    printf("ROSTER: %lu alunos, indice de %lu setores.\n", (unsigned long)h->count,
+           (unsigned long)h->data_sectors);
+    return true;
+}
+
+void Ros_Close(void) {
+    if (!ros_open) return;
+    f_close(&ros_fil);
+    ros_open = false;
+}
+
+bool Ros_IsOpen(void) {
+    return ros_open;
+}
+
+// ros_fil é da montagem em que foi aberto: depois de um novo f_mount (fim da
+// exportação USB, retomada que falhou) o arquivo, que o PC pode ter trocado,
+// é reaberto com o índice
+static bool ros_revalidate(void) {
+    if (ros_open && ros_mount != Sdh_MountCount()) {
+        ros_open = false;  // O FIL antigo não vale mais nem para f_close
+        printf("ROSTER: volume remontado, reabrindo %s.\n", ROSTER_FILE);
+        Ros_Open();
+    }
+    return ros_open;
+}
+
+ros_result_t Ros_Lookup(const uint8_t *uid, uint8_t uid_size, roster_record_t *record) {
+    if (!ros_open || !uid_size || uid_size > sizeof record->uid) return ROS_ABSENT;
+    if (!Sdh_Wake() || !ros_revalidate()) return ROS_IO_ERROR;
+    if (!ros_header.count) return ROS_ABSENT;
+    uint8_t key[ROSTER_KEY_SIZE];
+    ros_make_key(key, uid, uid_size);
+
+    // Último setor cuja primeira chave é <= key
+    uint32_t lo = 0, hi = ros_header.data_sectors;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (memcmp(ros_index[mid], key, ROSTER_KEY_SIZE) <= 0) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    if (memcmp(ros_index[lo], key, ROSTER_KEY_SIZE) > 0) return ROS_ABSENT;
+
+    if (!ros_read_sector(1 + ros_header.index_sectors + lo, ros_sector)) {
+        printf("ROSTER: falha ao ler o setor %lu.\n", (unsigned long)lo);
+        return ROS_IO_ERROR;
+    }
+    uint32_t n = ros_header.count - lo * ROSTER_RECORDS_PER_SECTOR;
+    if (n > ROSTER_RECORDS_PER_SECTOR) n = ROSTER_RECORDS_PER_SECTOR;
+    const roster_record_t *found =
+        bsearch(key, ros_sector, n, sizeof(roster_record_t), ros_compare);
+    if (!found) return ROS_ABSENT;
+    *record = *found;
+    record->student_name[sizeof record->student_name - 1] = '\0';
+    return ROS_FOUND;
+}
+
+bool Ros_RouteAllowed(const roster_record_t *record, uint8_t route) {
+    uint32_t routes = record->route_bitmap;
+    return !routes || (route >= 1 && route <= 32 && ((routes >> (route - 1)) & 1));
+}
+
+bool Ros_Build(roster_record_t *records, uint32_t count,
+               bool (*write)(void *ctx, const void *data, uint32_t size), void *ctx) {
+    uint32_t data_sectors = (count + ROSTER_RECORDS_PER_SECTOR - 1) / ROSTER_RECORDS_PER_SECTOR;
+    if (data_sectors > ROSTER_MAX_SECTORS) return false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        roster_record_t *r = &records[i];
+        if (r->uid_size != 4 && r->uid_size != 7) return false;
+        memset(r->uid + r->uid_size, 0, sizeof r->uid - r->uid_size);
+        memset(r->reserved, 0, sizeof r->reserved);
+        r->student_name[sizeof r->student_name - 1] = '\0';
+    }
+    qsort(records, count, sizeof *records, ros_compare);
+    for (uint32_t i = 1; i < count; i++) {
+        if (!ros_compare(&records[i - 1], &records[i])) return false;  // UID repetido
+    }
+
+    static uint8_t sector[ROSTER_SECTOR_SIZE];
+    roster_header_t h = {
+        .magic = ROSTER_MAGIC,
+        .version = ROSTER_VERSION,
+        .record_size = sizeof(roster_record_t),
+        .count = count,
+        .index_sectors = (data_sectors * ROSTER_KEY_SIZE + ROSTER_SECTOR_SIZE - 1) / ROSTER_SECTOR_SIZE,
+        .data_sectors = data_sectors,
+    };
+    memset(sector, 0, sizeof sector);
+    memcpy(sector, &h, sizeof h);
+    if (!write(ctx, sector, sizeof sector)) return false;
+
+    // Índice: primeira chave de cada setor de dados
+    for (uint32_t s = 0; s < h.index_sectors; s++) {
+        memset(sector, 0, sizeof sector);
+        for (uint32_t k = 0; k < ROSTER_SECTOR_SIZE / ROSTER_KEY_SIZE; k++) {
+            uint32_t d = s * (ROSTER_SECTOR_SIZE / ROSTER_KEY_SIZE) + k;
+            if (d >= data_sectors) break;
+            memcpy(sector + k * ROSTER_KEY_SIZE, &records[d * ROSTER_RECORDS_PER_SECTOR], ROSTER_KEY_SIZE);
+        }
+        if (!write(ctx, sector, sizeof sector)) return false;
+    }
+
+    for (uint32_t d = 0; d < data_sectors; d++) {
+        uint32_t n = count - d * ROSTER_RECORDS_PER_SECTOR;
+        if (n > ROSTER_RECORDS_PER_SECTOR) n = ROSTER_RECORDS_PER_SECTOR;
+        memset(sector, 0, sizeof sector);
+        memcpy(sector, &records[d * ROSTER_RECORDS_PER_SECTOR], n * sizeof(roster_record_t));
+        if (!write(ctx, sector, sizeof sector)) return false;
+    }
+    return true;
+}
+
+static bool ros_write_fil(void *ctx, const void *data, uint32_t size) {
+    UINT bw = 0;
+    return f_write((FIL *)ctx, data, size, &bw) == FR_OK && bw == size;
+}
+
+bool Ros_BuildFile(roster_record_t *records, uint32_t count) {
+    FIL fil;
+    if (!Sdh_Wake()) return false;
+
+    bool reopen = ros_open;
+    Ros_Close();
+    if (f_open(&fil, ROSTER_FILE, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        printf("ROSTER: Falha ao criar %s.\n", ROSTER_FILE);
+        return false;
+    }
+    bool ok = Ros_Build(records, count, ros_write_fil, &fil);
+    ok = f_close(&fil) == FR_OK && ok;
+    if (!ok) {
+        printf("ROSTER: Falha ao gravar %s.\n", ROSTER_FILE);
+        f_unlink(ROSTER_FILE);
+    }
+    if (reopen) Ros_Open();
+    return ok;
+}
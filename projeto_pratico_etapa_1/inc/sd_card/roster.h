@@ -0,0 +1,95 @@
+#ifndef ROSTER_H
+#define ROSTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Cadastro de alunos por UID no cartão SD ---
+// Arquivo gerado fora do ônibus (sd_host_tool roster <csv>) com registros de
+// tamanho fixo ordenados pelo UID:
+//
+//   setor 0                      roster_header_t
+//   setores 1..index_sectors     primeira chave de cada setor de dados
+//   setores seguintes            ROSTER_RECORDS_PER_SECTOR registros cada
+//
+// Ros_Open() carrega as chaves do índice na RAM; cada Ros_Lookup() escolhe o
+// setor por busca binária nelas e lê só esse setor do cartão.
+//
+// O cadastro é da escola inteira: cada aluno traz as rotas em que pode
+// embarcar (o mesmo mapa do registro v4 no cartão), conferidas com
+// Ros_RouteAllowed() antes de embarcar alguém pelo cadastro.
+
+#define ROSTER_FILE "roster.bin"
+#define ROSTER_MAGIC 0x52535431  // "RST1"
+#define ROSTER_VERSION 2
+#define ROSTER_SECTOR_SIZE 512
+
+// Setores de dados cujo índice cabe na RAM (8 bytes cada): 4096 alunos
+#ifndef ROSTER_MAX_SECTORS
+#define ROSTER_MAX_SECTORS 256
+#endif
+
+// Chave de busca: UID completado com zeros + tamanho
+#define ROSTER_KEY_SIZE 8
+
+typedef struct {
+    uint8_t uid[7];            // UID de 4 ou 7 bytes, completado com zeros
+    uint8_t uid_size;
+    uint32_t student_id;
+    uint32_t route_bitmap;     // Bit r-1: rota r permitida; 0 = todas
+    char student_name[9];      // Mesmo tamanho do StudentDataBlock
+    uint8_t reserved[7];
+} roster_record_t;
+
+#define ROSTER_RECORDS_PER_SECTOR (ROSTER_SECTOR_SIZE / sizeof(roster_record_t))
+
+typedef struct {
+    uint32_t magic;            // ROSTER_MAGIC
+    uint16_t version;          // ROSTER_VERSION
+    uint16_t record_size;      // sizeof(roster_record_t)
+    uint32_t count;            // Registros
+    uint32_t index_sectors;
+    uint32_t data_sectors;
+} roster_header_t;
+
+/**
+ * @brief Abre ROSTER_FILE e carrega o índice esparso. O arquivo fica aberto
+ * (com a tabela de clusters do fast seek) até Ros_Close().
+ * @return false se não houver cadastro ou ele for inválido/grande demais.
+ */
+bool Ros_Open(void);
+void Ros_Close(void);
+bool Ros_IsOpen(void);
+
+typedef enum {
+    ROS_FOUND = 0,       // record preenchido
+    ROS_ABSENT,          // UID fora do cadastro
+    ROS_IO_ERROR,        // Cartão SD indisponível: não se sabe
+} ros_result_t;
+
+/**
+ * @brief Procura o aluno do UID: uma leitura de setor no cartão SD. Se o
+ * volume foi remontado desde Ros_Open(), reabre o cadastro antes.
+ * @return ROS_IO_ERROR se o SD não acordou ou o setor não pôde ser lido.
+ */
+ros_result_t Ros_Lookup(const uint8_t *uid, uint8_t uid_size, roster_record_t *record);
+
+/**
+ * @brief O aluno do registro pode embarcar na rota (1..32)?
+ */
+bool Ros_RouteAllowed(const roster_record_t *record, uint8_t route);
+
+/**
+ * @brief Gera o arquivo de cadastro: ordena records (na própria memória) e
+ * entrega o conteúdo a write, setor por setor.
+ * @return false com UID repetido ou inválido, ou se write falhar.
+ */
+bool Ros_Build(roster_record_t *records, uint32_t count,
+               bool (*write)(void *ctx, const void *data, uint32_t size), void *ctx);
+
+/**
+ * @brief Ros_Build() direto para ROSTER_FILE no cartão SD.
+ */
+bool Ros_BuildFile(roster_record_t *records, uint32_t count);
+
+#endif // ROSTER_H
@@ -3,8 +3,11 @@
 #include "sd_card_handler.h"
 #include "hw_config.h"      // Para sd_get_by_num() e sd_init_driver()
 #include "f_util.h"         // Para FRESULT_str()
+#include "diskio.h"         // Para STA_NOINIT e disk_ioctl()
 #include "rtc.h"
+#include "../spi_manager.h"
 #include "pico/stdlib.h"
+#include <inttypes.h>       // Para PRIu32
 #include <string.h>         // Para memcpy
 #include <stdio.h>          // Para printf
 
@@ -14,11 +17,61 @@ FATFS fs_global;
 // Nome padrão para o arquivo de log
 #define LOG_FILENAME "log_viagens.txt"
 
+// --- Gerenciamento de ociosidade ---
+// Tempo sem acessos até o cartão ser desselecionado (e desligado, se houver
+// load switch configurado em hw_config.c)
+#ifndef SDH_IDLE_TIMEOUT_MS
+#define SDH_IDLE_TIMEOUT_MS 2000
+#endif
+// Tempo para a alimentação do cartão estabilizar após religar o load switch
+#define SDH_POWER_UP_DELAY_MS 5
+// 1: registra no console cada entrada e saída do repouso
+#ifndef SDH_DEBUG
+#define SDH_DEBUG 0
+#endif
+
+typedef enum {
+    SDH_STATE_UNMOUNTED,   // Sdh_Init ainda não montou o cartão
+    SDH_STATE_ACTIVE,      // Barramento SD ativo e cartão pronto
+    SDH_STATE_BUS_OFF,     // Cartão desselecionado, pinos em alta impedância
+    SDH_STATE_POWER_OFF,   // Idem, e alimentação cortada pelo load switch
+    SDH_STATE_EXPORTED     // FatFs desmontado; o cartão pertence ao USB (MSC)
+} sdh_state_t;
+
+static sdh_state_t sdh_state = SDH_STATE_UNMOUNTED;
+static uint32_t sdh_idle_timeout_ms = SDH_IDLE_TIMEOUT_MS;
+static absolute_time_t sdh_last_access;
+static sdh_wake_stats_t sdh_wake_stats;
+static uint32_t sdh_mount_count = 0;
+
+static void sdh_touch(void) {
+    sdh_last_access = get_absolute_time();
+}
+
+// Liga/desliga a alimentação do cartão, se a placa tiver o load switch
+static void sdh_set_power(sd_card_t *pSD, bool on) {
+    if (!pSD->use_power_switch) return;
+    gpio_put(pSD->power_switch_gpio, on ? pSD->power_switch_on : !pSD->power_switch_on);
+}
+
+static void sdh_power_init(sd_card_t *pSD) {
+    if (!pSD->use_power_switch) return;
+    gpio_init(pSD->power_switch_gpio);
+    sdh_set_power(pSD, true);
+    gpio_set_dir(pSD->power_switch_gpio, GPIO_OUT);
+    sleep_ms(SDH_POWER_UP_DELAY_MS);
+}
+
 
 /**
  * @brief Inicializa o hardware SPI para o cartão SD e monta o sistema de arquivos.
  */
 bool Sdh_Init(void) {
+    // Já montado: apenas garante que o cartão esteja acordado (sem novo f_mount)
+    if (sdh_state != SDH_STATE_UNMOUNTED) {
+        return Sdh_Wake();
+    }
+
     // Esta função da biblioteca de exemplo lê a configuração em hw_config.c e prepara o SPI
     sd_init_driver(); 
     // time_init();
@@ -30,6 +83,7 @@ bool Sdh_Init(void) {
         return false;
     }
     printf(">> SUCESSO: Configuracao do SD carregada.\n");
+    sdh_power_init(pSD);
 
     printf("[INIT] Tentando montar o cartao SD (f_mount)...\n");
     // f_mount usa o nome do drive (ex: "0:") que está em pSD->pcName
@@ -43,9 +97,211 @@ bool Sdh_Init(void) {
     // Copia a instância montada para a variável global para uso em outras funções
     memcpy(&fs_global, &pSD->fatfs, sizeof(FATFS));
 
+    sdh_mount_count++;
+    sdh_state = SDH_STATE_ACTIVE;
+    sdh_touch();
+    return true;
+}
+
+/**
+ * @brief Coloca o cartão em repouso: sincroniza, desseleciona e libera os
+ * pinos do SPI0 e, se configurado, corta a alimentação do cartão.
+ */
+void Sdh_Sleep(void) {
+    if (sdh_state != SDH_STATE_ACTIVE) return;
+    sd_card_t *pSD = sd_get_by_num(0);
+
+    // SPI0 já entregue a outro periférico (RFID) e sem load switch: não há o
+    // que desligar. O cartão continua ativo e o Sdh_Wake() seguinte não paga
+    // a retomada; o próximo teste fica para o fim de outro período ocioso
+    if (!pSD->use_power_switch && !spi_manager_sd_active()) {
+        sdh_touch();
+        return;
+    }
+
+    // Os arquivos são sempre fechados pelas funções Sdh_*; aqui só garantimos
+    // que o driver terminou as escritas pendentes antes de soltar o barramento
+    disk_ioctl(0, CTRL_SYNC, NULL);
+    spi_manager_deactivate_sd();
+
+    if (pSD->use_power_switch) {
+        sdh_set_power(pSD, false);
+        // Sem alimentação o cartão sai do modo SPI: o driver precisa refazer
+        // a inicialização. Se alguém acessar o FatFs sem Sdh_Wake(), o
+        // próprio FatFs chama disk_initialize() e remonta o volume.
+        pSD->m_Status |= STA_NOINIT;
+        sdh_state = SDH_STATE_POWER_OFF;
+#if SDH_DEBUG
+        printf("[SD_IDLE] Cartao ocioso: barramento liberado e alimentacao desligada.\n");
+#endif
+    } else {
+        sdh_state = SDH_STATE_BUS_OFF;
+#if SDH_DEBUG
+        printf("[SD_IDLE] Cartao ocioso: barramento liberado.\n");
+#endif
+    }
+}
+
+/**
+ * @brief Traz o cartão de volta do repouso (retomada a quente, sem f_mount).
+ */
+bool Sdh_Wake(void) {
+    if (sdh_state == SDH_STATE_EXPORTED) {
+        // O PC está escrevendo no volume: montar aqui corromperia a FAT
+        printf("[SD_USB] Cartao exportado via USB; FatFs indisponivel.\n");
+        return false;
+    }
+    if (sdh_state == SDH_STATE_UNMOUNTED) {
+        return Sdh_Init();
+    }
+    if (sdh_state == SDH_STATE_ACTIVE) {
+        sdh_touch();
+        return true;
+    }
+
+    uint64_t t0 = time_us_64();
+    sd_card_t *pSD = sd_get_by_num(0);
+    bool was_powered_off = (sdh_state == SDH_STATE_POWER_OFF);
+
+    if (was_powered_off) {
+        sdh_set_power(pSD, true);
+        sleep_ms(SDH_POWER_UP_DELAY_MS);
+    }
+    spi_manager_activate_sd();
+
+    if (was_powered_off) {
+        // Refaz apenas o handshake do driver; o volume FatFs continua montado
+        pSD->m_Status |= STA_NOINIT;
+        if (pSD->init(pSD) & STA_NOINIT) {
+            printf("[SD_IDLE] ERRO: Retomada a quente falhou. Remontando...\n");
+            sdh_state = SDH_STATE_UNMOUNTED;
+            return Sdh_Init();
+        }
+    }
+
+    sdh_state = SDH_STATE_ACTIVE;
+    sdh_touch();
+
+    sdh_wake_stats.count++;
+    sdh_wake_stats.last_us = (uint32_t)(time_us_64() - t0);
+    if (sdh_wake_stats.last_us > sdh_wake_stats.max_us) {
+        sdh_wake_stats.max_us = sdh_wake_stats.last_us;
+    }
+#if SDH_DEBUG
+    printf("[SD_IDLE] Cartao acordado em %" PRIu32 " us (max %" PRIu32 " us)\n",
+           sdh_wake_stats.last_us, sdh_wake_stats.max_us);
+#endif
     return true;
 }
 
+/**
+ * @brief Deve ser chamada periodicamente no laço principal. Coloca o cartão
+ * em repouso após o período de ociosidade configurado.
+ */
+void Sdh_IdleTask(void) {
+    if (sdh_state != SDH_STATE_ACTIVE) return;
+    int64_t idle_us = absolute_time_diff_us(sdh_last_access, get_absolute_time());
+    if (idle_us >= (int64_t)sdh_idle_timeout_ms * 1000) {
+        Sdh_Sleep();
+    }
+}
+
+/**
+ * @brief Entrega o cartão para acesso direto por blocos (exportação USB):
+ * sincroniza, desmonta o FatFs e deixa o cartão acordado e inicializado.
+ */
+bool Sdh_Export(void) {
+    if (sdh_state == SDH_STATE_EXPORTED) return true;
+    if (sdh_state != SDH_STATE_UNMOUNTED && !Sdh_Wake()) return false;
+
+    sd_init_driver();
+    sd_card_t *pSD = sd_get_by_num(0);
+    if (sdh_state == SDH_STATE_UNMOUNTED) {
+        sdh_power_init(pSD);
+    } else {
+        // Nada pode ficar no cache do FatFs: o volume vai mudar por fora
+        disk_ioctl(0, CTRL_SYNC, NULL);
+        f_unmount(pSD->pcName);
+        sdh_state = SDH_STATE_UNMOUNTED;
+    }
+    spi_manager_activate_sd();
+
+    if ((pSD->m_Status & STA_NOINIT) && (pSD->init(pSD) & STA_NOINIT)) {
+        printf("[SD_USB] ERRO: Cartao nao respondeu a inicializacao.\n");
+        return false;
+    }
+    sdh_state = SDH_STATE_EXPORTED;
+    printf("[SD_USB] FatFs desmontado; cartao exportado (%llu setores).\n",
+           (unsigned long long)pSD->sectors);
+    return true;
+}
+
+/**
+ * @brief Termina a exportação e monta de novo o volume, que pode ter sido
+ * alterado pelo PC.
+ */
+bool Sdh_Reclaim(void) {
+    if (sdh_state != SDH_STATE_EXPORTED) return Sdh_Wake();
+    sdh_state = SDH_STATE_UNMOUNTED;
+    return Sdh_Init();
+}
+
+uint32_t Sdh_MountCount(void) {
+    return sdh_mount_count;
+}
+
+void Sdh_SetIdleTimeout(uint32_t timeout_ms) {
+    sdh_idle_timeout_ms = timeout_ms;
+}
+
+void Sdh_GetWakeStats(sdh_wake_stats_t *stats) {
+    *stats = sdh_wake_stats;
+}
+
+
+/**
+ * @brief Grava um arquivo binário pequeno de uma vez (abre, escreve, fecha).
+ */
+bool Sdh_SaveBlob(const char *filename, const void *data, uint32_t size) {
+    FIL fil;
+    UINT bw = 0;
+
+    if (!Sdh_Wake()) return false;
+
+    FRESULT fr = f_open(&fil, filename, FA_CREATE_ALWAYS | FA_WRITE);
+    if (fr != FR_OK) {
+        printf("SD_BLOB: Falha ao criar %s. Codigo: %d\n", filename, fr);
+        return false;
+    }
+    fr = f_write(&fil, data, size, &bw);
+    FRESULT fr_close = f_close(&fil);
+    if (fr != FR_OK || bw != size || fr_close != FR_OK) {
+        printf("SD_BLOB: Falha ao gravar %s. Codigo: %d/%d\n", filename, fr, fr_close);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Lê um arquivo gravado por Sdh_SaveBlob(); tamanho diferente é erro.
+ */
+bool Sdh_LoadBlob(const char *filename, void *data, uint32_t size) {
+    FIL fil;
+    UINT br = 0;
+
+    if (!Sdh_Wake()) return false;
+
+    FRESULT fr = f_open(&fil, filename, FA_READ);
+    if (fr != FR_OK) {
+        return false;  // Ainda não existe: quem chama usa os padrões
+    }
+    bool ok = f_size(&fil) == size && f_read(&fil, data, size, &br) == FR_OK && br == size;
+    f_close(&fil);
+    if (!ok) {
+        printf("SD_BLOB: %s com tamanho inesperado, ignorado.\n", filename);
+    }
+    return ok;
+}
 
 /**
  * @brief Grava um registro de embarque de aluno no arquivo de log no cartão SD.
@@ -54,6 +310,8 @@ bool Sdh_LogBoarding(StudentDataBlock *data) {
     FIL fil;
     FRESULT fr;
 
+    if (!Sdh_Wake()) return false;
+
     // Abre o arquivo de log no modo de "append" (adicionar ao final do arquivo)
     fr = f_open(&fil, LOG_FILENAME, FA_OPEN_APPEND | FA_WRITE);
     if (fr != FR_OK) {
@@ -97,6 +355,8 @@ bool Sdh_LogBoarding(StudentDataBlock *data) {
 bool Sdh_PrintLogsToSerial() {
     FIL fil;
     FRESULT fr;
+
+    if (!Sdh_Wake()) return false;
     char line_buffer[256]; // Um buffer para armazenar cada linha lida
 
     printf("\n--- LENDO LOG DO CARTAO SD ---\n");
@@ -133,6 +393,8 @@ bool Sdh_ReadLogFile(char *buffer, uint32_t buffer_size) {
     FIL fil;
     FRESULT fr;
 
+    if (!Sdh_Wake()) return false;
+
     // Garante que o buffer esteja limpo antes de começar
     memset(buffer, 0, buffer_size);
 
@@ -175,6 +437,7 @@ bool Sdh_ReadLogFile(char *buffer, uint32_t buffer_size) {
  * @brief Apaga o arquivo de log do cartão SD.
  */
 bool Sdh_DeleteLogFile(void) {
+    if (!Sdh_Wake()) return false;
     FRESULT fr = f_unlink(LOG_FILENAME);
 
     if (fr == FR_OK) {
@@ -27,4 +27,68 @@ bool Sdh_DeleteLogFile(void);
  */
 bool Sdh_RunTest(void);
 
+/**
+ * @brief Deve ser chamada periodicamente. Após SDH_IDLE_TIMEOUT_MS sem acessos,
+ * desseleciona o cartão, libera os pinos do SPI0 e, se houver load switch
+ * configurado em hw_config.c, corta a alimentação do cartão.
+ */
+void Sdh_IdleTask(void);
+
+/**
+ * @brief Coloca o cartão em repouso imediatamente (ex.: antes de ligar o WiFi).
+ */
+void Sdh_Sleep(void);
+
+/**
+ * @brief Acorda o cartão se estiver em repouso, sem remontar o sistema de
+ * arquivos. As funções Sdh_* já chamam esta função internamente.
+ * @return true se o cartão está pronto para uso.
+ */
+bool Sdh_Wake(void);
+
+/**
+ * @brief Desmonta o FatFs e entrega o cartão para acesso direto por blocos
+ * (ex.: exportação USB MSC). Enquanto exportado, as funções Sdh_* e
+ * Sdh_Init() retornam false em vez de montar o volume.
+ * @return true se o cartão está inicializado e pronto para read/write_blocks.
+ */
+bool Sdh_Export(void);
+
+/**
+ * @brief Encerra a exportação e remonta o sistema de arquivos.
+ */
+bool Sdh_Reclaim(void);
+
+/**
+ * @brief Número de montagens bem-sucedidas do volume. Um FIL aberto antes de
+ * uma nova montagem (Sdh_Reclaim(), retomada que falhou) não vale mais.
+ */
+uint32_t Sdh_MountCount(void);
+
+/**
+ * @brief Altera o período de ociosidade usado por Sdh_IdleTask().
+ */
+void Sdh_SetIdleTimeout(uint32_t timeout_ms);
+
+// Retomadas do repouso (Sdh_Wake() com o cartão dormindo) desde o boot
+typedef struct {
+    uint32_t count;
+    uint32_t last_us;        // Latência da última, em microssegundos
+    uint32_t max_us;
+} sdh_wake_stats_t;
+
+void Sdh_GetWakeStats(sdh_wake_stats_t *stats);
+
+/**
+ * @brief Grava um bloco binário pequeno (configuração, calibração) num
+ * arquivo próprio, substituindo o conteúdo anterior.
+ */
+bool Sdh_SaveBlob(const char *filename, const void *data, uint32_t size);
+
+/**
+ * @brief Lê um bloco gravado por Sdh_SaveBlob().
+ * @return true só se o arquivo existe e tem exatamente 'size' bytes.
+ */
+bool Sdh_LoadBlob(const char *filename, void *data, uint32_t size);
+
 #endif // SD_CARD_HANDLER_H
\ No newline at end of file
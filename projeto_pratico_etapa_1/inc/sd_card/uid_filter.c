@@ -0,0 +1,141 @@
+// Arquivo: inc/sd_card/uid_filter.c
+
+#include "uid_filter.h"
+#include "sd_card_handler.h"
+#include <stdio.h>
+#include <string.h>
+
+static ufl_header_t ufl_header;
+static uint8_t ufl_bits[UFL_MAX_BYTES];
+static bool ufl_loaded = false;
+
+static void ufl_file_name(char *name, size_t size, uint16_t route) {
+    snprintf(name, size, UFL_FILE_FMT, (unsigned)route);
+}
+
+// Finalizador do MurmurHash3: espalha bem os bits de h
+static uint32_t ufl_mix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Duas hashes do UID; a i-ésima posição é h1 + i * h2 (Kirsch-Mitzenmacher)
+static void ufl_hash(const uint8_t *uid, uint8_t uid_size, uint32_t *h1, uint32_t *h2) {
+    uint32_t h = 2166136261u;
+    for (uint8_t i = 0; i < uid_size; i++) {
+        h = (h ^ uid[i]) * 16777619u;
+    }
+    h = (h ^ uid_size) * 16777619u;
+    *h1 = ufl_mix(h);
+    *h2 = ufl_mix(h ^ 0x9e3779b9u) | 1;
+}
+
+static bool ufl_valid_shape(uint32_t bytes, uint8_t hashes) {
+    return bytes && bytes <= UFL_MAX_BYTES && hashes && hashes <= UFL_MAX_HASHES;
+}
+
+bool Ufl_Create(uint16_t route, uint32_t bytes, uint8_t hashes) {
+    if (!ufl_valid_shape(bytes, hashes)) return false;
+    memset(&ufl_header, 0, sizeof ufl_header);
+    ufl_header.magic = UFL_MAGIC;
+    ufl_header.version = UFL_VERSION;
+    ufl_header.route = route;
+    ufl_header.bits = bytes * 8;
+    ufl_header.hashes = hashes;
+    memset(ufl_bits, 0, bytes);
+    ufl_loaded = true;
+    return true;
+}
+
+uint8_t Ufl_OptimalHashes(uint32_t bytes, uint32_t count) {
+    if (!count) return 1;
+    // ln 2 ~ 0.6931, em ponto fixo com arredondamento
+    uint32_t k = (uint32_t)(((uint64_t)bytes * 8 * 6931 + (uint64_t)count * 5000) / ((uint64_t)count * 10000));
+    if (k < 1) k = 1;
+    if (k > UFL_MAX_HASHES) k = UFL_MAX_HASHES;
+    return (uint8_t)k;
+}
+
+void Ufl_Add(const uint8_t *uid, uint8_t uid_size) {
+    if (!ufl_loaded) return;
+    uint32_t h1, h2;
+    ufl_hash(uid, uid_size, &h1, &h2);
+    for (uint8_t i = 0; i < ufl_header.hashes; i++) {
+        uint32_t bit = (h1 + i * h2) % ufl_header.bits;
+        ufl_bits[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+    }
+    ufl_header.count++;
+}
+
+bool Ufl_MayContain(const uint8_t *uid, uint8_t uid_size) {
+    if (!ufl_loaded) return true;  // Sem filtro, ninguém é barrado
+    uint32_t h1, h2;
+    ufl_hash(uid, uid_size, &h1, &h2);
+    for (uint8_t i = 0; i < ufl_header.hashes; i++) {
+        uint32_t bit = (h1 + i * h2) % ufl_header.bits;
+        if (!(ufl_bits[bit >> 3] & (1u << (bit & 7)))) return false;
+    }
+    return true;
+}
+
+bool Ufl_Load(uint16_t route) {
+    FIL fil;
+    UINT br = 0;
+    char name[16];
+
+    ufl_loaded = false;
+    if (!Sdh_Wake()) return false;
+    ufl_file_name(name, sizeof name, route);
+    if (f_open(&fil, name, FA_READ) != FR_OK) {
+        return false;  // Rota sem filtro: todos passam
+    }
+    const ufl_header_t *h = &ufl_header;
+    bool ok = f_read(&fil, &ufl_header, sizeof ufl_header, &br) == FR_OK && br == sizeof ufl_header &&
+              h->magic == UFL_MAGIC && h->version == UFL_VERSION && h->route == route &&
+              h->bits % 8 == 0 && ufl_valid_shape(h->bits / 8, h->hashes) &&
+              f_size(&fil) == sizeof ufl_header + h->bits / 8 &&
+              f_read(&fil, ufl_bits, h->bits / 8, &br) == FR_OK && br == h->bits / 8;
+    f_close(&fil);
+    if (!ok) {
+        printf("UFL: %s invalido, ignorado.\n", name);
+        return false;
+    }
+    ufl_loaded = true;
+    printf("UFL: rota %u, %lu UIDs em %lu bytes (%u hashes).\n", (unsigned)route,
+           (unsigned long)h->count, (unsigned long)(h->bits / 8), (unsigned)h->hashes);
+    return true;
+}
+
+bool Ufl_Save(void) {
+    FIL fil;
+    UINT bw = 0;
+    char name[16];
+
+    if (!ufl_loaded || !Sdh_Wake()) return false;
+    ufl_file_name(name, sizeof name, ufl_header.route);
+    if (f_open(&fil, name, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        printf("UFL: Falha ao criar %s.\n", name);
+        return false;
+    }
+    uint32_t bytes = ufl_header.bits / 8;
+    bool ok = f_write(&fil, &ufl_header, sizeof ufl_header, &bw) == FR_OK && bw == sizeof ufl_header &&
+              f_write(&fil, ufl_bits, bytes, &bw) == FR_OK && bw == bytes;
+    ok = f_close(&fil) == FR_OK && ok;
+    if (!ok) {
+        printf("UFL: Falha ao gravar %s.\n", name);
+        f_unlink(name);
+    }
+    return ok;
+}
+
+bool Ufl_IsLoaded(void) {
+    return ufl_loaded;
+}
+
+const ufl_header_t *Ufl_Header(void) {
+    return &ufl_header;
+}
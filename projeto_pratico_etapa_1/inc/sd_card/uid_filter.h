@@ -0,0 +1,70 @@
+#ifndef UID_FILTER_H
+#define UID_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Filtro de Bloom dos UIDs autorizados por rota ---
+// Um arquivo por rota no cartão SD (sd_host_tool filter <csv> <bytes> <rota>),
+// carregado inteiro na RAM no início do modo RFID. Negativo é definitivo: o
+// cartão não é desta rota. Positivo pode ser falso (taxa escolhida pelo
+// tamanho do filtro) e é confirmado no cadastro (roster.h) quando houver.
+
+// Nome do arquivo da rota, ex.: "rota001.blf"
+#define UFL_FILE_FMT "rota%03u.blf"
+#define UFL_MAGIC 0x55464C31  // "UFL1"
+#define UFL_VERSION 1
+
+// Maior filtro que cabe na RAM (bytes)
+#ifndef UFL_MAX_BYTES
+#define UFL_MAX_BYTES 4096
+#endif
+
+// Funções de hash por consulta, no máximo
+#define UFL_MAX_HASHES 16
+
+typedef struct {
+    uint32_t magic;           // UFL_MAGIC
+    uint16_t version;         // UFL_VERSION
+    uint16_t route;
+    uint32_t bits;            // Tamanho do filtro, múltiplo de 8
+    uint32_t count;           // UIDs inseridos
+    uint8_t hashes;           // Bits por UID
+    uint8_t reserved[3];
+} ufl_header_t;
+
+/**
+ * @brief Começa um filtro vazio na RAM para a rota (substitui o carregado).
+ * @return false se bytes passar de UFL_MAX_BYTES ou hashes for inválido.
+ */
+bool Ufl_Create(uint16_t route, uint32_t bytes, uint8_t hashes);
+
+/**
+ * @brief Número de hashes que minimiza os falsos positivos para count UIDs
+ * num filtro de bytes bytes: (bits / count) * ln 2.
+ */
+uint8_t Ufl_OptimalHashes(uint32_t bytes, uint32_t count);
+
+void Ufl_Add(const uint8_t *uid, uint8_t uid_size);
+
+/**
+ * @brief Consulta o filtro: só hash e leitura de bits na RAM.
+ * @return false se o UID com certeza não é da rota.
+ */
+bool Ufl_MayContain(const uint8_t *uid, uint8_t uid_size);
+
+/**
+ * @brief Lê o filtro da rota do cartão SD.
+ * @return false se não houver arquivo ou ele for inválido/grande demais.
+ */
+bool Ufl_Load(uint16_t route);
+
+// Grava o filtro da RAM no arquivo da rota dele
+bool Ufl_Save(void);
+
+// Há filtro válido na RAM (carregado ou criado)
+bool Ufl_IsLoaded(void);
+
+const ufl_header_t *Ufl_Header(void);
+
+#endif // UID_FILTER_H
@@ -20,6 +20,10 @@ typedef enum {
 
 static peripheral_state_t current_peripheral = PERIPHERAL_NONE;
 
+// CS dos leitores RFID além do principal (cs_pin)
+static uint extra_rfid_cs[MFRC_MAX_INSTANCES - 1];
+static uint8_t extra_rfid_cs_count = 0;
+
 // Função auxiliar para desativar um pino, configurando-o como entrada.
 // Isso garante que ele não irá interferir no barramento (alta impedância).
 static void deactivate_pin(uint pin) {
@@ -31,6 +35,39 @@ static void deactivate_pin(uint pin) {
     gpio_disable_pulls(pin);
 }
 
+// Solta os pinos do RFID: barramento e os CS de todos os leitores. Com o
+// leitor na PIO (MFRC522_PIO_SPI) eles não são do SPI0 e ficam como estão
+static void deactivate_rfid_pins(void) {
+#if !MFRC522_PIO_SPI
+    deactivate_pin(sck_pin);
+    deactivate_pin(mosi_pin);
+    deactivate_pin(miso_pin);
+    deactivate_pin(cs_pin);
+    for (uint8_t i = 0; i < extra_rfid_cs_count; i++) {
+        deactivate_pin(extra_rfid_cs[i]);
+    }
+#endif
+}
+
+void spi_manager_add_rfid_cs(uint pin) {
+    if (pin == cs_pin) return;
+    for (uint8_t i = 0; i < extra_rfid_cs_count; i++) {
+        if (extra_rfid_cs[i] == pin) return;
+    }
+    if (extra_rfid_cs_count >= MFRC_MAX_INSTANCES - 1) {
+        printf("[SPI_MANAGER] ERRO: CS %u ignorado, limite de leitores RFID.\n", pin);
+        return;
+    }
+    extra_rfid_cs[extra_rfid_cs_count++] = pin;
+    // Com o RFID já ativo (sempre, se estiver na PIO), o novo CS precisa
+    // subir antes do primeiro acesso
+    if (MFRC522_PIO_SPI || current_peripheral == PERIPHERAL_RFID) {
+        gpio_init(pin);
+        gpio_set_dir(pin, GPIO_OUT);
+        gpio_put(pin, 1);
+    }
+}
+
 // Função para desativar completamente todos os periféricos
 void spi_manager_deactivate_all(void) {
     printf("[SPI_MANAGER] Desativando todos os perifericos...\n");
@@ -46,10 +83,7 @@ void spi_manager_deactivate_all(void) {
     }
     
     // Desativa todos os pinos RFID
-    deactivate_pin(sck_pin);
-    deactivate_pin(mosi_pin);
-    deactivate_pin(miso_pin);
-    deactivate_pin(cs_pin);
+    deactivate_rfid_pins();
     
     // Desativa todos os pinos SD Card
     sd_card_t *pSD = sd_get_by_num(0);
@@ -94,6 +128,10 @@ void wifi_activate() {
 }
 
 void spi_manager_activate_rfid() {
+#if MFRC522_PIO_SPI
+    // Leitor na PIO, com pinos próprios: o SPI0 continua com o SD (se ativo)
+    // e não há nada a trocar. PCD_Init()/PCD_WarmInit() sobem a PIO
+#else
     if (current_peripheral == PERIPHERAL_RFID) {
         printf("[SPI_MANAGER] RFID ja esta ativo.\n");
         return;
@@ -105,7 +143,7 @@ void spi_manager_activate_rfid() {
     spi_manager_deactivate_all();
     
     // Inicializa o SPI0 com a velocidade do RFID
-    spi_init(spi0, 4000000); // 4 MHz
+    spi_init(spi0, MFRC522_BIT_RATE);
 
     // Mapeia as funções do SPI0 para os pinos do RFID
     gpio_set_function(sck_pin, GPIO_FUNC_SPI);
@@ -116,9 +154,15 @@ void spi_manager_activate_rfid() {
     gpio_init(cs_pin);
     gpio_set_dir(cs_pin, GPIO_OUT);
     gpio_put(cs_pin, 1); // Garante que comece desativado (nível alto)
+    for (uint8_t i = 0; i < extra_rfid_cs_count; i++) {
+        gpio_init(extra_rfid_cs[i]);
+        gpio_set_dir(extra_rfid_cs[i], GPIO_OUT);
+        gpio_put(extra_rfid_cs[i], 1);
+    }
     
     current_peripheral = PERIPHERAL_RFID;
     printf("[SPI_MANAGER] RFID ativado com sucesso.\n");
+#endif
 }
 
 void spi_manager_activate_sd() {
@@ -172,10 +216,7 @@ void spi_manager_activate_wifi() {
         spi_deinit(spi0);
         
         // Desativa todos os pinos RFID
-        deactivate_pin(sck_pin);
-        deactivate_pin(mosi_pin);
-        deactivate_pin(miso_pin);
-        deactivate_pin(cs_pin);
+        deactivate_rfid_pins();
         
         // Desativa todos os pinos SD Card
         sd_card_t *pSD = sd_get_by_num(0);
@@ -207,10 +248,7 @@ void spi_manager_deactivate_rfid(void) {
     if (current_peripheral == PERIPHERAL_RFID) {
         printf("[SPI_MANAGER] Desativando RFID...\n");
         spi_deinit(spi0);
-        deactivate_pin(sck_pin);
-        deactivate_pin(mosi_pin);
-        deactivate_pin(miso_pin);
-        deactivate_pin(cs_pin);
+        deactivate_rfid_pins();
         current_peripheral = PERIPHERAL_NONE;
         printf("[SPI_MANAGER] RFID desativado.\n");
     }
@@ -233,6 +271,10 @@ void spi_manager_deactivate_sd(void) {
     }
 }
 
+bool spi_manager_sd_active(void) {
+    return current_peripheral == PERIPHERAL_SD;
+}
+
 void spi_manager_deactivate_wifi(void) {
     if (current_peripheral == PERIPHERAL_WIFI) {
         wifi_deactivate();
@@ -298,10 +340,7 @@ void spi_manager_reactivate_wifi_for_core1(void) {
         }
         
         // Desativa todos os pinos SPI
-        deactivate_pin(sck_pin);
-        deactivate_pin(mosi_pin);
-        deactivate_pin(miso_pin);
-        deactivate_pin(cs_pin);
+        deactivate_rfid_pins();
         
         sd_card_t *pSD = sd_get_by_num(0);
         if (pSD && pSD->spi) {
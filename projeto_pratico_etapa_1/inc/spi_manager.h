@@ -1,9 +1,18 @@
 #ifndef SPI_MANAGER_H
 #define SPI_MANAGER_H
 
-// Ativa e configura o barramento SPI0 para o Leitor RFID (pinos 0, 1, 2, 3)
+#include <stdbool.h>
+#include "pico/types.h"
+
+// Ativa e configura o barramento SPI0 para o Leitor RFID (pinos 0, 1, 2, 3).
+// Não faz nada com MFRC522_PIO_SPI: o leitor fica na PIO e o SPI0 com o SD
 void spi_manager_activate_rfid(void);
 
+// Registra o CS de mais um leitor RFID no mesmo SPI0 (porta traseira etc.).
+// Todos os CS registrados ficam em nível alto enquanto o RFID está ativo e
+// soltos junto com os pinos do RFID
+void spi_manager_add_rfid_cs(uint pin);
+
 // Ativa e configura o barramento SPI0 para o Cartão SD (pinos 16, 17, 18, 19)
 void spi_manager_activate_sd(void);
 
@@ -15,6 +24,9 @@ void spi_manager_deactivate_rfid(void);
 void spi_manager_deactivate_sd(void);
 void spi_manager_deactivate_wifi(void);
 
+// true se o SPI0 está configurado para o Cartão SD
+bool spi_manager_sd_active(void);
+
 // Função para desativar tudo
 void spi_manager_deactivate_all(void);
 
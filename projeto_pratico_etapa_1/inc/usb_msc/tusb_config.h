@@ -0,0 +1,28 @@
+#ifndef _TUSB_CONFIG_H_
+#define _TUSB_CONFIG_H_
+
+// Configuração do TinyUSB para o dispositivo composto CDC (console do
+// stdio_usb) + MSC (exportação do cartão SD). Substitui a do pico_stdio_usb
+// quando o build tem USB_MSC_EXPORT ligado.
+
+#define CFG_TUSB_RHPORT0_MODE   (OPT_MODE_DEVICE)
+#define CFG_TUSB_OS             OPT_OS_PICO
+
+#define CFG_TUD_ENDPOINT0_SIZE  64
+
+#define CFG_TUD_CDC             (1)
+#define CFG_TUD_MSC             (1)
+#define CFG_TUD_HID             (0)
+#define CFG_TUD_MIDI            (0)
+#define CFG_TUD_VENDOR          (0)
+
+// Mesmos buffers que o stdio_usb usa por padrão
+#define CFG_TUD_CDC_RX_BUFSIZE  (256)
+#define CFG_TUD_CDC_TX_BUFSIZE  (256)
+
+// Cada callback READ10/WRITE10 recebe até 8 setores: um único comando
+// multibloco no cartão em vez de 8 comandos de 1 setor. Precisa ser múltiplo
+// de 512 (ver Msc_Read()).
+#define CFG_TUD_MSC_EP_BUFSIZE  (4096)
+
+#endif // _TUSB_CONFIG_H_
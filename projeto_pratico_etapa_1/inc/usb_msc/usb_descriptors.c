@@ -0,0 +1,106 @@
+// Arquivo: inc/usb_msc/usb_descriptors.c
+//
+// Descritores do dispositivo composto CDC + MSC. Com o TinyUSB ligado à
+// aplicação, o pico_stdio_usb deixa de fornecer os seus; o CDC continua na
+// interface 0, então o console serial funciona como antes.
+
+#include <string.h>
+#include "tusb.h"
+#include "pico/unique_id.h"
+
+// VID de testes do TinyUSB. O PID não pode ser o 0x000A do stdio_usb, senão
+// o PC reaproveita o driver do dispositivo só-CDC
+#define USBD_VID 0xCAFE
+#define USBD_PID 0x4009
+
+enum {
+    ITF_NUM_CDC = 0,
+    ITF_NUM_CDC_DATA,
+    ITF_NUM_MSC,
+    ITF_NUM_TOTAL
+};
+
+#define EPNUM_CDC_NOTIF 0x81
+#define EPNUM_CDC_OUT   0x02
+#define EPNUM_CDC_IN    0x82
+#define EPNUM_MSC_OUT   0x03
+#define EPNUM_MSC_IN    0x83
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MSC_DESC_LEN)
+
+enum {
+    STRID_LANGID = 0,
+    STRID_MANUFACTURER,
+    STRID_PRODUCT,
+    STRID_SERIAL,
+    STRID_CDC,
+    STRID_MSC,
+};
+
+static const tusb_desc_device_t desc_device = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    // IAD: obrigatório para o CDC dentro de um dispositivo composto
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USBD_VID,
+    .idProduct = USBD_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = STRID_MANUFACTURER,
+    .iProduct = STRID_PRODUCT,
+    .iSerialNumber = STRID_SERIAL,
+    .bNumConfigurations = 1,
+};
+
+static const uint8_t desc_configuration[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, 250),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, STRID_CDC, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT,
+                       EPNUM_CDC_IN, 64),
+    TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, STRID_MSC, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+};
+
+static const char *const desc_strings[] = {
+    [STRID_MANUFACTURER] = "Embarcatech",
+    [STRID_PRODUCT] = "Leitor de embarque",
+    [STRID_SERIAL] = NULL,  // ID único da flash, preenchido em tempo de execução
+    [STRID_CDC] = "Console",
+    [STRID_MSC] = "Cartao SD",
+};
+
+const uint8_t *tud_descriptor_device_cb(void) {
+    return (const uint8_t *)&desc_device;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index) {
+    (void)index;
+    return desc_configuration;
+}
+
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    (void)langid;
+    static uint16_t desc_str[33];
+    char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    const char *str;
+    uint8_t len;
+
+    if (index == STRID_LANGID) {
+        desc_str[1] = 0x0409;  // Inglês (EUA)
+        len = 1;
+    } else {
+        if (index >= sizeof(desc_strings) / sizeof(desc_strings[0])) return NULL;
+        if (index == STRID_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof serial);
+            str = serial;
+        } else {
+            str = desc_strings[index];
+        }
+        len = (uint8_t)strlen(str);
+        if (len > 32) len = 32;
+        for (uint8_t i = 0; i < len; i++) desc_str[1 + i] = str[i];
+    }
+    desc_str[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * len + 2));
+    return desc_str;
+}
@@ -0,0 +1,109 @@
+// Arquivo: inc/usb_msc/usb_msc.c
+//
+// Exportação do cartão SD como dispositivo de armazenamento em massa. Aqui
+// fica só o roteamento de setores para sd_card_t (read_blocks/write_blocks);
+// os callbacks do TinyUSB estão em usb_msc_tusb.c. Assim esta parte também
+// roda no build de host, sobre o backend de blocos.
+
+#include "usb_msc.h"
+#include "sd_card_handler.h"
+#include "hw_config.h"      // Para sd_get_by_num()
+#include <stdio.h>
+#include <string.h>
+
+// Cartão exportado; NULL quando o FatFs é o dono do cartão
+static sd_card_t *msc_card = NULL;
+static bool msc_ejected = false;
+static msc_stats_t msc_stats;
+
+bool Msc_Export(void) {
+    if (msc_card) return true;
+    if (!Sdh_Export()) return false;
+
+    msc_card = sd_get_by_num(0);
+    msc_ejected = false;
+    memset(&msc_stats, 0, sizeof msc_stats);
+    printf("[USB_MSC] Cartao exportado: %lu setores de %d bytes.\n",
+           (unsigned long)msc_card->sectors, MSC_BLOCK_SIZE);
+    return true;
+}
+
+bool Msc_Release(void) {
+    if (!msc_card) return true;
+    msc_card = NULL;
+    printf("[USB_MSC] Fim da exportacao: %llu setores lidos, %llu gravados, %lu erros.\n",
+           (unsigned long long)msc_stats.blocks_read,
+           (unsigned long long)msc_stats.blocks_written,
+           (unsigned long)msc_stats.errors);
+    return Sdh_Reclaim();
+}
+
+bool Msc_IsExported(void) {
+    return msc_card != NULL;
+}
+
+bool Msc_IsEjected(void) {
+    return msc_ejected;
+}
+
+bool Msc_IsReady(void) {
+    return msc_card && !msc_ejected;
+}
+
+void Msc_GetCapacity(uint32_t *block_count, uint16_t *block_size) {
+    *block_count = Msc_IsReady() ? (uint32_t)msc_card->sectors : 0;
+    *block_size = MSC_BLOCK_SIZE;
+}
+
+// Valida uma transferência e devolve o número de setores (0 = inválida).
+// O TinyUSB só usa offset != 0 se CFG_TUD_MSC_EP_BUFSIZE não for múltiplo
+// do setor, o que tusb_config.h garante.
+static uint32_t msc_check(uint32_t lba, uint32_t offset, uint32_t bufsize) {
+    if (!Msc_IsReady() || offset || !bufsize || bufsize % MSC_BLOCK_SIZE) return 0;
+    uint32_t count = bufsize / MSC_BLOCK_SIZE;
+    if ((uint64_t)lba + count > msc_card->sectors) return 0;
+    return count;
+}
+
+int32_t Msc_Read(uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize) {
+    uint32_t count = msc_check(lba, offset, bufsize);
+    if (!count) return -1;
+    // Um único comando multibloco (CMD18) por pacote do TinyUSB
+    if (msc_card->read_blocks(msc_card, buffer, lba, count) != SD_BLOCK_DEVICE_ERROR_NONE) {
+        msc_stats.errors++;
+        printf("[USB_MSC] ERRO: Falha ao ler setor %lu (+%lu).\n",
+               (unsigned long)lba, (unsigned long)count);
+        return -1;
+    }
+    msc_stats.blocks_read += count;
+    return (int32_t)bufsize;
+}
+
+int32_t Msc_Write(uint32_t lba, uint32_t offset, const uint8_t *buffer, uint32_t bufsize) {
+    uint32_t count = msc_check(lba, offset, bufsize);
+    if (!count) return -1;
+    if (msc_card->write_blocks(msc_card, buffer, lba, count) != SD_BLOCK_DEVICE_ERROR_NONE) {
+        msc_stats.errors++;
+        printf("[USB_MSC] ERRO: Falha ao gravar setor %lu (+%lu).\n",
+               (unsigned long)lba, (unsigned long)count);
+        return -1;
+    }
+    msc_stats.blocks_written += count;
+    return (int32_t)bufsize;
+}
+
+void Msc_StartStop(bool start, bool load_eject) {
+    if (!load_eject || !msc_card) return;
+    if (start) {
+        msc_ejected = false;
+        return;
+    }
+    // Nada a descarregar: sd_write_blocks() só retorna depois que o cartão
+    // terminou de programar (CMD13 no fim de cada escrita)
+    msc_ejected = true;
+    printf("[USB_MSC] Midia ejetada pelo PC.\n");
+}
+
+void Msc_GetStats(msc_stats_t *stats) {
+    *stats = msc_stats;
+}
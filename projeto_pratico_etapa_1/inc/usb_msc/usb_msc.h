@@ -0,0 +1,70 @@
+#ifndef USB_MSC_H
+#define USB_MSC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Tamanho de setor exposto ao PC; igual ao bloco do cartão SD
+#define MSC_BLOCK_SIZE 512
+
+/**
+ * @brief Contadores da sessão de exportação atual.
+ */
+typedef struct {
+    uint64_t blocks_read;
+    uint64_t blocks_written;
+    uint32_t errors;
+} msc_stats_t;
+
+/**
+ * @brief Desmonta o FatFs (Sdh_Export) e passa a atender o PC por blocos.
+ * Enquanto exportado, Sdh_Init() e as demais funções Sdh_* retornam false.
+ * @return true se o cartão está pronto para ser lido pelo PC.
+ */
+bool Msc_Export(void);
+
+/**
+ * @brief Encerra a exportação e remonta o FatFs (Sdh_Reclaim).
+ */
+bool Msc_Release(void);
+
+bool Msc_IsExported(void);
+
+/**
+ * @brief true depois que o PC ejetou a mídia (START STOP UNIT com eject).
+ */
+bool Msc_IsEjected(void);
+
+/**
+ * @brief true se o PC pode acessar a mídia (exportada e não ejetada).
+ */
+bool Msc_IsReady(void);
+
+/**
+ * @brief Capacidade da mídia; zero se não estiver pronta.
+ */
+void Msc_GetCapacity(uint32_t *block_count, uint16_t *block_size);
+
+/**
+ * @brief Lê setores do cartão para o PC (READ10).
+ * @param lba Primeiro setor.
+ * @param offset Deslocamento em bytes dentro de lba; deve ser 0.
+ * @param bufsize Múltiplo de MSC_BLOCK_SIZE.
+ * @return Bytes lidos ou -1 em caso de erro.
+ */
+int32_t Msc_Read(uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize);
+
+/**
+ * @brief Grava setores vindos do PC (WRITE10). Mesmas regras de Msc_Read().
+ */
+int32_t Msc_Write(uint32_t lba, uint32_t offset, const uint8_t *buffer, uint32_t bufsize);
+
+/**
+ * @brief START STOP UNIT: com load_eject, start=false ejeta e start=true
+ * recarrega a mídia.
+ */
+void Msc_StartStop(bool start, bool load_eject);
+
+void Msc_GetStats(msc_stats_t *stats);
+
+#endif // USB_MSC_H
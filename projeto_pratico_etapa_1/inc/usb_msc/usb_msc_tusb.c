@@ -0,0 +1,88 @@
+// Arquivo: inc/usb_msc/usb_msc_tusb.c
+//
+// Callbacks MSC do TinyUSB. Só repassam para usb_msc.c e traduzem falhas
+// em sense data SCSI. Rodam dentro de tud_task(), chamado pelo laço do modo
+// de exportação (contexto de thread, nunca IRQ): o caminho do cartão usa
+// mutex_enter_blocking e sleep_us.
+
+#include <string.h>
+#include "tusb.h"
+#include "usb_msc.h"
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16],
+                        uint8_t product_rev[4]) {
+    (void)lun;
+    const char vid[] = "Embarca";
+    const char pid[] = "Diario SD";
+    const char rev[] = "1.0";
+    memcpy(vendor_id, vid, strlen(vid));
+    memcpy(product_id, pid, strlen(pid));
+    memcpy(product_rev, rev, strlen(rev));
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun) {
+    if (!Msc_IsReady()) {
+        // MEDIUM NOT PRESENT: o PC mostra a unidade vazia
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);
+        return false;
+    }
+    return true;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t *block_count, uint16_t *block_size) {
+    (void)lun;
+    Msc_GetCapacity(block_count, block_size);
+}
+
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start,
+                           bool load_eject) {
+    (void)lun;
+    (void)power_condition;
+    Msc_StartStop(start, load_eject);
+    return true;
+}
+
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void *buffer,
+                          uint32_t bufsize) {
+    int32_t n = Msc_Read(lba, offset, buffer, bufsize);
+    if (n < 0) {
+        if (Msc_IsReady()) {
+            tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x11, 0x00);  // Unrecovered read error
+        } else {
+            tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);
+        }
+    }
+    return n;
+}
+
+bool tud_msc_is_writable_cb(uint8_t lun) {
+    (void)lun;
+    return true;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *buffer,
+                           uint32_t bufsize) {
+    int32_t n = Msc_Write(lba, offset, buffer, bufsize);
+    if (n < 0) {
+        if (Msc_IsReady()) {
+            tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x0C, 0x00);  // Write error
+        } else {
+            tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);
+        }
+    }
+    return n;
+}
+
+// Comandos SCSI que o TinyUSB não trata sozinho
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void *buffer,
+                        uint16_t bufsize) {
+    (void)buffer;
+    (void)bufsize;
+    switch (scsi_cmd[0]) {
+        case 0x35:  // SYNCHRONIZE CACHE (10): as escritas já são síncronas
+            return 0;
+        default:
+            tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);  // Invalid command
+            return -1;
+    }
+}
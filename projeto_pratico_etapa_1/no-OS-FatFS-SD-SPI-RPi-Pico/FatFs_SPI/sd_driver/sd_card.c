@@ -294,6 +294,91 @@ typedef enum {
 
 #define SPI_CMD(x) (0x40 | (x & 0x3f))
 
+/* Batched command framing and busy polling.
+ * Instead of one SPI (DMA) transfer per byte, the command frame and the
+ * NCR window are clocked in a single transfer, and busy/token polls clock
+ * SD_POLL_BATCH bytes at a time. Bytes received after the one of interest
+ * are kept in pSD->rx_ahead and consumed before the bus is clocked again.
+ * Set to 0 to get the original byte-at-a-time behaviour.
+ */
+#ifndef SD_FAST_CMD_ENABLED
+#define SD_FAST_CMD_ENABLED 1
+#endif
+
+#define SD_NCR_WINDOW 8   /*!< Max bytes between command and R1 (NCR) */
+#define SD_POLL_BATCH 16  /*!< Bytes clocked per busy/token poll */
+#define SD_R1_POLL_MAX 0x10  /*!< Total R1 poll budget, as before */
+// Polls spin for this long, then back off to one batch per interval
+#define SD_BUSY_SPIN_US 500
+#define SD_BUSY_POLL_INTERVAL_US 100
+
+/* Account the time sd_wait_ready() and sd_wait_token() spend waiting on the
+ * card in pSD->stats. Costs two timer reads per wait.
+ */
+#ifndef SD_BUSY_STATS_ENABLED
+#define SD_BUSY_STATS_ENABLED 1
+#endif
+
+#if SD_BUSY_STATS_ENABLED
+static void sd_stats_wait(uint64_t *total, uint32_t *count, uint32_t *max,
+                          absolute_time_t start) {
+    int64_t us = absolute_time_diff_us(start, get_absolute_time());
+    *total += us;
+    ++*count;
+    if (us > *max) *max = us;
+}
+#define SD_STATS_WAIT(pSD, kind, start)                                  \
+    sd_stats_wait(&(pSD)->stats.kind##_us, &(pSD)->stats.kind##_waits, \
+                  &(pSD)->stats.kind##_max_us, start)
+#else
+#define SD_STATS_WAIT(pSD, kind, start)
+#endif
+
+// Forget bytes received ahead. They are stale once the card is
+// deselected or the host transmits anything meaningful.
+static inline void sd_rx_flush(sd_card_t *pSD) {
+    pSD->rx_ahead_len = 0;
+    pSD->rx_ahead_pos = 0;
+}
+#if SD_FAST_CMD_ENABLED
+static void sd_rx_keep(sd_card_t *pSD, const uint8_t *src, size_t length) {
+    myASSERT(length <= SD_RX_AHEAD_SIZE);
+    memcpy(pSD->rx_ahead, src, length);
+    pSD->rx_ahead_len = length;
+    pSD->rx_ahead_pos = 0;
+}
+#endif
+static inline size_t sd_rx_pending(sd_card_t *pSD) {
+    return pSD->rx_ahead_len - pSD->rx_ahead_pos;
+}
+// Receive length bytes, taking any received-ahead bytes first
+static bool sd_rx_bytes(sd_card_t *pSD, uint8_t *buffer, size_t length) {
+    size_t n = sd_rx_pending(pSD);
+    if (n > length) n = length;
+    if (n) {
+        memcpy(buffer, pSD->rx_ahead + pSD->rx_ahead_pos, n);
+        pSD->rx_ahead_pos += n;
+    }
+    if (n == length) return true;
+    return sd_spi_transfer(pSD, NULL, buffer + n, length - n);
+}
+static uint8_t sd_rx_byte(sd_card_t *pSD) {
+    if (sd_rx_pending(pSD)) return pSD->rx_ahead[pSD->rx_ahead_pos++];
+    return sd_spi_write(pSD, SPI_FILL_CHAR);
+}
+// Some SD cards want to be deselected between every bus transaction
+static void sd_deselect_pulse(sd_card_t *pSD) {
+    sd_rx_flush(pSD);
+    sd_spi_deselect_pulse(pSD);
+}
+#if SD_FAST_CMD_ENABLED
+// Pace a poll loop: spin for SD_BUSY_SPIN_US, then yield between batches
+static inline void sd_poll_backoff(absolute_time_t start) {
+    if (absolute_time_diff_us(start, get_absolute_time()) > SD_BUSY_SPIN_US)
+        sleep_us(SD_BUSY_POLL_INTERVAL_US);
+}
+#endif
+
 static uint8_t sd_cmd_spi(sd_card_t *pSD, cmdSupported cmd, uint32_t arg) {
     uint8_t response;
     char cmdPacket[PACKET_SIZE];
@@ -325,6 +410,35 @@ static uint8_t sd_cmd_spi(sd_card_t *pSD, cmdSupported cmd, uint32_t arg) {
                 break;
         }
     }
+    // Whatever was clocked in before this command is stale now
+    sd_rx_flush(pSD);
+#if SD_FAST_CMD_ENABLED
+    // Send the frame, the CMD12 stuff byte and the NCR window in one transfer
+    uint8_t tx[PACKET_SIZE + 1 + SD_NCR_WINDOW];
+    uint8_t rx[sizeof tx];
+    memcpy(tx, cmdPacket, PACKET_SIZE);
+    memset(tx + PACKET_SIZE, SPI_FILL_CHAR, sizeof tx - PACKET_SIZE);
+    // The received byte immediataly following CMD12 is a stuff byte,
+    // it should be discarded before receive the response of the CMD12.
+    size_t first = PACKET_SIZE + (CMD12_STOP_TRANSMISSION == cmd ? 1 : 0);
+    size_t len = first + SD_NCR_WINDOW;
+    if (!sd_spi_transfer(pSD, tx, rx, len)) return R1_NO_RESPONSE;
+    for (size_t i = first; i < len; i++) {
+        // Got the response: keep what followed it (R3/R7/R2 bytes, busy)
+        if (!(rx[i] & R1_RESPONSE_RECV)) {
+            sd_rx_keep(pSD, rx + i + 1, len - i - 1);
+            return rx[i];
+        }
+    }
+    // Slow card: spend the rest of the poll budget a byte at a time
+    response = rx[len - 1];
+    for (int i = SD_NCR_WINDOW; i < SD_R1_POLL_MAX; i++) {
+        response = sd_spi_write(pSD, SPI_FILL_CHAR);
+        if (!(response & R1_RESPONSE_RECV)) {
+            break;
+        }
+    }
+#else
     // send a command
     for (int i = 0; i < PACKET_SIZE; i++) {
         sd_spi_write(pSD, cmdPacket[i]);
@@ -336,27 +450,46 @@ static uint8_t sd_cmd_spi(sd_card_t *pSD, cmdSupported cmd, uint32_t arg) {
     }
     // Loop for response: Response is sent back within command response time
     // (NCR), 0 to 8 bytes for SDC
-    for (int i = 0; i < 0x10; i++) {
+    for (int i = 0; i < SD_R1_POLL_MAX; i++) {
         response = sd_spi_write(pSD, SPI_FILL_CHAR);
         // Got the response
         if (!(response & R1_RESPONSE_RECV)) {
             break;
         }
     }
+#endif
     return response;
 }
 
 static bool sd_wait_ready(sd_card_t *pSD, int timeout) {
-    char resp;
+    uint8_t resp = 0x00;
 
+    // Busy bytes may already have been clocked in with the command
+    while (sd_rx_pending(pSD)) {
+        resp = sd_rx_byte(pSD);
+        if (resp) return true;
+    }
     // Keep sending dummy clocks with DI held high until the card releases the
     // DO line
-    absolute_time_t timeout_time = make_timeout_time_ms(timeout);
+    absolute_time_t start = get_absolute_time();
+    absolute_time_t timeout_time = delayed_by_ms(start, timeout);
+#if SD_FAST_CMD_ENABLED
+    uint8_t rx[SD_POLL_BATCH];
+    do {
+        if (!sd_spi_transfer(pSD, NULL, rx, sizeof rx)) break;
+        // DO stays high once released, so the last byte decides
+        resp = rx[sizeof rx - 1];
+        if (resp) break;
+        sd_poll_backoff(start);
+    } while (0 < absolute_time_diff_us(get_absolute_time(), timeout_time));
+#else
     do {
         resp = sd_spi_write(pSD, 0xFF);
     } while (resp == 0x00 &&
              0 < absolute_time_diff_us(get_absolute_time(), timeout_time));
+#endif
 
+    SD_STATS_WAIT(pSD, busy, start);
     if (resp == 0x00) DBG_PRINTF("%s failed\r\n", __FUNCTION__);
 
     // Return success/failure
@@ -376,9 +509,11 @@ static void sd_unlock(sd_card_t *pSD) {
 // Locks the SD card and acquires its SPI
 static void sd_acquire(sd_card_t *pSD) {
     sd_lock(pSD);
+    sd_rx_flush(pSD);
     sd_spi_acquire(pSD);
 }
 static void sd_release(sd_card_t *pSD) {
+    sd_rx_flush(pSD);
     sd_unlock(pSD);
     sd_spi_release(pSD);
 }
@@ -523,20 +658,21 @@ static int sd_cmd(sd_card_t *pSD, const cmdSupported cmd, uint32_t arg,
             DBG_PRINTF("V2-Version Card\r\n");
             pSD->card_type = SDCARD_V2;  // fallthrough
             // Note: No break here, need to read rest of the response
-        case CMD58_READ_OCR:  // Response R3
-            response = (sd_spi_write(pSD, SPI_FILL_CHAR) << 24);
-            response |= (sd_spi_write(pSD, SPI_FILL_CHAR) << 16);
-            response |= (sd_spi_write(pSD, SPI_FILL_CHAR) << 8);
-            response |= sd_spi_write(pSD, SPI_FILL_CHAR);
+        case CMD58_READ_OCR: {  // Response R3
+            uint8_t r[R3_R7_RESPONSE_SIZE - R1_RESPONSE_SIZE] = {0};
+            sd_rx_bytes(pSD, r, sizeof r);
+            response = ((uint32_t)r[0] << 24) | ((uint32_t)r[1] << 16) |
+                       ((uint32_t)r[2] << 8) | r[3];
             DBG_PRINTF("R3/R7: 0x%" PRIx32 "\r\n", response);
             break;
+        }
         case CMD12_STOP_TRANSMISSION:  // Response R1b
         case CMD38_ERASE:
             sd_wait_ready(pSD, SD_COMMAND_TIMEOUT);
             break;
         case CMD13_SEND_STATUS:  // Response R2
             response <<= 8;
-            response |= sd_spi_write(pSD, SPI_FILL_CHAR);
+            response |= sd_rx_byte(pSD);
             if (response) {
                 DBG_PRINTF("R2: 0x%" PRIx32 "\r\n", response);
                 if (response & 0x01 << 0) {
@@ -763,13 +899,38 @@ uint64_t sd_sectors(sd_card_t *pSD) {
 static bool sd_wait_token(sd_card_t *pSD, uint8_t token) {
     TRACE_PRINTF("%s(0x%02hhx)\r\n", __FUNCTION__, token);
 
+    // The token may already be among the bytes that followed the R1
+    while (sd_rx_pending(pSD)) {
+        if (token == sd_rx_byte(pSD)) {
+            return true;
+        }
+    }
     const uint32_t timeout = SD_COMMAND_TIMEOUT;  // Wait for start token
-    absolute_time_t timeout_time = make_timeout_time_ms(timeout);
+    absolute_time_t start = get_absolute_time();
+    absolute_time_t timeout_time = delayed_by_ms(start, timeout);
+#if SD_FAST_CMD_ENABLED
+    uint8_t rx[SD_POLL_BATCH];
+    do {
+        if (!sd_spi_transfer(pSD, NULL, rx, sizeof rx)) break;
+        for (size_t i = 0; i < sizeof rx; i++) {
+            if (token == rx[i]) {
+                // Start of the data block: keep it for the reader
+                sd_rx_keep(pSD, rx + i + 1, sizeof rx - i - 1);
+                SD_STATS_WAIT(pSD, token, start);
+                return true;
+            }
+        }
+        sd_poll_backoff(start);
+    } while (0 < absolute_time_diff_us(get_absolute_time(), timeout_time));
+#else
     do {
         if (token == sd_spi_write(pSD, SPI_FILL_CHAR)) {
+            SD_STATS_WAIT(pSD, token, start);
             return true;
         }
     } while (0 < absolute_time_diff_us(get_absolute_time(), timeout_time));
+#endif
+    SD_STATS_WAIT(pSD, token, start);
     DBG_PRINTF("sd_wait_token: timeout\r\n");
     return false;
 }
@@ -785,13 +946,13 @@ static int sd_read_bytes(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
         DBG_PRINTF("%s:%d Read timeout\r\n", __FILE__, __LINE__);
         return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
-    // read data
-    for (uint32_t i = 0; i < length; i++) {
-        buffer[i] = sd_spi_write(pSD, SPI_FILL_CHAR);
+    // read data and the CRC16 checksum for the data block
+    uint8_t crc_bytes[2];
+    if (!sd_rx_bytes(pSD, buffer, length) ||
+        !sd_rx_bytes(pSD, crc_bytes, sizeof crc_bytes)) {
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
-    // Read the CRC16 checksum for the data block
-    crc = (sd_spi_write(pSD, SPI_FILL_CHAR) << 8);
-    crc |= sd_spi_write(pSD, SPI_FILL_CHAR);
+    crc = (crc_bytes[0] << 8) | crc_bytes[1];
 
 #if SD_CRC_ENABLED
     if (crc_on) {
@@ -817,14 +978,16 @@ static int sd_read_block(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
         DBG_PRINTF("%s:%d Read timeout\r\n", __FILE__, __LINE__);
         return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
-    // read data
-    // bool spi_transfer(const uint8_t *tx, uint8_t *rx, size_t length)
-    if (!sd_spi_transfer(pSD, NULL, buffer, length)) {
+    // read data (head may already be in rx_ahead; the rest goes by DMA)
+    if (!sd_rx_bytes(pSD, buffer, length)) {
         return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
     // Read the CRC16 checksum for the data block
-    crc = (sd_spi_write(pSD, SPI_FILL_CHAR) << 8);
-    crc |= sd_spi_write(pSD, SPI_FILL_CHAR);
+    uint8_t crc_bytes[2];
+    if (!sd_rx_bytes(pSD, crc_bytes, sizeof crc_bytes)) {
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+    crc = (crc_bytes[0] << 8) | crc_bytes[1];
 
 #if SD_CRC_ENABLED
     if (crc_on) {
@@ -904,6 +1067,7 @@ static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
     uint8_t response = 0xFF;
 
     // indicate start of block
+    sd_rx_flush(pSD);
     sd_spi_write(pSD, token);
 
     // write the data
@@ -917,12 +1081,29 @@ static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
     }
 #endif
 
+#if SD_FAST_CMD_ENABLED
+    // Checksum, response token and the first busy bytes in one transfer
+    uint8_t tx[SD_POLL_BATCH];
+    uint8_t rx[SD_POLL_BATCH];
+    memset(tx, SPI_FILL_CHAR, sizeof tx);
+    tx[0] = crc >> 8;
+    tx[1] = crc;
+    if (!sd_spi_transfer(pSD, tx, rx, sizeof tx)) {
+        return (response & SPI_DATA_RESPONSE_MASK);
+    }
+    response = rx[2];
+    // Short programming time: card already released DO within the batch
+    if (rx[sizeof rx - 1] != 0x00) {
+        return (response & SPI_DATA_RESPONSE_MASK);
+    }
+#else
     // write the checksum CRC16
     sd_spi_write(pSD, crc >> 8);
     sd_spi_write(pSD, crc);
 
     // check the response token
     response = sd_spi_write(pSD, SPI_FILL_CHAR);
+#endif
 
     // Wait for last block to be written
     if (false == sd_wait_ready(pSD, SD_COMMAND_TIMEOUT)) {
@@ -984,7 +1165,7 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
         sd_cmd(pSD, ACMD23_SET_WR_BLK_ERASE_COUNT, blockCnt, 1, 0);
 
         // Some SD cards want to be deselected between every bus transaction:
-        sd_spi_deselect_pulse(pSD);
+        sd_deselect_pulse(pSD);
 
         // Multiple block write command
         if (SD_BLOCK_DEVICE_ERROR_NONE !=
@@ -1005,13 +1186,15 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
          * done by sending 'Stop Tran' token instead of 'Start Block' token at
          * the beginning of the next block
          */
+        sd_rx_flush(pSD);
         sd_spi_write(pSD, SPI_STOP_TRAN);
     }
     uint32_t stat = 0;
     // Some SD cards want to be deselected between every bus transaction:
-    sd_spi_deselect_pulse(pSD);
-    status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
-    return status;
+    sd_deselect_pulse(pSD);
+    int stat_status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+    // Don't let a clean CMD13 hide a rejected data block
+    return status ? status : stat_status;
 }
 
 int sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
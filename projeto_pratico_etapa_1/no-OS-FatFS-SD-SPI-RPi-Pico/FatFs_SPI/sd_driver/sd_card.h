@@ -32,6 +32,20 @@ extern "C" {
 
 typedef struct sd_card_t sd_card_t;
 
+// Time spent waiting on the card itself, as opposed to clocking data.
+// Accumulated while SD_BUSY_STATS_ENABLED (sd_card.c); zero it to restart.
+typedef struct {
+    uint64_t busy_us;       // DO held low: programming after writes, CMD12
+    uint32_t busy_waits;
+    uint32_t busy_max_us;
+    uint64_t token_us;      // Read access time until the data start token
+    uint32_t token_waits;
+    uint32_t token_max_us;
+} sd_card_stats_t;
+
+// Bytes clocked in past a response by one batched command/poll transfer
+#define SD_RX_AHEAD_SIZE 16
+
 // "Class" representing SD Cards
 struct sd_card_t {
     const char *pcName;
@@ -41,6 +55,10 @@ struct sd_card_t {
     bool use_card_detect;
     uint card_detect_gpio;    // Card detect; ignored if !use_card_detect
     uint card_detected_true;  // Varies with card socket; ignored if !use_card_detect
+    // Optional load switch gating the card's supply between bursts
+    bool use_power_switch;
+    uint power_switch_gpio;   // Load switch enable; ignored if !use_power_switch
+    uint power_switch_on;     // Level that powers the card; ignored if !use_power_switch
     // Drive strength levels for GPIO outputs.
     // enum gpio_drive_strength { GPIO_DRIVE_STRENGTH_2MA = 0, GPIO_DRIVE_STRENGTH_4MA = 1, GPIO_DRIVE_STRENGTH_8MA = 2,
     // GPIO_DRIVE_STRENGTH_12MA = 3 }
@@ -54,6 +72,12 @@ struct sd_card_t {
     mutex_t mutex;
     FATFS fatfs;
     bool mounted;
+    // Received bytes that followed a response inside a batched transfer;
+    // consumed before the bus is clocked again. Dropped on deselect.
+    uint8_t rx_ahead[SD_RX_AHEAD_SIZE];
+    uint8_t rx_ahead_len;
+    uint8_t rx_ahead_pos;
+    sd_card_stats_t stats;
 
     int (*init)(sd_card_t *sd_card_p);
     int (*write_blocks)(sd_card_t *sd_card_p, const uint8_t *buffer,
@@ -18,6 +18,8 @@
 #include "my_debug.h"
 #include "rtc.h"
 #include "sd_card.h"
+#include "tests/block_bench.h"
+#include "tests/fs_bench.h"
 
 extern "C" {
     int lliot(size_t pnum);
@@ -303,6 +305,41 @@ static void run_big_file_test() {
     uint32_t seed = atoi(pcSeed);
     big_file_test(pcPathName, size, seed);
 }
+static void run_fs_bench() {
+    fs_bench_params_t params;
+    fs_bench_default_params(&params);
+    uint32_t *const args[] = {&params.ops, &params.record_size,
+                              &params.au_size, &params.baud};
+    for (size_t i = 0; i < count_of(args); ++i) {
+        const char *arg = strtok(NULL, " ");
+        if (!arg) break;
+        *args[i] = strtoul(arg, 0, 0);
+    }
+    sd_card_t *pSD = sd_get_by_num(0);
+    if (!params.au_size && !pSD->mounted) {
+        printf("Drive %s is not mounted\n", pSD->pcName);
+        return;
+    }
+    if (!fs_bench_run(pSD, &params)) printf("fs_bench failed\n");
+}
+static void run_block_bench() {
+    block_bench_params_t params;
+    block_bench_default_params(&params);
+    const char *arg = strtok(NULL, " ");
+    if (arg) params.ops = strtoul(arg, 0, 0);
+    if ((arg = strtok(NULL, " "))) params.blocks = strtoul(arg, 0, 0);
+    if ((arg = strtok(NULL, " "))) params.write_pct = strtoul(arg, 0, 0);
+    if ((arg = strtok(NULL, " "))) params.random = 0 == strcmp(arg, "rand");
+    if ((arg = strtok(NULL, " "))) params.first_lba = strtoull(arg, 0, 0);
+    if ((arg = strtok(NULL, " "))) params.region_blocks = strtoul(arg, 0, 0);
+    sd_card_t *pSD = sd_get_by_num(0);
+    if (params.write_pct && pSD->mounted) {
+        printf("Writes would corrupt the mounted file system: unmount %s first\n",
+               pSD->pcName);
+        return;
+    }
+    if (!block_bench_run(pSD, &params)) printf("block_bench failed\n");
+}
 static void del_node(const char *path) {
     FILINFO fno;
     char buff[256];
@@ -406,6 +443,20 @@ static cmd_def_t cmds[] = {
      " <size in bytes> must be multiple of 512.\n"
      "\te.g.: big_file_test bf 1048576 1\n"
      "\tor: big_file_test big3G-3 0xC0000000 3"},
+    {"fs_bench", run_fs_bench,
+     "fs_bench [ops] [record bytes] [cluster bytes] [SPI Hz]:\n"
+     " Times the logging workload on drive 0: appends with and without\n"
+     " f_sync, preallocated file, many small files, open/close, unlink.\n"
+     " A nonzero cluster size REFORMATS the card first.\n"
+     "\te.g.: fs_bench 200 64\n"
+     "\tor: fs_bench 100 64 32768 25000000"},
+    {"block_bench", run_block_bench,
+     "block_bench [ops] [blocks] [write %] [seq|rand] [first LBA] [region]:\n"
+     " Times raw sd_read_blocks/sd_write_blocks on drive 0 and prints a\n"
+     " latency histogram and the card busy / read access breakdown.\n"
+     " Writes DESTROY the data in the region; the drive must be unmounted.\n"
+     "\te.g.: block_bench 500 8 0 rand\n"
+     "\tor: block_bench 200 64 100 seq 0x100000 65536"},
     {"cdef", run_cdef,
      "cdef:\n  Create Disk and Example Files\n"
      "  Expects card to be already formatted and mounted"},
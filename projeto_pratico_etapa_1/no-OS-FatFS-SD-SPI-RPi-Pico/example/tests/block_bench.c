@@ -0,0 +1,198 @@
+/* block_bench.c
+Raw block-layer latency benchmark.
+
+lliot only says whether low level I/O works. This times every
+sd_read_blocks()/sd_write_blocks() call for a given transfer size, access
+pattern and read/write mix, and prints p50/p90/p99/max from a latency
+histogram plus a breakdown of the elapsed time into card busy (programming),
+read access time and the rest (commands and data on the bus). Enough to tell
+SD card models apart.
+
+The SPI interface has no command queue: there is exactly one transfer in
+flight, so every figure here is at queue depth 1.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "pico/stdlib.h"
+//
+#include "ff.h" /* Obtains integer types */
+//
+#include "diskio.h" /* STA_NOINIT */
+//
+#include "block_bench.h"
+
+#define BLOCK_SIZE 512
+
+// Log-linear buckets: exact below 16 us, then 16 per power of two, so a
+// reported percentile is at most 1/16 above the real one.
+#define HIST_SUB_BITS 4
+#define HIST_SUB (1u << HIST_SUB_BITS)
+#define HIST_BUCKETS ((32 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef struct {
+    uint32_t bucket[HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+    uint64_t total_us;
+} hist_t;
+
+static hist_t hist_read, hist_write;
+static uint32_t rng_state;
+
+void block_bench_default_params(block_bench_params_t *params) {
+    params->ops = 200;
+    params->blocks = 1;
+    params->write_pct = 0;
+    params->random = false;
+    params->first_lba = 0;
+    params->region_blocks = 0;
+    params->seed = 1;
+}
+
+static uint32_t rng_next(void) {  // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static unsigned hist_index(uint32_t us) {
+    if (us < HIST_SUB) return us;
+    unsigned shift = 31 - __builtin_clz(us) - HIST_SUB_BITS;
+    return (shift + 1) * HIST_SUB + ((us >> shift) & (HIST_SUB - 1));
+}
+
+// Largest value that falls in bucket i
+static uint32_t hist_upper(unsigned i) {
+    if (i < HIST_SUB) return i;
+    unsigned shift = i / HIST_SUB - 1;
+    uint64_t lower = (uint64_t)(HIST_SUB + i % HIST_SUB) << shift;
+    return lower + (1u << shift) - 1;
+}
+
+static void hist_add(hist_t *h, uint32_t us) {
+    h->bucket[hist_index(us)]++;
+    h->count++;
+    h->total_us += us;
+    if (us > h->max) h->max = us;
+}
+
+static uint32_t hist_percentile(const hist_t *h, unsigned pct) {
+    uint32_t rank = (h->count * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (unsigned i = 0; i < HIST_BUCKETS; ++i) {
+        seen += h->bucket[i];
+        if (seen >= rank && seen) {
+            uint32_t v = hist_upper(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+static void hist_print(const char *name, const hist_t *h, uint32_t blocks) {
+    if (!h->count) return;
+    double secs = h->total_us ? h->total_us / 1E6 : 1E-6;
+    printf("%-5s %5lu ops %8.1f ops/s %7.3f MB/s  p50 %6lu  p90 %6lu  p99 %6lu  "
+           "max %6lu us\n",
+           name, (unsigned long)h->count, h->count / secs,
+           (double)h->count * blocks * BLOCK_SIZE / secs / 1E6,
+           (unsigned long)hist_percentile(h, 50),
+           (unsigned long)hist_percentile(h, 90),
+           (unsigned long)hist_percentile(h, 99), (unsigned long)h->max);
+    // One line per power of two that has samples
+    for (unsigned g = 0; g < HIST_BUCKETS / HIST_SUB; ++g) {
+        uint32_t n = 0;
+        for (unsigned i = g * HIST_SUB; i < (g + 1) * HIST_SUB; ++i)
+            n += h->bucket[i];
+        if (!n) continue;
+        unsigned bar = (n * 40 + h->count - 1) / h->count;
+        printf("  %8lu..%-8lu us %6lu ", (unsigned long)(g ? hist_upper(g * HIST_SUB - 1) + 1 : 0),
+               (unsigned long)hist_upper((g + 1) * HIST_SUB - 1), (unsigned long)n);
+        while (bar--) putchar('#');
+        putchar('\n');
+    }
+}
+
+static void print_breakdown(const sd_card_stats_t *s, uint64_t elapsed_us) {
+    double total = elapsed_us ? (double)elapsed_us : 1;
+    uint64_t waits = s->busy_us + s->token_us;
+    uint64_t bus = elapsed_us > waits ? elapsed_us - waits : 0;
+    printf("time: %llu us total\n", (unsigned long long)elapsed_us);
+    printf("  card busy     %9llu us %5.1f%%  (%lu waits, max %lu us)\n",
+           (unsigned long long)s->busy_us, 100 * s->busy_us / total,
+           (unsigned long)s->busy_waits, (unsigned long)s->busy_max_us);
+    printf("  read access   %9llu us %5.1f%%  (%lu waits, max %lu us)\n",
+           (unsigned long long)s->token_us, 100 * s->token_us / total,
+           (unsigned long)s->token_waits, (unsigned long)s->token_max_us);
+    printf("  commands+data %9llu us %5.1f%%\n", (unsigned long long)bus,
+           100 * bus / total);
+}
+
+bool block_bench_run(sd_card_t *pSD, const block_bench_params_t *params) {
+    block_bench_params_t p = *params;
+    if (!p.ops || !p.blocks || p.blocks > BLOCK_BENCH_MAX_BLOCKS ||
+        p.write_pct > 100) {
+        printf("block_bench: need ops > 0, 1..%d blocks, write%% 0..100\n",
+               BLOCK_BENCH_MAX_BLOCKS);
+        return false;
+    }
+    if ((pSD->m_Status & STA_NOINIT) && (pSD->init(pSD) & STA_NOINIT)) {
+        printf("block_bench: %s not initialized\n", pSD->pcName);
+        return false;
+    }
+    if (p.first_lba >= pSD->sectors) {
+        printf("block_bench: first LBA beyond the card\n");
+        return false;
+    }
+    uint64_t avail = pSD->sectors - p.first_lba;
+    if (!p.region_blocks || p.region_blocks > avail) p.region_blocks = avail;
+    uint32_t slots = p.region_blocks / p.blocks;
+    if (!slots) {
+        printf("block_bench: region smaller than one transfer\n");
+        return false;
+    }
+
+    uint8_t *buf = malloc(p.blocks * BLOCK_SIZE);
+    if (!buf) return false;
+    for (size_t i = 0; i < p.blocks * BLOCK_SIZE; ++i) buf[i] = i * 7 + 1;
+
+    memset(&hist_read, 0, sizeof hist_read);
+    memset(&hist_write, 0, sizeof hist_write);
+    memset(&pSD->stats, 0, sizeof pSD->stats);
+    rng_state = p.seed ? p.seed : 1;
+
+    printf("block_bench on %s: %lu x %lu blocks, %s, %lu%% writes, "
+           "LBA %llu..%llu, QD1\n",
+           pSD->pcName, (unsigned long)p.ops, (unsigned long)p.blocks,
+           p.random ? "random" : "sequential", (unsigned long)p.write_pct,
+           (unsigned long long)p.first_lba,
+           (unsigned long long)(p.first_lba + p.region_blocks - 1));
+
+    bool ok = true;
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; ok && i < p.ops; ++i) {
+        uint32_t slot = p.random ? rng_next() % slots : i % slots;
+        uint64_t lba = p.first_lba + (uint64_t)slot * p.blocks;
+        bool write = rng_next() % 100 < p.write_pct;
+        uint64_t t = time_us_64();
+        int rc = write ? pSD->write_blocks(pSD, buf, lba, p.blocks)
+                       : pSD->read_blocks(pSD, buf, lba, p.blocks);
+        hist_add(write ? &hist_write : &hist_read, time_us_64() - t);
+        if (rc) {
+            printf("block_bench: %s of LBA %llu failed: %d\n",
+                   write ? "write" : "read", (unsigned long long)lba, rc);
+            ok = false;
+        }
+    }
+    uint64_t elapsed = time_us_64() - start;
+    free(buf);
+
+    hist_print("read", &hist_read, p.blocks);
+    hist_print("write", &hist_write, p.blocks);
+    print_breakdown(&pSD->stats, elapsed);
+    return ok;
+}
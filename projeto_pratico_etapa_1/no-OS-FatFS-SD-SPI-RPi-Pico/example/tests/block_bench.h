@@ -0,0 +1,38 @@
+/* block_bench.h
+Raw block-layer benchmark: drives sd_read_blocks()/sd_write_blocks() directly
+and reports a latency histogram plus where the time went (card busy, read
+access time, bus). Shared by the "block_bench" console command and the host
+build.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+//
+#include "sd_card.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOCK_BENCH_MAX_BLOCKS 64
+
+typedef struct {
+    uint32_t ops;            // Transfers to time
+    uint32_t blocks;         // Sectors per transfer, 1..BLOCK_BENCH_MAX_BLOCKS
+    uint32_t write_pct;      // Share of writes: 0 = read only, 100 = write only
+    bool random;             // Random block-aligned LBAs instead of sequential
+    uint64_t first_lba;      // Start of the region under test
+    uint32_t region_blocks;  // Size of that region; 0 = up to the end of the card
+    uint32_t seed;           // For the LBA and read/write choices
+} block_bench_params_t;
+
+void block_bench_default_params(block_bench_params_t *params);
+
+// Writes destroy whatever is stored in the region: unmount the card first.
+bool block_bench_run(sd_card_t *pSD, const block_bench_params_t *params);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,278 @@
+/* fs_bench.c
+FatFs-level throughput benchmark for the data logging workload.
+
+big_file_test.c only covers large sequential transfers. The logger does the
+opposite: tens of bytes per record, synced or reopened for every record. Each
+case below times one operation at a time and reports ops/s, MB/s and the
+p50/p99/max latency, so configurations (cluster size, SPI clock, sync policy)
+can be compared with numbers.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+//
+#include "hardware/spi.h"
+#include "pico/stdlib.h"
+//
+#include "ff.h"
+//
+#include "f_util.h"
+#include "fs_bench.h"
+
+#define BIG_CHUNK 4096
+
+static uint32_t lat_us[FS_BENCH_MAX_OPS];
+static char path[64];
+
+void fs_bench_default_params(fs_bench_params_t *params) {
+    params->ops = 100;
+    params->record_size = 64;
+    params->unlink_size = 1024 * 1024;
+    params->au_size = 0;
+    params->baud = 0;
+}
+
+static const char *bench_path(sd_card_t *pSD, const char *name) {
+    snprintf(path, sizeof path, "%s/fs_bench%s%s", pSD->pcName, name ? "/" : "",
+             name ? name : "");
+    return path;
+}
+
+static bool check(FRESULT fr, const char *what) {
+    if (FR_OK == fr) return true;
+    printf("%s error: %s (%d)\n", what, FRESULT_str(fr), fr);
+    return false;
+}
+
+static bool write_record(FIL *fil, const uint8_t *record, uint32_t size) {
+    UINT bw;
+    FRESULT fr = f_write(fil, record, size, &bw);
+    if (FR_OK == fr && bw < size) fr = FR_DENIED;  // Volume full
+    return check(fr, "f_write");
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile over the sorted samples
+static uint32_t percentile(uint32_t n, unsigned pct) {
+    uint32_t rank = (n * pct + 99) / 100;
+    return lat_us[rank ? rank - 1 : 0];
+}
+
+static void report(const char *name, uint32_t n, uint64_t bytes,
+                   uint64_t total_us) {
+    qsort(lat_us, n, sizeof lat_us[0], cmp_u32);
+    double secs = total_us ? total_us / 1E6 : 1E-6;
+    printf("%-18s %5lu ops %9.1f ops/s %8.3f MB/s  p50 %7lu us  p99 %7lu us  "
+           "max %7lu us\n",
+           name, (unsigned long)n, n / secs, bytes / secs / 1E6,
+           (unsigned long)percentile(n, 50), (unsigned long)percentile(n, 99),
+           (unsigned long)lat_us[n - 1]);
+}
+
+// One growing file, one f_write per record; optionally f_sync after each
+static bool bench_append(sd_card_t *pSD, const fs_bench_params_t *p,
+                         const uint8_t *record, bool sync) {
+    FIL fil;
+    if (!check(f_open(&fil, bench_path(pSD, "append.log"),
+                      FA_WRITE | FA_CREATE_ALWAYS),
+               "f_open"))
+        return false;
+    bool ok = true;
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; ok && i < p->ops; ++i) {
+        uint64_t t = time_us_64();
+        ok = write_record(&fil, record, p->record_size) &&
+             (!sync || check(f_sync(&fil), "f_sync"));
+        lat_us[i] = time_us_64() - t;
+    }
+    ok = check(f_close(&fil), "f_close") && ok;
+    if (ok)
+        report(sync ? "append+sync" : "append", p->ops,
+               (uint64_t)p->ops * p->record_size, time_us_64() - start);
+    return ok;
+}
+
+// What Sdh_LogBoarding() does: open for append, write, close, every record
+static bool bench_open_append_close(sd_card_t *pSD, const fs_bench_params_t *p,
+                                    const uint8_t *record) {
+    f_unlink(bench_path(pSD, "oac.log"));
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < p->ops; ++i) {
+        FIL fil;
+        uint64_t t = time_us_64();
+        if (!check(f_open(&fil, bench_path(pSD, "oac.log"),
+                          FA_WRITE | FA_OPEN_APPEND),
+                   "f_open"))
+            return false;
+        bool ok = write_record(&fil, record, p->record_size);
+        if (!check(f_close(&fil), "f_close") || !ok) return false;
+        lat_us[i] = time_us_64() - t;
+    }
+    report("open+append+close", p->ops, (uint64_t)p->ops * p->record_size,
+           time_us_64() - start);
+    return true;
+}
+
+// Same synced appends, but the clusters are allocated up front by seeking
+// past the end (FF_USE_EXPAND is off), so no FAT update per new cluster.
+static bool bench_prealloc(sd_card_t *pSD, const fs_bench_params_t *p,
+                           const uint8_t *record) {
+    FIL fil;
+    FSIZE_t size = (FSIZE_t)p->ops * p->record_size;
+    if (!check(f_open(&fil, bench_path(pSD, "prealloc.log"),
+                      FA_WRITE | FA_CREATE_ALWAYS),
+               "f_open"))
+        return false;
+    FRESULT fr = f_lseek(&fil, size);
+    if (FR_OK == fr && f_tell(&fil) != size) fr = FR_DENIED;  // Volume full
+    if (FR_OK == fr) fr = f_lseek(&fil, 0);
+    if (FR_OK == fr) fr = f_sync(&fil);
+    if (!check(fr, "preallocate")) {
+        f_close(&fil);
+        return false;
+    }
+    bool ok = true;
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; ok && i < p->ops; ++i) {
+        uint64_t t = time_us_64();
+        ok = write_record(&fil, record, p->record_size) &&
+             check(f_sync(&fil), "f_sync");
+        lat_us[i] = time_us_64() - t;
+    }
+    ok = check(f_close(&fil), "f_close") && ok;
+    if (ok) report("prealloc+sync", p->ops, size, time_us_64() - start);
+    return ok;
+}
+
+// One file per record, then the cost of deleting them one by one
+static bool bench_small_files(sd_card_t *pSD, const fs_bench_params_t *p,
+                              const uint8_t *record) {
+    char name[16];
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < p->ops; ++i) {
+        FIL fil;
+        snprintf(name, sizeof name, "f%04lu.log", (unsigned long)i);
+        uint64_t t = time_us_64();
+        if (!check(f_open(&fil, bench_path(pSD, name),
+                          FA_WRITE | FA_CREATE_ALWAYS),
+                   "f_open"))
+            return false;
+        bool ok = write_record(&fil, record, p->record_size);
+        if (!check(f_close(&fil), "f_close") || !ok) return false;
+        lat_us[i] = time_us_64() - t;
+    }
+    report("small files", p->ops, (uint64_t)p->ops * p->record_size,
+           time_us_64() - start);
+
+    start = time_us_64();
+    for (uint32_t i = 0; i < p->ops; ++i) {
+        snprintf(name, sizeof name, "f%04lu.log", (unsigned long)i);
+        uint64_t t = time_us_64();
+        if (!check(f_unlink(bench_path(pSD, name)), "f_unlink")) return false;
+        lat_us[i] = time_us_64() - t;
+    }
+    report("unlink small", p->ops, 0, time_us_64() - start);
+    return true;
+}
+
+// Open and close an existing file without touching its data
+static bool bench_open_close(sd_card_t *pSD, const fs_bench_params_t *p) {
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < p->ops; ++i) {
+        FIL fil;
+        uint64_t t = time_us_64();
+        if (!check(f_open(&fil, bench_path(pSD, "append.log"), FA_READ),
+                   "f_open"))
+            return false;
+        if (!check(f_close(&fil), "f_close")) return false;
+        lat_us[i] = time_us_64() - t;
+    }
+    report("open+close", p->ops, 0, time_us_64() - start);
+    return true;
+}
+
+// Removing a large file walks and clears its whole cluster chain
+static bool bench_unlink_big(sd_card_t *pSD, const fs_bench_params_t *p) {
+    uint8_t *chunk = malloc(BIG_CHUNK);
+    if (!chunk) return false;
+    memset(chunk, 0xA5, BIG_CHUNK);
+    FIL fil;
+    bool ok = check(f_open(&fil, bench_path(pSD, "big.bin"),
+                           FA_WRITE | FA_CREATE_ALWAYS),
+                    "f_open");
+    for (uint32_t done = 0; ok && done < p->unlink_size; done += BIG_CHUNK) {
+        uint32_t n = p->unlink_size - done;
+        ok = write_record(&fil, chunk, n < BIG_CHUNK ? n : BIG_CHUNK);
+    }
+    free(chunk);
+    if (!check(f_close(&fil), "f_close") || !ok) return false;
+
+    uint64_t t = time_us_64();
+    if (!check(f_unlink(bench_path(pSD, "big.bin")), "f_unlink")) return false;
+    lat_us[0] = time_us_64() - t;
+    report("unlink big", 1, 0, lat_us[0]);
+    return true;
+}
+
+static bool reformat(sd_card_t *pSD, uint32_t au_size) {
+    static BYTE work[FF_MAX_SS * 4];
+    MKFS_PARM opt = {FM_ANY, 0, 0, 0, au_size};
+    f_unmount(pSD->pcName);
+    pSD->mounted = false;
+    if (!check(f_mkfs(pSD->pcName, &opt, work, sizeof work), "f_mkfs"))
+        return false;
+    if (!check(f_mount(&pSD->fatfs, pSD->pcName, 1), "f_mount")) return false;
+    pSD->mounted = true;
+    return true;
+}
+
+bool fs_bench_run(sd_card_t *pSD, const fs_bench_params_t *params) {
+    fs_bench_params_t p = *params;
+    if (!p.ops || p.ops > FS_BENCH_MAX_OPS || !p.record_size) {
+        printf("fs_bench: ops must be 1..%d and record size > 0\n",
+               FS_BENCH_MAX_OPS);
+        return false;
+    }
+    if (p.au_size && !reformat(pSD, p.au_size)) return false;
+    if (p.baud) {
+        pSD->spi->baud_rate = p.baud;
+        spi_set_baudrate(pSD->spi->hw_inst, p.baud);
+    }
+
+    uint8_t *record = malloc(p.record_size);
+    if (!record) return false;
+    for (uint32_t i = 0; i < p.record_size; ++i)
+        record[i] = i + 1 == p.record_size ? '\n' : 'A' + i % 26;
+
+    FRESULT fr = f_mkdir(bench_path(pSD, NULL));
+    if (FR_EXIST != fr && !check(fr, "f_mkdir")) {
+        free(record);
+        return false;
+    }
+    printf("fs_bench on %s: FAT type %d, cluster %lu bytes, SPI %lu Hz, "
+           "record %lu bytes\n",
+           pSD->pcName, pSD->fatfs.fs_type,
+           (unsigned long)pSD->fatfs.csize * FF_MAX_SS,
+           (unsigned long)spi_get_baudrate(pSD->spi->hw_inst),
+           (unsigned long)p.record_size);
+
+    bool ok = bench_append(pSD, &p, record, false) &&
+              bench_append(pSD, &p, record, true) &&
+              bench_open_append_close(pSD, &p, record) &&
+              bench_prealloc(pSD, &p, record) &&
+              bench_small_files(pSD, &p, record) &&
+              bench_open_close(pSD, &p) && bench_unlink_big(pSD, &p);
+    free(record);
+
+    static const char *const leftovers[] = {"append.log", "oac.log",
+                                            "prealloc.log"};
+    for (size_t i = 0; i < count_of(leftovers); ++i)
+        f_unlink(bench_path(pSD, leftovers[i]));
+    f_unlink(bench_path(pSD, NULL));
+    return ok;
+}
@@ -0,0 +1,37 @@
+/* fs_bench.h
+FatFs-level throughput benchmark modelled on the data logging workload:
+small appends, preallocated vs growing files, many small files, open/close
+and unlink cost. Shared by the "fs_bench" console command and the host build.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+//
+#include "sd_card.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Upper bound on operations per case (one latency sample is kept per op)
+#define FS_BENCH_MAX_OPS 512
+
+typedef struct {
+    uint32_t ops;          // Operations per case (<= FS_BENCH_MAX_OPS)
+    uint32_t record_size;  // Bytes per append; one log line is ~64
+    uint32_t unlink_size;  // Size of the file removed by the unlink case
+    uint32_t au_size;      // Reformat with this cluster size first; 0 = keep
+    uint32_t baud;         // SPI clock for the run; 0 = keep
+} fs_bench_params_t;
+
+void fs_bench_default_params(fs_bench_params_t *params);
+
+// Runs every case in <drive>/fs_bench and removes the files afterwards.
+// The card must be mounted unless params->au_size asks for a reformat.
+bool fs_bench_run(sd_card_t *pSD, const fs_bench_params_t *params);
+
+#ifdef __cplusplus
+}
+#endif
@@ -20,12 +20,18 @@
 
 // Bibliotecas do SD Card
 #include "inc/sd_card/sd_card_handler.h" 
+#include "inc/sd_card/roster.h"
+#include "inc/sd_card/uid_filter.h"
 #include "inc/spi_manager.h"
 #include "hw_config.h" 
 
 // Bibliotecas do RFID
 #include "inc/rfid/mfrc522.h"
 #include "inc/rfid/tag_data_handler.h"
+#include "inc/rfid/card_detect.h"
+#include "inc/rfid/rfid_tuning.h"
+#include "inc/rfid/recent_taps.h"
+#include "inc/rfid/provisioning.h"
 
 // WiFi e MQTT necessários
 #include "conexao.h"
@@ -37,6 +43,11 @@
 #include "setup_oled.h"
 #include "display.h"
 
+#if USB_MSC_EXPORT
+#include "tusb.h"
+#include "inc/usb_msc/usb_msc.h"
+#endif
+
 // Declaração da função que rodará no Núcleo 1
 extern void inicia_core1();
 
@@ -50,7 +61,9 @@ typedef enum {
     SYSTEM_MODE_SD_READ_SEND = 1,    // Ler SD e enviar via WiFi
     SYSTEM_MODE_SD_CLEANUP = 2,      // Limpar dados enviados do SD
     SYSTEM_MODE_NORMAL_WIFI = 3,     // Modo WiFi temporário para envio
-    SYSTEM_MODE_POST_SEND = 4        // Após envio, voltar ao RFID
+    SYSTEM_MODE_POST_SEND = 4,       // Após envio, voltar ao RFID
+    SYSTEM_MODE_USB_EXPORT = 5,      // Manutenção: cartão SD exportado como pendrive
+    SYSTEM_MODE_PROVISION = 6        // Manutenção: gravação dos cartões em lote
 } system_mode_t;
 
 // Endereço na RAM que sobrevive ao reset (região não inicializada)
@@ -60,6 +73,11 @@ volatile uint32_t *persistent_counter = (volatile uint32_t *)(PERSISTENT_STATE_A
 volatile uint32_t *persistent_magic = (volatile uint32_t *)(PERSISTENT_STATE_ADDR + 8);
 volatile uint32_t *wifi_retry_count = (volatile uint32_t *)(PERSISTENT_STATE_ADDR + 12);
 #define MAGIC_VALUE 0xDEADBEEF  // Valor mágico para verificar se os dados são válidos
+// Embarques recentes, logo depois do estado acima: sobrevivem ao reset entre
+// o modo RFID e o envio. Acaba antes da pilha do core 1 (0x20040800)
+rtp_table_t *recent_taps = (rtp_table_t *)(PERSISTENT_STATE_ADDR + 16);
+_Static_assert(PERSISTENT_STATE_ADDR + 16 + sizeof(rtp_table_t) <= 0x20040800,
+               "tabela de embarques recentes invade a pilha do core 1");
 
 // Tempos de operação
 #define WATCHDOG_TIMEOUT_MS 8000   // 8 segundos para reset automático
@@ -67,6 +85,51 @@ volatile uint32_t *wifi_retry_count = (volatile uint32_t *)(PERSISTENT_STATE_ADD
 #define WIFI_OPERATION_TIME_MS 180000 // 3 minutos para operações WiFi (mais tempo)
 #define RFID_SD_OPERATION_TIME_MS 45000 // 45 segundos para operações RFID+SD
 #define MAX_WIFI_RETRY_CYCLES 3    // Máximo de ciclos de retry antes de voltar ao RFID
+#define RFID_MAX_CARDS_PER_TAP 4   // Cartões tratados num mesmo inventário
+#define RFID_RECORD_BLOCK 4        // Bloco do registro do aluno (Classic)
+
+// --- Leitores RFID (portas do ônibus) ---
+// A porta dianteira usa os pinos de mfrc522.h. A traseira divide SCK/MOSI/MISO
+// do SPI0 e tem CS e IRQ próprios; sem RST ligado, só o soft reset
+#ifndef RFID_READER_COUNT
+#define RFID_READER_COUNT 1
+#endif
+#if RFID_READER_COUNT < 1 || RFID_READER_COUNT > MFRC_MAX_INSTANCES
+#error "RFID_READER_COUNT deve ficar entre 1 e MFRC_MAX_INSTANCES"
+#endif
+#ifndef RFID2_CS_PIN
+#define RFID2_CS_PIN 8
+#endif
+#ifndef RFID2_RST_PIN
+#define RFID2_RST_PIN MFRC522_NO_PIN
+#endif
+#ifndef RFID2_IRQ_PIN
+#define RFID2_IRQ_PIN 9
+#endif
+#define RFID_DOOR_QUEUE_LEN 4      // Embarques por porta à espera do SD
+#define RFID_RECORD_LEN 160        // Campo RFID_DATA de um registro
+// Rota do ônibus: vai nos registros e escolhe o filtro de UIDs (uid_filter.h)
+#ifndef RFID_ROUTE_ID
+#define RFID_ROUTE_ID 1
+#endif
+// Cartão que volta dentro da janela não é lido de novo nem gera registro.
+// Ajuste por rota: paradas próximas pedem uma janela menor. 0 desliga
+#ifndef RFID_DUP_WINDOW_MS
+#define RFID_DUP_WINDOW_MS RTP_WINDOW_MS
+#endif
+// 1: UID que está no cadastro do SD (roster.bin) embarca só pelo UID do
+// inventário, sem autenticar nem ler o cartão: uma leitura de setor no SD no
+// lugar do Crypto1. O contador de viagens no cartão deixa de ser atualizado
+#ifndef RFID_UID_ONLY_BOARDING
+#define RFID_UID_ONLY_BOARDING 0
+#endif
+
+// --- Provisionamento em lote ---
+#define PROVISION_CSV_FILE "alunos.csv"    // Entrada: "uid_hex,id,nome" por linha
+#define PROVISION_LOG_FILE "provisao.csv"  // Saída no mesmo formato, pronta para o cadastro
+#define PROVISION_LOG_BATCH 16             // Resultados por troca do SPI0 para o SD
+#define PROVISION_LOG_LEN 96
+#define PROVISION_IDLE_TIMEOUT_MS (10 * 60 * 1000)  // Sem cartões: volta ao RFID
 
 // Declarações das funções
 void init_persistent_state(void);
@@ -78,6 +141,8 @@ bool execute_sd_cleanup_mode(void);
 bool save_rfid_data_to_sd(const char* rfid_data);
 bool read_and_send_sd_data(void);
 void execute_rfid_sd_mode_new(void);
+void execute_usb_export_mode(void);
+void execute_provision_mode(void);
 void on_mqtt_send_complete(void);
 bool mark_send_success_in_sd(void);
 bool check_pending_data_in_sd(void);
@@ -207,6 +272,43 @@ void setup_leds_and_oled(void) {
     printf("[UI] LEDs e OLED configurados!\n");
 }
 
+// Núcleo 1 no ar (modos WiFi): o printf dele já chama tud_task() dentro do
+// mutex do stdio_usb, e uma chamada solta do núcleo 0 correria com ela
+static bool usb_core1_ativo = false;
+
+#if USB_MSC_EXPORT
+/**
+ * @brief Atende o USB (console CDC e pedidos de controle do PC).
+ *
+ * O TinyUSB da aplicação roda sem tarefa de fundo e o stdio só chama
+ * tud_task() quando já há byte na FIFO do CDC: sem esta chamada nos laços
+ * de cada modo, as teclas do console nunca chegam.
+ */
+static inline void usb_poll(void) {
+    if (!usb_core1_ativo) {
+        tud_task();
+    }
+}
+
+/**
+ * @brief sleep_ms() que continua atendendo o USB.
+ */
+static void usb_sleep_ms(uint32_t ms) {
+    if (usb_core1_ativo) {
+        sleep_ms(ms);
+        return;
+    }
+    absolute_time_t fim = make_timeout_time_ms(ms);
+    do {
+        tud_task();
+        sleep_ms(1);
+    } while (absolute_time_diff_us(get_absolute_time(), fim) > 0);
+}
+#else
+static inline void usb_poll(void) {}
+static inline void usb_sleep_ms(uint32_t ms) { sleep_ms(ms); }
+#endif
+
 /**
  * @brief Mostra mensagem no OLED com controle de LED
  */
@@ -234,7 +336,7 @@ void display_message_with_led(const char* line1, const char* line2, int led_pin,
         oled_clear(buffer_oled, &area);
         ssd1306_draw_utf8_multiline(buffer_oled, 0, 0, combined_message);
         render_on_display(buffer_oled, &area);
-        sleep_ms(delay_ms);
+        usb_sleep_ms(delay_ms);
         oled_clear(buffer_oled, &area);
         render_on_display(buffer_oled, &area);
     } else {
@@ -271,6 +373,18 @@ void set_system_status_leds(int mode) {
             gpio_put(LED_RFID, 1);
             gpio_put(LED_WIFI, 1);
             break;
+
+        case SYSTEM_MODE_USB_EXPORT:
+            // LED Azul e Vermelho - cartão em uso pelo PC, não desconectar
+            gpio_put(LED_WIFI, 1);
+            gpio_put(LED_ERROR, 1);
+            break;
+
+        case SYSTEM_MODE_PROVISION:
+            // LED Verde e Vermelho - gravando cartões
+            gpio_put(LED_RFID, 1);
+            gpio_put(LED_ERROR, 1);
+            break;
             
         default:
             // LED Vermelho - erro ou estado desconhecido
@@ -368,8 +482,8 @@ bool save_rfid_data_to_sd(const char* rfid_data) {
     uint32_t seconds = (timestamp / 1000) % 60;
     
     snprintf(data_entry, sizeof(data_entry), 
-             "TIMESTAMP:%llu,CYCLE:%lu,RFID_DATA:%s,STATUS:PENDING,ROUTE:1,TIME:%02lu:%02lu:%02lu\n",
-             timestamp, *persistent_counter, rfid_data, hours, minutes, seconds);
+             "TIMESTAMP:%llu,CYCLE:%lu,RFID_DATA:%s,STATUS:PENDING,ROUTE:%u,TIME:%02lu:%02lu:%02lu\n",
+             timestamp, *persistent_counter, rfid_data, RFID_ROUTE_ID, hours, minutes, seconds);
     
     // Escreve dados
     UINT bytes_written = 0;
@@ -721,8 +835,22 @@ bool increment_wifi_retry(void) {
 // FUNÇÃO MAIN DO NÚCLEO 0 - SISTEMA DE ESTADOS COM WATCHDOG
 // =================================================================================
 int main() {
+    // RST dos leitores RFID em nível alto já no boot, em qualquer modo: solto,
+    // o pull-down do pad desliga o MFRC522 e apaga os registros que a
+    // partida quente (PCD_WarmInit) reaproveita
+    PCD_HoldOutOfReset(RESET_PIN);
+#if RFID_READER_COUNT > 1
+    PCD_HoldOutOfReset(RFID2_RST_PIN);
+#endif
     stdio_init_all();
-    while (!stdio_usb_connected()) { sleep_ms(100); }
+    while (!stdio_usb_connected()) {
+#if USB_MSC_EXPORT
+        // TinyUSB da aplicação, sem tarefa de fundo: a enumeração anda aqui
+        usb_sleep_ms(1);
+#else
+        sleep_ms(100);
+#endif
+    }
     printf("\n[CORE 0] === INICIANDO SISTEMA COM ESTADOS PERSISTENTES E SINALIZACAO ===\n");
     
     // --- INICIALIZAÇÃO DO MUTEX ---
@@ -758,6 +886,7 @@ int main() {
                 // Inicia Core 1 para envio MQTT
                 printf("[MAIN] Iniciando Core 1 para envio MQTT (tentativa %lu)...\n", *wifi_retry_count);
                 display_message_with_led("WiFi Ativo", "Enviando MQTT...", LED_WIFI, true, 1000);
+                usb_core1_ativo = true;
                 inicia_core1();
                 
                 // Loop aguardando conclusão do envio com watchdog mais longo
@@ -828,6 +957,7 @@ int main() {
             printf("[MAIN] WiFi ativado (tentativa %lu). Iniciando Core 1...\n", *wifi_retry_count);
             display_message_with_led("Ativando WiFi", "Conectando...", LED_WIFI, true, 1000);
             
+            usb_core1_ativo = true;
             inicia_core1();
             printf("[MAIN] Core 1 iniciado. Aguardando envio MQTT...\n");
             
@@ -873,14 +1003,239 @@ int main() {
             set_next_mode(SYSTEM_MODE_RFID_SD);
             trigger_watchdog_reset();
             break;
+
+#if USB_MSC_EXPORT
+        case SYSTEM_MODE_USB_EXPORT:
+            printf("[MAIN] === MODO: MANUTENÇÃO - SD VIA USB ===\n");
+            execute_usb_export_mode();
+            // Função não retorna - reset via watchdog
+            break;
+#endif
+
+        case SYSTEM_MODE_PROVISION:
+            printf("[MAIN] === MODO: MANUTENÇÃO - PROVISIONAMENTO ===\n");
+            execute_provision_mode();
+            // Função não retorna - reset via watchdog
+            break;
     }
     
     return 0;
 }
 
+// Uma porta: o leitor e os embarques lidos nela que ainda não foram para o
+// SD. As filas das portas vão para o mesmo diário (rfid_queue.txt)
+typedef struct {
+    const char *nome;
+    uint cs, rst, irq;          // Porta 0: pinos padrão de mfrc522.h
+    MFRC522Ptr_t mfrc;          // NULL: leitor ausente
+    char fila[RFID_DOOR_QUEUE_LEN][RFID_RECORD_LEN];
+    uint8_t n_fila;
+} rfid_door_t;
+
+static rfid_door_t portas[RFID_READER_COUNT] = {
+    {.nome = "dianteira"},
+#if RFID_READER_COUNT > 1
+    {.nome = "traseira", .cs = RFID2_CS_PIN, .rst = RFID2_RST_PIN, .irq = RFID2_IRQ_PIN},
+#endif
+};
+
+static rfid_door_t *door_of(MFRC522Ptr_t mfrc) {
+    for (uint8_t p = 0; p < RFID_READER_COUNT; p++) {
+        if (portas[p].mfrc == mfrc) return &portas[p];
+    }
+    return &portas[0];
+}
+
+static bool door_queues_pending(void) {
+    for (uint8_t p = 0; p < RFID_READER_COUNT; p++) {
+        if (portas[p].n_fila) return true;
+    }
+    return false;
+}
+
 /**
- * @brief Executa modo RFID + SD - nova implementação simplificada
+ * @brief Grava no SD os embarques de todas as portas numa única troca do
+ * SPI0 para o cartão. O que não for gravado fica na fila para a próxima.
+ * @return Quantos registros foram salvos.
  */
+static uint32_t drain_door_queues(void) {
+    if (!door_queues_pending()) return 0;
+
+    spi_manager_activate_sd();
+    uint32_t salvos = 0;
+    bool falhou = false;
+    if (!Sdh_Init()) {
+        printf("[RFID] ERRO: Falha ao inicializar SD Card\n");
+        falhou = true;
+    }
+    for (uint8_t p = 0; p < RFID_READER_COUNT && !falhou; p++) {
+        rfid_door_t *porta = &portas[p];
+        uint8_t i = 0;
+        while (i < porta->n_fila && save_rfid_data_to_sd(porta->fila[i])) {
+            i++;
+        }
+        if (i < porta->n_fila) {
+            printf("[RFID] Erro ao salvar dados no SD (porta %s)\n", porta->nome);
+            falhou = true;
+        }
+        memmove(porta->fila[0], porta->fila[i], (size_t)(porta->n_fila - i) * RFID_RECORD_LEN);
+        porta->n_fila -= i;
+        salvos += i;
+    }
+    spi_manager_activate_rfid();
+
+    if (falhou) {
+        display_message_with_led("ERRO SD!", "Falha ao salvar", LED_ERROR, true, 0);
+    } else {
+        printf("[RFID] %lu embarque(s) salvos no SD\n", salvos);
+    }
+    return salvos;
+}
+
+/**
+ * @brief Procura o UID no cadastro do SD. Com o leitor e o SD no mesmo SPI0,
+ * o barramento vai para o SD só durante a leitura do setor.
+ */
+static ros_result_t lookup_roster(const Uid *uid, roster_record_t *aluno) {
+    if (!Ros_IsOpen()) return ROS_ABSENT;
+    spi_manager_activate_sd();
+    ros_result_t r = Ros_Lookup(uid->uidByte, uid->size, aluno);
+    spi_manager_activate_rfid();
+    return r;
+}
+
+/**
+ * @brief Põe o registro na fila da porta; cheia, grava as filas no SD antes.
+ * @return false se a fila continuou cheia (SD com falha).
+ */
+static bool enqueue_record(rfid_door_t *porta, const char *registro) {
+    if (porta->n_fila == RFID_DOOR_QUEUE_LEN) {
+        drain_door_queues();
+    }
+    if (porta->n_fila == RFID_DOOR_QUEUE_LEN) {
+        printf("[RFID] ERRO: Fila da porta %s cheia, embarque perdido\n", porta->nome);
+        return false;
+    }
+    memcpy(porta->fila[porta->n_fila++], registro, RFID_RECORD_LEN);
+    return true;
+}
+
+/**
+ * @brief Embarque de um aluno identificado pelo cadastro do SD, sem os dados
+ * do cartão (não há contador de viagens). As rotas do cadastro valem como
+ * as do cartão v4.
+ */
+static bool board_from_roster(rfid_door_t *porta, const roster_record_t *aluno) {
+    char registro[RFID_RECORD_LEN];
+    unsigned num_porta = (unsigned)(porta - portas) + 1;
+    if (!Ros_RouteAllowed(aluno, RFID_ROUTE_ID)) {
+        printf("[RFID] Porta %s: %s nao tem a rota %u no cadastro.\n", porta->nome,
+               aluno->student_name, RFID_ROUTE_ID);
+        display_message_with_led("Acesso negado", "Fora da rota", LED_ERROR, true, 0);
+        return false;
+    }
+    printf("[RFID] Porta %s: %s (ID %lu) pelo cadastro\n", porta->nome, aluno->student_name,
+           (unsigned long)aluno->student_id);
+    display_message_with_led("Estudante:", aluno->student_name, LED_RFID, true, 0);
+    snprintf(registro, sizeof(registro), "NAME:%s,ID:%lu,ROUTE:%u,DOOR:%u,SOURCE:ROSTER",
+             aluno->student_name, (unsigned long)aluno->student_id, RFID_ROUTE_ID, num_porta);
+    return enqueue_record(porta, registro);
+}
+
+/**
+ * @brief Decisão imediata pelo UID do inventário, antes de ler o cartão.
+ * Negativo do filtro da rota barra na hora; positivo é confirmado no
+ * cadastro da escola, quando houver: aluno encontrado (em aluno) embarca só
+ * se RFID_ROUTE_ID estiver nas rotas dele. UID fora do cadastro (cartão
+ * gravado depois dele) ou SD em falha: os dados do cartão decidem.
+ * @return false se o cartão não é desta rota.
+ */
+static bool route_gate(rfid_door_t *porta, const Uid *uid, roster_record_t *aluno, bool *no_cadastro) {
+    *no_cadastro = false;
+    if (!Ufl_IsLoaded()) return true;
+    bool autorizado = Ufl_MayContain(uid->uidByte, uid->size);
+    if (autorizado && Ros_IsOpen()) {
+        ros_result_t r = lookup_roster(uid, aluno);
+        if (r == ROS_IO_ERROR) {
+            printf("[RFID] Porta %s: cadastro indisponivel, lendo o cartao.\n", porta->nome);
+        } else if (r == ROS_ABSENT) {
+            printf("[RFID] Porta %s: UID fora do cadastro, lendo o cartao.\n", porta->nome);
+        } else {
+            autorizado = *no_cadastro = Ros_RouteAllowed(aluno, RFID_ROUTE_ID);
+        }
+    }
+    if (!autorizado) {
+        printf("[RFID] Porta %s: cartao fora da rota %u.\n", porta->nome, RFID_ROUTE_ID);
+        display_message_with_led("Acesso negado", "Fora da rota", LED_ERROR, true, 0);
+        return false;
+    }
+    display_message_with_led("Acesso liberado", "Lendo cartao...", LED_RFID, true, 0);
+    return true;
+}
+
+/**
+ * @brief Lê o cartão selecionado no leitor da porta e põe o embarque na
+ * fila dela. A mensagem fica no display sem bloquear: a outra porta
+ * continua sendo sondada.
+ * @return false se a fila continuou cheia (SD com falha).
+ */
+static bool process_boarding_card(rfid_door_t *porta) {
+    MFRC522Ptr_t mfrc = porta->mfrc;
+    unsigned num_porta = (unsigned)(porta - portas) + 1;
+    printf("[RFID] Porta %s: cartao detectado! UID: ", porta->nome);
+    for (int i = 0; i < mfrc->uid.size; i++) {
+        printf("%02X", mfrc->uid.uidByte[i]);
+    }
+    printf("\n");
+    
+    // Estrutura para dados de estudante
+    TdhStudentRecord student_data;
+    roster_record_t aluno;
+    char registro[RFID_RECORD_LEN];
+    
+    // Lê, confere, incrementa e regrava o contador de viagens: Classic (v3 ou
+    // v4) numa única autenticação do setor, Ultralight/NTAG sem Crypto1
+    uint16_t crc_antes = mfrc->crc_errors;
+    StatusCode status = Tdh_BoardAnyCard(mfrc, RFID_RECORD_BLOCK, NULL, NULL, RFID_ROUTE_ID,
+                                         &student_data);
+    // Monitor de ganho: a seleção já passou; daqui só conta o CRC_A dos
+    // quadros. Chave estrangeira ou cartão sem registro não são enlace
+    Rft_RecordTap(mfrc, mfrc->crc_errors != crc_antes ? STATUS_CRC_WRONG : STATUS_OK);
+    if (status == STATUS_OK && student_data.route_denied) {
+        printf("[RFID] %s nao tem a rota %u no cartao.\n", student_data.student_name, RFID_ROUTE_ID);
+        display_message_with_led("Acesso negado", "Fora da rota", LED_ERROR, true, 0);
+        return false;
+    }
+    if (status == STATUS_OK) {
+        printf("[RFID] Embarque registrado no cartao (v%u):\n", student_data.version);
+        printf("  ID: %lu\n", (unsigned long)student_data.student_id);
+        printf("  Nome: %s\n", student_data.student_name);
+        printf("  Viagens: %lu\n", (unsigned long)student_data.trip_count);
+        
+        display_message_with_led("Estudante:", student_data.student_name, LED_RFID, true, 0);
+        
+        snprintf(registro, sizeof(registro), "NAME:%s,ID:%lu,TRIPS:%lu,ROUTE:%u,DOOR:%u",
+                 student_data.student_name, 
+                 (unsigned long)student_data.student_id,
+                 (unsigned long)student_data.trip_count,
+                 RFID_ROUTE_ID,
+                 num_porta);
+    } else if (lookup_roster(&mfrc->uid, &aluno) == ROS_FOUND) {
+        printf("[RFID] Cartão sem dados estruturados, aluno encontrado no cadastro.\n");
+        return board_from_roster(porta, &aluno);
+    } else {
+        printf("[RFID] Cartão sem dados estruturados. Registrando UID...\n");
+        display_message_with_led("Cartao vazio", "UID registrado", LED_RFID, true, 0);
+        
+        int n = snprintf(registro, sizeof(registro), "UID:");
+        for (int i = 0; i < mfrc->uid.size; i++) {
+            n += snprintf(registro + n, sizeof(registro) - n, "%02X", mfrc->uid.uidByte[i]);
+        }
+        snprintf(registro + n, sizeof(registro) - n, ",TYPE:UNKNOWN,DOOR:%u", num_porta);
+    }
+    return enqueue_record(porta, registro);
+}
+
 void execute_rfid_sd_mode_new(void) {
     printf("[RFID] === EXECUTANDO MODO RFID + SD (MODO PRINCIPAL) ===\n");
     
@@ -896,16 +1251,33 @@ void execute_rfid_sd_mode_new(void) {
         return;
     }
     
+    // Perfil de RF da última calibração, lido enquanto o SPI0 está com o SD
+    rft_profile_t perfil_rf;
+    if (!Sdh_LoadBlob(RFT_PROFILE_FILE, &perfil_rf, sizeof perfil_rf) ||
+        !Rft_IsValidProfile(&perfil_rf)) {
+        Rft_DefaultProfile(&perfil_rf);
+    }
+    // Cadastro por UID e filtro da rota (opcionais), ambos mantidos na RAM
+    Ros_Open();
+    Ufl_Load(RFID_ROUTE_ID);
+    
     // Configura watchdog para operações RFID/SD
     watchdog_enable(RFID_SD_OPERATION_TIME_MS, 1);
     
-    // Ativa RFID
+    // Ativa RFID (com os CS de todas as portas em nível alto)
     printf("[RFID] Ativando leitor RFID...\n");
     display_message_with_led("Sistema RFID", "Ativando leitor...", LED_RFID, true, 1000);
+    for (uint8_t p = 1; p < RFID_READER_COUNT; p++) {
+        spi_manager_add_rfid_cs(portas[p].cs);
+    }
     spi_manager_activate_rfid();
     
     // Usar as funções RFID já existentes
-    MFRC522Ptr_t mfrc = MFRC522_Init();
+    for (uint8_t p = 0; p < RFID_READER_COUNT; p++) {
+        portas[p].mfrc = p == 0 ? MFRC522_Init()
+                                : MFRC522_InitPins(portas[p].cs, portas[p].rst, portas[p].irq);
+    }
+    MFRC522Ptr_t mfrc = portas[0].mfrc;
     if (!mfrc) {
         printf("[RFID] Erro: Falha ao inicializar leitor RFID\n");
         display_message_with_led("ERRO RFID!", "Falha ao iniciar", LED_ERROR, true, 3000);
@@ -915,14 +1287,41 @@ void execute_rfid_sd_mode_new(void) {
         while(1) tight_loop_contents(); // Aguarda reset
     }
     
-    PCD_Init(mfrc, spi0);
+    // O MFRC522 não reseta junto com o RP2040: se ainda estiver configurado,
+    // só sai do soft power-down em vez de resetar e esperar ~110 ms
+    for (uint8_t p = 0; p < RFID_READER_COUNT; p++) {
+        if (!portas[p].mfrc) continue;
+        uint64_t t_leitor = time_us_64();
+        bool partida_quente = PCD_WarmInit(portas[p].mfrc, spi0);
+        uint8_t versao = PCD_ReadRegister(portas[p].mfrc, VersionReg);
+        // Porta extra sem leitor respondendo: segue só com as outras. A
+        // principal continua, mas o log mostra (ex.: PIO sem state machine)
+        if (versao == 0x00 || versao == 0xFF) {
+            if (p > 0) {
+                printf("[RFID] Porta %s: leitor nao responde, ignorada\n", portas[p].nome);
+                portas[p].mfrc = NULL;
+                continue;
+            }
+            printf("[RFID] Porta %s: leitor nao responde\n", portas[p].nome);
+        }
+        printf("[RFID] Porta %s: leitor pronto em %llu us (%s)\n", portas[p].nome,
+               time_us_64() - t_leitor,
+               partida_quente ? "partida a quente" : "inicializacao completa");
+        // Mesmo perfil de RF em todas as portas; o monitor ajusta cada uma
+        Rft_Apply(portas[p].mfrc, &perfil_rf);
+        if (p == 0) {
+            Cd_Init(portas[p].mfrc, NULL);
+        } else {
+            Cd_AddReader(portas[p].mfrc);
+        }
+    }
+    Rtp_Init(recent_taps, RFID_DUP_WINDOW_MS);
     printf("[RFID] Leitor RFID inicializado. Aguardando tags...\n");
     display_message_with_led("RFID Pronto", "Aproxime cartao...", LED_RFID, true, 0);
     
     // Loop de leitura RFID por tempo limitado
     uint32_t start_time = to_ms_since_boot(get_absolute_time());
     uint32_t tags_lidas = 0;
-    bool tag_processada = false;
     uint32_t last_blink = start_time;
     bool led_state = true;
     
@@ -932,6 +1331,48 @@ void execute_rfid_sd_mode_new(void) {
         // Atualiza watchdog
         watchdog_update();
         
+        // Libera (e desliga, se configurado) o SD entre leituras
+        Sdh_IdleTask();
+        
+        usb_poll();
+        int cmd = getchar_timeout_us(0);
+#if USB_MSC_EXPORT
+        // Manutenção: 'u' no console serial exporta o cartão para o PC
+        if (cmd == 'u' || cmd == 'U') {
+            printf("[RFID] Pedido de exportacao USB recebido.\n");
+            drain_door_queues();
+            set_next_mode(SYSTEM_MODE_USB_EXPORT);
+            trigger_watchdog_reset();
+        }
+#endif
+        // Manutenção: 'p' grava os cartões da lista alunos.csv do SD
+        if (cmd == 'p' || cmd == 'P') {
+            printf("[RFID] Pedido de provisionamento recebido.\n");
+            drain_door_queues();
+            set_next_mode(SYSTEM_MODE_PROVISION);
+            trigger_watchdog_reset();
+        }
+        // Calibração de RF: 'c' com um cartão de referência apoiado no leitor
+        // da porta dianteira (o perfil salvo vale para todas as portas)
+        if (cmd == 'c' || cmd == 'C') {
+            display_message_with_led("Calibrando RF", "Nao mova o cartao", LED_RFID, true, 0);
+            while (Cd_WaitForSlot() != mfrc) {
+                Cd_EndSlot(false);
+            }
+            bool calibrado = Rft_Calibrate(mfrc, RFT_CAL_TRIALS, &perfil_rf);
+            Cd_EndSlot(calibrado);
+            if (calibrado) {
+                spi_manager_activate_sd();
+                bool salvo = Sdh_SaveBlob(RFT_PROFILE_FILE, &perfil_rf, sizeof perfil_rf);
+                spi_manager_activate_rfid();
+                display_message_with_led("Calibracao OK", salvo ? "Perfil salvo" : "Falha ao salvar",
+                                         salvo ? LED_RFID : LED_ERROR, true, 2000);
+            } else {
+                display_message_with_led("Calibracao", "sem cartao", LED_ERROR, true, 2000);
+            }
+            display_message_with_led("RFID Pronto", "Aproxime cartao...", LED_RFID, true, 0);
+        }
+
         uint32_t current_time = to_ms_since_boot(get_absolute_time());
         
         // LED piscando para indicar que está aguardando
@@ -941,108 +1382,96 @@ void execute_rfid_sd_mode_new(void) {
             gpio_put(LED_RFID, led_state);
         }
         
-        // Verifica se há cartão presente
-        if (PICC_IsNewCardPresent(mfrc) && PICC_ReadCardSerial(mfrc)) {
-            printf("[RFID] Cartão RFID detectado! UID: ");
-            for (int i = 0; i < mfrc->uid.size; i++) {
-                printf("%02X", mfrc->uid.uidByte[i]);
+        // Inventário: todos os cartões no campo de uma vez (irmãos passando
+        // juntos, carteira com dois cartões), sem pedir para aproximar de novo
+        // A janela de detecção substitui o antigo sleep_ms(500) fixo: campo
+        // ligado só em sondas curtas quando ocioso, polling rápido após
+        // embarques. As janelas das portas se alternam no SPI0
+        MFRC522Ptr_t leitor = Cd_WaitForSlot();
+        rfid_door_t *porta = door_of(leitor);
+        Uid cartoes[RFID_MAX_CARDS_PER_TAP];
+        uint8_t n_cartoes = PICC_Inventory(leitor, cartoes, RFID_MAX_CARDS_PER_TAP);
+        if (n_cartoes > 1) {
+            printf("[RFID] Porta %s: %u cartoes no campo.\n", porta->nome, n_cartoes);
+        }
+        uint8_t novos = 0;
+        for (uint8_t c = 0; c < n_cartoes; c++) {
+            // Cartão apoiado no leitor: o campo desligou e religou depois do
+            // embarque, e ele respondeu de novo. Só volta a ser lido depois
+            // de faltar numa janela, com ou sem a janela do recent_taps
+            if (Cd_IsPresent(&cartoes[c])) {
+                continue;
             }
-            printf("\n");
-            
-            // LED fixo quando detecta cartão
-            display_message_with_led("Cartao detectado!", "Lendo dados...", LED_RFID, true, 0);
-            
-            // Estrutura para dados de estudante
-            StudentDataBlock student_data;
-            bool dados_validos = false;
-            
-            // Tenta ler dados estruturados
-            if (Tdh_ReadStudentData(mfrc, &student_data, 4, NULL) == STATUS_OK) {
-                printf("[RFID] Dados do estudante lidos:\n");
-                printf("  ID: %u\n", student_data.fields.student_id);
-                printf("  Nome: %s\n", student_data.fields.student_name);
-                printf("  Viagens: %u\n", student_data.fields.trip_count);
-                
-                display_message_with_led("Estudante:", student_data.fields.student_name, LED_RFID, true, 2000);
-                
-                // Prepara dados para salvar com informações expandidas
-                char rfid_info[256];
-                snprintf(rfid_info, sizeof(rfid_info), "NAME:%s,ID:%u,TRIPS:%u,ROUTE:1", 
-                         student_data.fields.student_name, 
-                         student_data.fields.student_id,
-                         student_data.fields.trip_count);
-                
-                dados_validos = true;
-                
-                // Ativa SD e salva dados
-                display_message_with_led("Salvando no", "SD Card...", LED_RFID, true, 0);
-                spi_manager_activate_sd();
-                if (!Sdh_Init()) {
-                    printf("[RFID] ERRO: Falha ao inicializar SD Card\n");
-                    display_message_with_led("ERRO SD!", "Falha ao salvar", LED_ERROR, true, 2000);
-                } else if (save_rfid_data_to_sd(rfid_info)) {
-                    printf("[RFID] Dados salvos com sucesso no SD\n");
-                    display_message_with_led("Sucesso!", "Dados salvos", LED_RFID, true, 2000);
-                    tags_lidas++;
-                    tag_processada = true;
-                } else {
-                    printf("[RFID] Erro ao salvar dados no SD\n");
-                    display_message_with_led("ERRO!", "Falha ao salvar", LED_ERROR, true, 2000);
-                }
-                
-            } else {
-                printf("[RFID] Cartão sem dados estruturados. Salvando UID...\n");
-                display_message_with_led("Cartao vazio", "Salvando UID...", LED_RFID, true, 1000);
-                
-                // Salva apenas UID
-                char uid_info[128];
-                snprintf(uid_info, sizeof(uid_info), "UID:");
-                for (int i = 0; i < mfrc->uid.size; i++) {
-                    char hex[4];
-                    snprintf(hex, sizeof(hex), "%02X", mfrc->uid.uidByte[i]);
-                    strcat(uid_info, hex);
-                }
-                strcat(uid_info, ",TYPE:UNKNOWN");
-                
-                // Ativa SD e salva dados
-                spi_manager_activate_sd();
-                if (!Sdh_Init()) {
-                    printf("[RFID] ERRO: Falha ao inicializar SD Card para UID\n");
-                    display_message_with_led("ERRO SD!", "Falha UID", LED_ERROR, true, 2000);
-                } else if (save_rfid_data_to_sd(uid_info)) {
-                    printf("[RFID] UID salvo com sucesso no SD\n");
-                    display_message_with_led("UID salvo!", "Sucesso", LED_RFID, true, 2000);
-                    tags_lidas++;
-                    tag_processada = true;
-                } else {
-                    printf("[RFID] Erro ao salvar UID no SD\n");
-                    display_message_with_led("ERRO!", "Falha UID", LED_ERROR, true, 2000);
+            novos++;
+            // Toque repetido (o aluno não viu a confirmação): basta o UID do
+            // inventário, o cartão continua em HALT
+            if (Rtp_IsRecent(&cartoes[c])) {
+                printf("[RFID] Porta %s: cartao ja embarcou, toque ignorado.\n", porta->nome);
+                display_message_with_led("Ja embarcou", "Pode passar", LED_RFID, true, 0);
+                Cd_MarkPresent(&cartoes[c]);
+                continue;
+            }
+            roster_record_t aluno;
+            bool no_cadastro;
+            if (!route_gate(porta, &cartoes[c], &aluno, &no_cadastro)) {
+                Cd_MarkPresent(&cartoes[c]);
+                continue;
+            }
+#if RFID_UID_ONLY_BOARDING
+            if (no_cadastro || lookup_roster(&cartoes[c], &aluno) == ROS_FOUND) {
+                if (board_from_roster(porta, &aluno)) {
+                    Rtp_Remember(&cartoes[c]);
+                    Cd_MarkPresent(&cartoes[c]);
                 }
+                continue;
             }
-            
-            // Se processou uma tag com sucesso, sai do loop para enviar
-            if (tag_processada) {
-                printf("[RFID] Tag processada! Preparando para envio...\n");
-                display_message_with_led("Tag processada!", "Preparando envio", LED_WIFI, true, 2000);
-                break;
+#endif
+            // O inventário deixa todos em HALT: acorda e seleciona um por vez.
+            // Quem continua no campo fica em HALT e não é lido de novo, então
+            // não há espera pela retirada do cartão travando a outra porta
+            StatusCode sel = PICC_WakeupAndSelect(leitor, &cartoes[c]);
+            if (sel != STATUS_OK) {
+                Rft_RecordTap(leitor, sel);
+                printf("[RFID] Cartao %u saiu do campo antes da leitura.\n", c + 1);
+                continue;
             }
-            
-            // Aguarda tag ser removida
-            printf("[RFID] Aguarde remover o cartão...\n");
-            display_message_with_led("Remova o cartao", "Aguardando...", LED_RFID, true, 0);
-            while (PICC_IsNewCardPresent(mfrc)) {
-                sleep_ms(100);
-                watchdog_update();
+            if (process_boarding_card(porta)) {
+                Rtp_Remember(&cartoes[c]);
+                Cd_MarkPresent(&cartoes[c]);
             }
-            
-            printf("[RFID] Cartão removido. Aguardando próximo...\n");
-            display_message_with_led("RFID Pronto", "Aproxime cartao...", LED_RFID, true, 0);
+            PICC_HaltA(leitor);
+        }
+        // Cartão parado no leitor não prende o campo ligado: depois de
+        // CD_ACTIVE_HOLD_MS a porta volta ao modo ocioso
+        Cd_EndSlot(novos > 0);
+
+        // Janela sem cartão novo em uma porta: bom momento para gravar as filas
+        if (!novos) {
+            tags_lidas += drain_door_queues();
+        }
+
+        // Embarques gravados e nenhuma porta em modo ativo: a parada acabou,
+        // sai do loop para enviar
+        cd_stats_t cd;
+        Cd_GetStats(&cd);
+        if (tags_lidas && !door_queues_pending() && !cd.active) {
+            printf("[RFID] Tag processada! Preparando para envio...\n");
+            display_message_with_led("Tag processada!", "Preparando envio", LED_WIFI, true, 2000);
+            break;
         }
-        
-        sleep_ms(500);
     }
+    tags_lidas += drain_door_queues();
+    bool tag_processada = tags_lidas > 0;
     
     printf("[RFID] Ciclo de leitura finalizado. Tags lidas: %lu\n", tags_lidas);
+    // Custo do repouso do SD no ciclo: o primeiro acesso depois dele espera
+    // a retomada
+    sdh_wake_stats_t sd_wake;
+    Sdh_GetWakeStats(&sd_wake);
+    if (sd_wake.count) {
+        printf("[RFID] SD: %lu retomadas do repouso, ultima em %lu us, max %lu us\n",
+               (unsigned long)sd_wake.count, (unsigned long)sd_wake.last_us, (unsigned long)sd_wake.max_us);
+    }
     
     // Se processou alguma tag, vai para envio WiFi
     if (tag_processada) {
@@ -1056,10 +1485,268 @@ void execute_rfid_sd_mode_new(void) {
         set_next_mode(SYSTEM_MODE_RFID_SD);  // Continua no modo principal
     }
     
+    // Leitores em soft power-down até a próxima sessão RFID (registradores
+    // preservados para a partida a quente)
+    spi_manager_activate_rfid();
+    for (uint8_t p = 0; p < RFID_READER_COUNT; p++) {
+        if (portas[p].mfrc) PCD_SoftPowerDown(portas[p].mfrc);
+    }
+    
     // Desliga LEDs antes do reset
     gpio_put(LED_RFID, 0);
     gpio_put(LED_WIFI, 0);
     gpio_put(LED_ERROR, 0);
     
     trigger_watchdog_reset();
-}
\ No newline at end of file
+}
+
+#if USB_MSC_EXPORT
+/**
+ * @brief Modo de manutenção: exporta o cartão SD como pendrive (USB MSC)
+ * até o PC ejetar a unidade ou 'q' ser digitado no console.
+ */
+void execute_usb_export_mode(void) {
+    printf("[USB] === EXECUTANDO MODO DE EXPORTACAO USB ===\n");
+    set_system_status_leds(SYSTEM_MODE_USB_EXPORT);
+    watchdog_enable(WATCHDOG_TIMEOUT_MS, 1);
+
+    // Desmonta o FatFs; a partir daqui só o PC acessa o cartão
+    if (!Msc_Export()) {
+        printf("[USB] ERRO: Falha ao exportar o SD Card\n");
+        display_message_with_led("ERRO SD!", "Falha exportar", LED_ERROR, true, 2000);
+        set_next_mode(SYSTEM_MODE_RFID_SD);
+        trigger_watchdog_reset();
+        return;
+    }
+    display_message_with_led("Modo USB", "Copie o diario", LED_WIFI, true, 0);
+    printf("[USB] Cartao disponivel no PC. Ejete a unidade (ou digite 'q') para sair.\n");
+
+    uint32_t last_update = to_ms_since_boot(get_absolute_time());
+    bool led_state = true;
+
+    // Os acessos do PC são atendidos aqui, no tud_task(): os callbacks MSC
+    // leem e gravam o cartão em contexto de thread
+    while (!Msc_IsEjected()) {
+        usb_poll();
+        watchdog_update();
+        if (getchar_timeout_us(0) == 'q') break;
+
+        uint32_t current_time = to_ms_since_boot(get_absolute_time());
+        if (current_time - last_update >= 1000) {
+            last_update = current_time;
+            led_state = !led_state;
+
+            msc_stats_t stats;
+            Msc_GetStats(&stats);
+            char msg[32];
+            snprintf(msg, sizeof(msg), "Lidos: %lu KB", (unsigned long)(stats.blocks_read / 2));
+            display_message_with_led("Modo USB", msg, LED_WIFI, led_state, 0);
+        }
+    }
+
+    // Remonta para confirmar que o volume continua íntegro após o PC
+    if (!Msc_Release()) {
+        printf("[USB] AVISO: Falha ao remontar o SD apos a exportacao\n");
+        display_message_with_led("AVISO SD!", "Verifique cartao", LED_ERROR, true, 2000);
+    } else {
+        display_message_with_led("USB encerrado", "Voltando RFID", LED_RFID, true, 2000);
+    }
+
+    gpio_put(LED_RFID, 0);
+    gpio_put(LED_WIFI, 0);
+    gpio_put(LED_ERROR, 0);
+
+    set_next_mode(SYSTEM_MODE_RFID_SD);
+    trigger_watchdog_reset();
+}
+#endif
+
+// Resultados do provisionamento à espera do SD
+static char provision_log[PROVISION_LOG_BATCH][PROVISION_LOG_LEN];
+static uint8_t provision_log_n = 0;
+
+/**
+ * @brief Acrescenta os resultados acumulados a PROVISION_LOG_FILE numa única
+ * troca do SPI0 para o SD.
+ */
+static bool flush_provision_log(void) {
+    if (!provision_log_n) return true;
+    spi_manager_activate_sd();
+    FIL fil;
+    bool ok = Sdh_Init() && f_open(&fil, PROVISION_LOG_FILE, FA_OPEN_APPEND | FA_WRITE) == FR_OK;
+    if (ok) {
+        for (uint8_t i = 0; i < provision_log_n && ok; i++) {
+            UINT bw = 0;
+            UINT len = (UINT)strlen(provision_log[i]);
+            ok = f_write(&fil, provision_log[i], len, &bw) == FR_OK && bw == len;
+        }
+        ok = f_close(&fil) == FR_OK && ok;
+    }
+    spi_manager_activate_rfid();
+    if (!ok) {
+        printf("[PROV] ERRO: Falha ao gravar %s\n", PROVISION_LOG_FILE);
+        display_message_with_led("ERRO SD!", "Falha no log", LED_ERROR, true, 0);
+        return false;
+    }
+    provision_log_n = 0;
+    return true;
+}
+
+// Linha no formato do csv do cadastro; falhas entram como comentário
+static void log_provision(const prv_entry_t *aluno, const Uid *uid, StatusCode status) {
+    if (provision_log_n == PROVISION_LOG_BATCH && !flush_provision_log()) {
+        provision_log_n--;  // SD com falha: perde o resultado mais antigo da fila
+        memmove(provision_log[0], provision_log[1], sizeof provision_log - sizeof provision_log[0]);
+    }
+    char *linha = provision_log[provision_log_n++];
+    int n = snprintf(linha, PROVISION_LOG_LEN, "%s", status == STATUS_OK ? "" : "# FALHA ");
+    for (uint8_t i = 0; i < uid->size; i++) {
+        n += snprintf(linha + n, PROVISION_LOG_LEN - n, "%02X", uid->uidByte[i]);
+    }
+    n += snprintf(linha + n, PROVISION_LOG_LEN - n, ",%lu,%s",
+                  (unsigned long)aluno->ident.fields.student_id, aluno->ident.fields.student_name);
+    if (status == STATUS_OK) {
+        snprintf(linha + n, PROVISION_LOG_LEN - n, "\n");
+    } else {
+        snprintf(linha + n, PROVISION_LOG_LEN - n, ": %s\n", GetStatusCodeName(status));
+    }
+}
+
+// Lista inteira na RAM, com os registros montados, antes do primeiro cartão
+static bool load_provision_list(void) {
+    FIL fil;
+    char linha[96];  // Linhas maiores seriam recusadas por Prv_AddLine
+    unsigned n_linha = 0;
+
+    spi_manager_activate_sd();
+    if (!Sdh_Init() || f_open(&fil, PROVISION_CSV_FILE, FA_READ) != FR_OK) {
+        printf("[PROV] ERRO: %s nao encontrado no SD\n", PROVISION_CSV_FILE);
+        return false;
+    }
+    // Primeira passada só conta as linhas: a lista ocupa a RAM do lote
+    while (f_gets(linha, sizeof(linha), &fil)) {
+        n_linha++;
+    }
+    if (!Prv_Reset(n_linha) || f_lseek(&fil, 0) != FR_OK) {
+        printf("[PROV] ERRO: sem memoria para a lista de %u linhas\n", n_linha);
+        f_close(&fil);
+        return false;
+    }
+    n_linha = 0;
+    while (f_gets(linha, sizeof(linha), &fil)) {
+        n_linha++;
+        if (!Prv_AddLine(linha)) {
+            printf("[PROV] AVISO: %s:%u ignorada\n", PROVISION_CSV_FILE, n_linha);
+        }
+    }
+    f_close(&fil);
+    printf("[PROV] %lu alunos na lista\n", (unsigned long)Prv_Count());
+    return Prv_Count() > 0;
+}
+
+/**
+ * @brief Modo de manutenção: grava os registros de PROVISION_CSV_FILE nos
+ * cartões apresentados ao leitor dianteiro, um por vez, até todos estarem
+ * gravados, 'q' no console ou PROVISION_IDLE_TIMEOUT_MS sem cartões.
+ */
+void execute_provision_mode(void) {
+    printf("[PROV] === EXECUTANDO MODO DE PROVISIONAMENTO ===\n");
+    set_system_status_leds(SYSTEM_MODE_PROVISION);
+    watchdog_enable(RFID_SD_OPERATION_TIME_MS, 1);
+
+    if (!load_provision_list()) {
+        display_message_with_led("Provisionamento", "Sem alunos.csv", LED_ERROR, true, 3000);
+        set_next_mode(SYSTEM_MODE_RFID_SD);
+        trigger_watchdog_reset();
+        return;
+    }
+    rft_profile_t perfil_rf;
+    if (!Sdh_LoadBlob(RFT_PROFILE_FILE, &perfil_rf, sizeof perfil_rf) ||
+        !Rft_IsValidProfile(&perfil_rf)) {
+        Rft_DefaultProfile(&perfil_rf);
+    }
+
+    // Só o leitor dianteiro; os CS das outras portas ficam em nível alto
+    for (uint8_t p = 1; p < RFID_READER_COUNT; p++) {
+        spi_manager_add_rfid_cs(portas[p].cs);
+    }
+    spi_manager_activate_rfid();
+    MFRC522Ptr_t mfrc = MFRC522_Init();
+    PCD_WarmInit(mfrc, spi0);
+    Rft_Apply(mfrc, &perfil_rf);
+
+    char progresso[24];
+    snprintf(progresso, sizeof(progresso), "0/%lu gravados", (unsigned long)Prv_Count());
+    display_message_with_led("Aproxime cartao", progresso, LED_RFID, true, 0);
+    printf("[PROV] Aproxime os cartoes um por vez ('q' encerra).\n");
+
+    uint32_t falhas = 0;
+    uint32_t ultimo_cartao = to_ms_since_boot(get_absolute_time());
+    while (Prv_Done() < Prv_Count()) {
+        watchdog_update();
+        usb_poll();
+        int cmd = getchar_timeout_us(0);
+        if (cmd == 'q' || cmd == 'Q') break;
+        if (to_ms_since_boot(get_absolute_time()) - ultimo_cartao > PROVISION_IDLE_TIMEOUT_MS) {
+            printf("[PROV] Nenhum cartao ha %u min, encerrando.\n", PROVISION_IDLE_TIMEOUT_MS / 60000);
+            break;
+        }
+
+        // Cartão gravado fica em HALT e não é visto de novo até ser retirado
+        Uid cartoes[2];
+        uint8_t n = PICC_Inventory(mfrc, cartoes, 2);
+        if (n == 0) {
+            sleep_ms(10);
+            continue;
+        }
+        ultimo_cartao = to_ms_since_boot(get_absolute_time());
+        if (n > 1) {
+            // Sem saber qual cartão ficou com qual aluno, nenhum é gravado
+            display_message_with_led("Um cartao", "por vez!", LED_ERROR, true, 0);
+            continue;
+        }
+
+        prv_entry_t *aluno = Prv_Assign(&cartoes[0]);
+        if (!aluno) {
+            display_message_with_led("Fora da lista", "Sem aluno livre", LED_ERROR, true, 0);
+            continue;
+        }
+        if (aluno->state == PRV_DONE) {
+            display_message_with_led("Ja gravado", aluno->ident.fields.student_name, LED_RFID, true, 0);
+            continue;
+        }
+
+        // Registro já montado: seleção e uma única sessão para gravar e conferir
+        StatusCode st = PICC_WakeupAndSelect(mfrc, &cartoes[0]);
+        if (st == STATUS_OK) {
+            st = Tdh_ProvisionAnyCard(mfrc, RFID_RECORD_BLOCK, NULL, NULL, &aluno->ident);
+        }
+        PICC_HaltA(mfrc);
+        Prv_Complete(aluno, &cartoes[0], st == STATUS_OK);
+        log_provision(aluno, &cartoes[0], st);
+
+        snprintf(progresso, sizeof(progresso), "%lu/%lu %s", (unsigned long)Prv_Done(),
+                 (unsigned long)Prv_Count(), aluno->ident.fields.student_name);
+        if (st == STATUS_OK) {
+            printf("[PROV] %s (ID %lu) gravado\n", aluno->ident.fields.student_name,
+                   (unsigned long)aluno->ident.fields.student_id);
+            display_message_with_led("Gravado", progresso, LED_RFID, true, 0);
+        } else {
+            falhas++;
+            printf("[PROV] Falha em %s: %s\n", aluno->ident.fields.student_name, GetStatusCodeName(st));
+            display_message_with_led("Falha, repita", progresso, LED_ERROR, true, 0);
+        }
+    }
+
+    flush_provision_log();
+    printf("[PROV] Fim: %lu de %lu gravados, %lu falhas. Resultado em %s\n",
+           (unsigned long)Prv_Done(), (unsigned long)Prv_Count(), (unsigned long)falhas,
+           PROVISION_LOG_FILE);
+    snprintf(progresso, sizeof(progresso), "%lu/%lu gravados", (unsigned long)Prv_Done(),
+             (unsigned long)Prv_Count());
+    display_message_with_led("Fim do lote", progresso, LED_RFID, true, 3000);
+
+    PCD_SoftPowerDown(mfrc);
+    set_next_mode(SYSTEM_MODE_RFID_SD);
+    trigger_watchdog_reset();
+}